@@ -22,13 +22,16 @@
 #pragma warning (disable: 4996 4312)  // disable deprecation warnings
 #endif
 
+#include "allegro/file.h" // file_time
 #include "ac/common.h" // quit
 #include "ac/gamestructdefines.h"
 #include "ac/spritecache.h"
 #include "core/assetmanager.h"
+#include "debug/frametiming.h"
 #include "debug/out.h"
 #include "gfx/bitmap.h"
 #include "util/compress.h"
+#include "util/decodedcache.h"
 #include "util/file.h"
 #include "util/stream.h"
 
@@ -424,6 +427,7 @@ void SpriteCache::SeekToSprite(sprkey_t index)
 
 size_t SpriteCache::LoadSprite(sprkey_t index)
 {
+    FrameStageTimer timer(kFrameStage_SpriteLoad);
     int hh = 0;
 
     while (_cacheSize > _maxCacheSize)
@@ -753,6 +757,31 @@ int SpriteCache::SaveSpriteIndex(const char *filename, const SpriteFileIndex &in
     return 0;
 }
 
+// The sprite file is too big to hash every time, so its key is made of its
+// size and position, the time and size of the file it is stored in, which
+// change whenever the game is rebuilt, and the pieces spread over the file
+static uint64_t MakeSpriteFileKey(Stream *in, const char *filename, soff_t spr_initial_offs, int file_id, sprkey_t topmost)
+{
+    int64_t file_mtime = 0, file_size = 0;
+    AssetLocation loc;
+    if (AssetManager::GetAssetLocation(filename, loc))
+    {
+        file_mtime = file_time(loc.FileName.GetCStr());
+        file_size = File::GetFileSize(loc.FileName);
+    }
+    const int64_t header[] = { spr_initial_offs, in->GetLength(), file_id, topmost, file_mtime, file_size };
+    uint64_t file_key = DecodedCache::Hash(header, sizeof(header));
+    const int num_pieces = 64;
+    uint8_t piece[256];
+    const soff_t range = in->GetLength() - spr_initial_offs - (soff_t)sizeof(piece);
+    for (int i = 0; i <= num_pieces; ++i)
+    {
+        in->Seek(spr_initial_offs + (range > 0 ? range * i / num_pieces : 0), kSeekBegin);
+        file_key = DecodedCache::Hash(piece, in->Read(piece, sizeof(piece)), file_key);
+    }
+    return file_key;
+}
+
 HError SpriteCache::InitFile(const char *filename, const char *sprindex_filename)
 {
     SpriteFileVersion vers;
@@ -821,13 +850,33 @@ HError SpriteCache::InitFile(const char *filename, const char *sprindex_filename
         return HError::None();
     }
 
+    // the index which was built on the previous run may be in the cache
+    uint64_t cache_key = 0;
+    if (DecodedCache::IsEnabled())
+    {
+        const soff_t data_start = _stream->GetPosition();
+        cache_key = MakeSpriteFileKey(_stream.get(), filename, spr_initial_offs, spriteFileID, topmost);
+        if (LoadCachedSpriteIndex(cache_key, spr_initial_offs, topmost))
+            return HError::None();
+        _stream->Seek(data_start, kSeekBegin);
+    }
+
     // Failed, index file is invalid; index sprites manually
-    return RebuildSpriteIndex(_stream.get(), topmost, vers);
+    SpriteFileIndex index;
+    HError err = RebuildSpriteIndex(_stream.get(), topmost, vers, spr_initial_offs, index);
+    if (err && DecodedCache::IsEnabled() && index.SpriteCount > 0)
+        SaveCachedSpriteIndex(cache_key, index);
+    return err;
 }
 
-HError SpriteCache::RebuildSpriteIndex(AGS::Common::Stream *in, sprkey_t topmost, SpriteFileVersion vers)
+HError SpriteCache::RebuildSpriteIndex(AGS::Common::Stream *in, sprkey_t topmost, SpriteFileVersion vers,
+                                       soff_t spr_initial_offs, SpriteFileIndex &index)
 {
-    for (sprkey_t i = 0; i <= topmost; ++i)
+    index.Widths.assign(topmost + 1, 0);
+    index.Heights.assign(topmost + 1, 0);
+    index.Offsets.assign(topmost + 1, 0);
+    sprkey_t i = 0;
+    for (; i <= topmost; ++i)
     {
         _spriteData[i].Offset = in->GetPosition();
         _spriteData[i].Flags = 0;
@@ -859,6 +908,9 @@ HError SpriteCache::RebuildSpriteIndex(AGS::Common::Stream *in, sprkey_t topmost
         _sprInfos[i].Width = wdd;
         _sprInfos[i].Height = htt;
         get_new_size_for_sprite(i, wdd, htt, _sprInfos[i].Width, _sprInfos[i].Height);
+        index.Widths[i] = wdd;
+        index.Heights[i] = htt;
+        index.Offsets[i] = _spriteData[i].Offset - spr_initial_offs;
 
         size_t spriteDataSize;
         if (vers == kSprfVersion_Compressed)
@@ -875,9 +927,76 @@ HError SpriteCache::RebuildSpriteIndex(AGS::Common::Stream *in, sprkey_t topmost
         }
         in->Seek(spriteDataSize);
     }
+    // only the complete index is good for the cache
+    if (i > topmost)
+    {
+        index.LastSlot = topmost;
+        index.SpriteCount = topmost + 1;
+    }
     return HError::None();
 }
 
+bool SpriteCache::LoadCachedSpriteIndex(uint64_t cache_key, soff_t spr_initial_offs, sprkey_t topmost)
+{
+    // the cached index is the number of sprites, and their widths, heights and offsets
+    CachedData cached;
+    const size_t count = topmost + 1;
+    if (!DecodedCache::Find("sprindex", cache_key, cached) ||
+        cached.Size != sizeof(int32_t) + count * (sizeof(int16_t) * 2 + sizeof(soff_t)))
+        return false;
+    int32_t cached_count;
+    memcpy(&cached_count, cached.Data, sizeof(int32_t));
+    if ((size_t)cached_count != count)
+        return false;
+    SpriteFileIndex index;
+    index.LastSlot = topmost;
+    index.SpriteCount = count;
+    index.Widths.resize(count);
+    index.Heights.resize(count);
+    index.Offsets.resize(count);
+    const uint8_t *data = cached.Data + sizeof(int32_t);
+    memcpy(index.Widths.data(), data, count * sizeof(int16_t));
+    data += count * sizeof(int16_t);
+    memcpy(index.Heights.data(), data, count * sizeof(int16_t));
+    data += count * sizeof(int16_t);
+    memcpy(index.Offsets.data(), data, count * sizeof(soff_t));
+    ApplySpriteIndex(index, spr_initial_offs);
+    return true;
+}
+
+void SpriteCache::SaveCachedSpriteIndex(uint64_t cache_key, const SpriteFileIndex &index)
+{
+    const size_t count = index.SpriteCount;
+    const int32_t cached_count = (int32_t)count;
+    std::vector<uint8_t> data(sizeof(int32_t) + count * (sizeof(int16_t) * 2 + sizeof(soff_t)));
+    uint8_t *p = data.data();
+    memcpy(p, &cached_count, sizeof(int32_t));
+    p += sizeof(int32_t);
+    memcpy(p, index.Widths.data(), count * sizeof(int16_t));
+    p += count * sizeof(int16_t);
+    memcpy(p, index.Heights.data(), count * sizeof(int16_t));
+    p += count * sizeof(int16_t);
+    memcpy(p, index.Offsets.data(), count * sizeof(soff_t));
+    DecodedCache::Store("sprindex", cache_key, data.data(), data.size());
+}
+
+void SpriteCache::ApplySpriteIndex(const SpriteFileIndex &index, soff_t spr_initial_offs)
+{
+    for (sprkey_t i = 0; i < index.SpriteCount; ++i)
+    {
+        if (index.Offsets[i] != 0)
+        {
+            _spriteData[i].Flags = SPRCACHEFLAG_ISASSET;
+            _spriteData[i].Offset = index.Offsets[i] + spr_initial_offs;
+            get_new_size_for_sprite(i, index.Widths[i], index.Heights[i], _sprInfos[i].Width, _sprInfos[i].Height);
+        }
+        else if (i > 0)
+        {
+            InitNullSpriteParams(i);
+        }
+    }
+}
+
 bool SpriteCache::LoadSpriteIndexFile(const char *filename, int expectedFileID, soff_t spr_initial_offs, sprkey_t topmost)
 {
     Stream *fidx = Common::AssetManager::OpenAsset(filename);
@@ -925,40 +1044,26 @@ bool SpriteCache::LoadSpriteIndexFile(const char *filename, int expectedFileID,
         return false;
     }
 
-    sprkey_t numsprits = topmost_index + 1;
-    short *rspritewidths = new short[numsprits];
-    short *rspriteheights = new short[numsprits];
-    soff_t *spriteoffs = new soff_t[numsprits];
+    SpriteFileIndex index;
+    index.LastSlot = topmost_index;
+    index.SpriteCount = topmost_index + 1;
+    index.Widths.resize(index.SpriteCount);
+    index.Heights.resize(index.SpriteCount);
+    index.Offsets.resize(index.SpriteCount);
 
-    fidx->ReadArrayOfInt16(&rspritewidths[0], numsprits);
-    fidx->ReadArrayOfInt16(&rspriteheights[0], numsprits);
+    fidx->ReadArrayOfInt16(index.Widths.data(), index.SpriteCount);
+    fidx->ReadArrayOfInt16(index.Heights.data(), index.SpriteCount);
     if (vers <= kSpridxfVersion_Last32bit)
     {
-        for (sprkey_t i = 0; i < numsprits; ++i)
-            spriteoffs[i] = fidx->ReadInt32();
+        for (sprkey_t i = 0; i < index.SpriteCount; ++i)
+            index.Offsets[i] = fidx->ReadInt32();
     }
     else // large file support
     {
-        fidx->ReadArrayOfInt64(spriteoffs, numsprits);
-    }
-
-    for (sprkey_t i = 0; i <= topmost_index; ++i)
-    {
-        if (spriteoffs[i] != 0)
-        {
-            _spriteData[i].Flags = SPRCACHEFLAG_ISASSET;
-            _spriteData[i].Offset = spriteoffs[i] + spr_initial_offs;
-            get_new_size_for_sprite(i, rspritewidths[i], rspriteheights[i], _sprInfos[i].Width, _sprInfos[i].Height);
-        }
-        else if (i > 0)
-        {
-            InitNullSpriteParams(i);
-        }
+        fidx->ReadArrayOfInt64(index.Offsets.data(), index.SpriteCount);
     }
 
-    delete [] rspritewidths;
-    delete [] rspriteheights;
-    delete [] spriteoffs;
+    ApplySpriteIndex(index, spr_initial_offs);
     delete fidx;
     return true;
 }
@@ -224,8 +224,16 @@ private:
 
     // Loads sprite index file
     bool        LoadSpriteIndexFile(const char *filename, int expectedFileID, soff_t spr_initial_offs, sprkey_t topmost);
-    // Rebuilds sprite index from the main sprite file
-    HAGSError   RebuildSpriteIndex(AGS::Common::Stream *in, sprkey_t topmost, SpriteFileVersion vers);
+    // Rebuilds sprite index from the main sprite file, and fills the index
+    // table; the table is only complete if it has SpriteCount set
+    HAGSError   RebuildSpriteIndex(AGS::Common::Stream *in, sprkey_t topmost, SpriteFileVersion vers,
+                                   soff_t spr_initial_offs, SpriteFileIndex &index);
+    // Loads sprite index, which was rebuilt before, from the decoded data cache
+    bool        LoadCachedSpriteIndex(uint64_t cache_key, soff_t spr_initial_offs, sprkey_t topmost);
+    // Puts the rebuilt sprite index into the decoded data cache
+    void        SaveCachedSpriteIndex(uint64_t cache_key, const SpriteFileIndex &index);
+    // Sets up the sprite slots from the index table
+    void        ApplySpriteIndex(const SpriteFileIndex &index, soff_t spr_initial_offs);
     // Writes compressed sprite to the stream
     void        CompressSprite(Common::Bitmap *sprite, Common::Stream *out);
     // Uncompresses sprite from stream into the given bitmap
@@ -31,6 +31,22 @@ void AssetLibInfo::Unload()
     BaseFilePath = "";
     LibFileNames.clear();
     AssetInfos.clear();
+    AssetIndex.clear();
+}
+
+void AssetLibInfo::BuildIndex()
+{
+    AssetIndex.clear();
+    AssetIndex.reserve(AssetInfos.size());
+    // if the names are duplicated, the first asset is used, like before
+    for (size_t i = 0; i < AssetInfos.size(); ++i)
+        AssetIndex.insert(std::make_pair(AssetInfos[i].FileName, i));
+}
+
+const AssetInfo *AssetLibInfo::FindAsset(const String &filename) const
+{
+    auto it = AssetIndex.find(filename);
+    return it != AssetIndex.end() ? &AssetInfos[it->second] : nullptr;
 }
 
 } // namespace Common
@@ -19,8 +19,9 @@
 #ifndef __AGS_CN_CORE__ASSET_H
 #define __AGS_CN_CORE__ASSET_H
 
+#include <unordered_map>
 #include <vector>
-#include "util/string.h"
+#include "util/string_types.h"
 
 namespace AGS
 {
@@ -50,8 +51,14 @@ struct AssetLibInfo
 
     // Library contents
     AssetVec AssetInfos; // information on contained assets
+    // Case-insensitive index of AssetInfos by file name
+    std::unordered_map<String, size_t, HashStrNoCase, StrEqNoCase> AssetIndex;
 
     void Unload();
+    // Indexes assets by their names; must be called after AssetInfos are filled
+    void BuildIndex();
+    // Finds asset by its file name, case-insensitive; returns null if there's none
+    const AssetInfo *FindAsset(const String &filename) const;
 };
 
 } // namespace Common
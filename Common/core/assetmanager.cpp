@@ -12,7 +12,12 @@
 //
 //=============================================================================
 
+#include <chrono>
 #include "core/assetmanager.h"
+#include "core/asset.h"
+#include "debug/assettrace.h"
+#include "debug/out.h"
+#include "util/memorymappedstream.h"
 #include "util/misc.h" // ci_fopen
 #include "util/multifilelib.h"
 #include "util/path.h"
@@ -51,7 +56,9 @@ AssetManager *AssetManager::_theAssetManager = nullptr;
 
 AssetManager::~AssetManager()
 {
-    delete &_assetLib;
+    if (_lookupCount > 0)
+        Debug::Printf("Asset manager: %u lookups (%u found), average %.3f us; %u library switches, %u libraries read",
+            _lookupCount, _lookupFoundCount, _lookupTimeNs / 1000.0 / _lookupCount, _libSwitchCount, _libReadCount);
 }
 
 /* static */ bool AssetManager::SetSearchPriority(AssetSearchPriority priority)
@@ -85,7 +92,10 @@ AssetError AssetManager::ReadDataFileTOC(const String &data_file, AssetLibInfo &
     {
         MFLUtil::MFLError err = MFLUtil::ReadHeader(lib, in);
         delete in;
-        return (err != MFLUtil::kMFLNoError) ? kAssetErrLibParse : kAssetNoError;
+        if (err != MFLUtil::kMFLNoError)
+            return kAssetErrLibParse;
+        lib.BuildIndex();
+        return kAssetNoError;
     }
     return kAssetErrNoLibFile;
 }
@@ -173,10 +183,16 @@ AssetError AssetManager::ReadDataFileTOC(const String &data_file, AssetLibInfo &
 }
 
 AssetManager::AssetManager()
-    : _assetLib(*new AssetLibInfo())
-    , _searchPriority(kAssetPriorityDir)
+    : _searchPriority(kAssetPriorityDir)
+    , _noLib(new AssetLibInfo())
     , _lastAssetSize(0)
+    , _lookupCount(0)
+    , _lookupFoundCount(0)
+    , _lookupTimeNs(0)
+    , _libReadCount(0)
+    , _libSwitchCount(0)
 {
+    _assetLib = _noLib.get();
 }
 
 bool AssetManager::_SetSearchPriority(AssetSearchPriority priority)
@@ -196,10 +212,20 @@ AssetError AssetManager::_SetDataFile(const String &data_file)
     {
         return kAssetErrNoLibFile;
     }
-    if (Path::ComparePaths(_assetLib.BaseFilePath, data_file) == 0)
+    if (Path::ComparePaths(_assetLib->BaseFilePath, data_file) == 0)
     {
         return kAssetNoError;
     }
+    _libSwitchCount++;
+    for (const RegisteredLib &reg : _libs)
+    {
+        if (Path::ComparePaths(reg.Lib->BaseFilePath, data_file) == 0)
+        {
+            _assetLib = reg.Lib.get();
+            _basePath = reg.BasePath;
+            return kAssetNoError;
+        }
+    }
     AssetError err = RegisterAssetLib(data_file, "");
     return err;
 }
@@ -210,7 +236,7 @@ String AssetManager::_GetLibraryForAsset(const String &asset_name)
     {
         return "";
     }
-    AssetInfo *asset = FindAssetByFileName(asset_name);
+    const AssetInfo *asset = FindAssetByFileName(asset_name);
     if (!asset)
     {
         // asset not found
@@ -226,7 +252,7 @@ soff_t AssetManager::_GetAssetOffset(const String &asset_name)
     {
         return -1;
     }
-    AssetInfo *asset = FindAssetByFileName(asset_name);
+    const AssetInfo *asset = FindAssetByFileName(asset_name);
     if (asset)
     {
         return asset->Offset;
@@ -240,7 +266,7 @@ soff_t AssetManager::_GetAssetSize(const String &asset_name)
     {
         return -1;
     }
-    AssetInfo *asset = FindAssetByFileName(asset_name);
+    const AssetInfo *asset = FindAssetByFileName(asset_name);
     if (asset)
     {
         return asset->Size;
@@ -255,25 +281,25 @@ soff_t AssetManager::_GetLastAssetSize()
 
 int AssetManager::_GetAssetCount()
 {
-    return _assetLib.AssetInfos.size();
+    return _assetLib->AssetInfos.size();
 }
 
 String AssetManager::_GetAssetFileByIndex(int index)
 {
-    if ((index < 0) || ((size_t)index >= _assetLib.AssetInfos.size()))
+    if ((index < 0) || ((size_t)index >= _assetLib->AssetInfos.size()))
         return nullptr;
 
-    return _assetLib.AssetInfos[index].FileName;
+    return _assetLib->AssetInfos[index].FileName;
 }
 
 String AssetManager::_GetLibraryBaseFile()
 {
-    return _assetLib.BaseFileName;
+    return _assetLib->BaseFileName;
 }
 
 const AssetLibInfo &AssetManager::_GetLibraryTOC() const
 {
-    return _assetLib;
+    return *_assetLib;
 }
 
 bool AssetManager::_DoesAssetExist(const String &asset_name)
@@ -294,14 +320,18 @@ AssetError AssetManager::RegisterAssetLib(const String &data_file, const String
 
     // read MultiFileLibrary header (CLIB)
     // PSP: allocate struct on the heap to avoid overflowing the stack.
-    MFLUtil::MFLError mfl_err = MFLUtil::ReadHeader(_assetLib, in);
+    std::unique_ptr<AssetLibInfo> lib(new AssetLibInfo());
+    MFLUtil::MFLError mfl_err = MFLUtil::ReadHeader(*lib, in);
     delete in;
+    _libReadCount++;
 
     if (mfl_err != MFLUtil::kMFLNoError)
     {
-        _assetLib.Unload();
+        _assetLib = _noLib.get();
         return kAssetErrLibParse;
     }
+    lib->BuildIndex();
+    _assetLib = lib.get();
 
     // fixup base library filename
     String nammwas = data_file;
@@ -319,30 +349,63 @@ AssetError AssetManager::RegisterAssetLib(const String &data_file, const String
     }
 
     // set library filename
-    _assetLib.LibFileNames[0] = data_file_fixed;
+    _assetLib->LibFileNames[0] = data_file_fixed;
     // make a lowercase backup of the original file name
-    _assetLib.BaseFileName = data_file_fixed;
-    _assetLib.BaseFileName.MakeLower();
-    _assetLib.BaseFilePath = Path::MakeAbsolutePath(data_file);
+    _assetLib->BaseFileName = data_file_fixed;
+    _assetLib->BaseFileName.MakeLower();
+    _assetLib->BaseFilePath = Path::MakeAbsolutePath(data_file);
+
+    RegisteredLib reg;
+    reg.Lib = std::move(lib);
+    reg.BasePath = _basePath;
+    _libs.push_back(std::move(reg));
+    MapLibraryFiles();
     return kAssetNoError;
 }
 
-AssetInfo *AssetManager::FindAssetByFileName(const String &asset_name)
+void AssetManager::MapLibraryFiles()
 {
-    for (size_t i = 0; i < _assetLib.AssetInfos.size(); ++i)
+    // the 32-bit address space may not fit the whole library, the assets
+    // are mapped one by one when opened there
+    if (sizeof(void*) < 8)
+        return;
+    for (const String &lib_file_name : _assetLib->LibFileNames)
     {
-        if (_assetLib.AssetInfos[i].FileName.CompareNoCase(asset_name) == 0)
+        if (lib_file_name.IsEmpty())
+            continue;
+        String lib_file = cbuf_to_string_and_free( ci_find_file(nullptr,
+            String::FromFormat("%s/%s", _basePath.GetCStr(), lib_file_name.GetCStr())) );
+        if (lib_file.IsEmpty() || _mappedLibFiles.count(lib_file) || _unmappedLibFiles.count(lib_file))
+            continue;
+        std::shared_ptr<MappedFile> file = MappedFile::Map(lib_file);
+        if (file)
+        {
+            _mappedLibFiles[lib_file] = file;
+        }
+        else
         {
-            return &_assetLib.AssetInfos[i];
+            _unmappedLibFiles.insert(lib_file);
+            Debug::Printf(kDbgMsg_Warn, "Asset manager: failed to map library file %s, reading it as a regular file", lib_file.GetCStr());
         }
     }
-    return nullptr;
+}
+
+const AssetInfo *AssetManager::FindAssetByFileName(const String &asset_name)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const AssetInfo *asset = _assetLib->FindAsset(asset_name);
+    _lookupTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    _lookupCount++;
+    if (asset)
+        _lookupFoundCount++;
+    return asset;
 }
 
 String AssetManager::MakeLibraryFileNameForAsset(const AssetInfo *asset)
 {
     // deduce asset library file containing this asset
-    return String::FromFormat("%s/%s",_basePath.GetCStr(), _assetLib.LibFileNames[asset->LibUid].GetCStr());
+    return String::FromFormat("%s/%s",_basePath.GetCStr(), _assetLib->LibFileNames[asset->LibUid].GetCStr());
 }
 
 bool AssetManager::GetAssetFromLib(const String &asset_name, AssetLocation &loc, FileOpenMode open_mode, FileWorkMode work_mode)
@@ -350,7 +413,7 @@ bool AssetManager::GetAssetFromLib(const String &asset_name, AssetLocation &loc,
     if (open_mode != Common::kFile_Open || work_mode != Common::kFile_Read)
         return false; // creating/writing is allowed only for common files on disk
 
-    AssetInfo *asset = FindAssetByFileName(asset_name);
+    const AssetInfo *asset = FindAssetByFileName(asset_name);
     if (!asset)
         return false; // asset not found
 
@@ -374,34 +437,84 @@ bool AssetManager::GetAssetFromDir(const String &file_name, AssetLocation &loc,
     return true;
 }
 
-bool AssetManager::GetAssetByPriority(const String &asset_name, AssetLocation &loc, FileOpenMode open_mode, FileWorkMode work_mode)
+bool AssetManager::GetAssetByPriority(const String &asset_name, AssetLocation &loc, FileOpenMode open_mode, FileWorkMode work_mode,
+                                      bool *from_lib)
 {
+    bool found_in_lib = false;
+    bool found = false;
     if (_searchPriority == kAssetPriorityDir)
     {
         // check for disk, otherwise use datafile
-        return GetAssetFromDir(asset_name, loc, open_mode, work_mode) ||
-            GetAssetFromLib(asset_name, loc, open_mode, work_mode);
+        found = GetAssetFromDir(asset_name, loc, open_mode, work_mode) ||
+            (found_in_lib = GetAssetFromLib(asset_name, loc, open_mode, work_mode));
     }
     else if (_searchPriority == kAssetPriorityLib)
     {
         // check datafile first, then scan directory
-        return GetAssetFromLib(asset_name, loc, open_mode, work_mode) ||
+        found = (found_in_lib = GetAssetFromLib(asset_name, loc, open_mode, work_mode)) ||
             GetAssetFromDir(asset_name, loc, open_mode, work_mode);
     }
-    return false;
+    if (from_lib)
+        *from_lib = found_in_lib;
+    return found;
+}
+
+Stream *AssetManager::OpenMappedAsset(const AssetLocation &loc)
+{
+    if ((loc.Size <= 0) || _unmappedLibFiles.count(loc.FileName))
+        return nullptr;
+    std::shared_ptr<MappedFile> file;
+    auto it = _mappedLibFiles.find(loc.FileName);
+    if (it != _mappedLibFiles.end())
+    {
+        file = it->second;
+    }
+    else if (sizeof(void*) < 8)
+    {
+        // only the asset itself is mapped, because the whole library may not
+        // fit into the address space; the largest assets are read from the file
+        const soff_t max_mapped_asset_size = 256 * 1024 * 1024;
+        if (loc.Size > max_mapped_asset_size)
+            return nullptr;
+        file = MappedFile::Map(loc.FileName, loc.Offset, loc.Size);
+        if (!file)
+        {
+            _unmappedLibFiles.insert(loc.FileName);
+            Debug::Printf(kDbgMsg_Warn, "Asset manager: failed to map library file %s, reading it as a regular file", loc.FileName.GetCStr());
+            return nullptr;
+        }
+    }
+    else
+    {
+        return nullptr;
+    }
+    // small assets are usually read whole right away
+    const soff_t small_asset_size = 1024 * 1024;
+    if (loc.Size <= small_asset_size)
+        file->Advise(loc.Offset, loc.Size, kMappedAccess_WillNeed);
+    return new MemoryMappedStream(file, loc.Offset, loc.Size);
 }
 
 Stream *AssetManager::OpenAssetAsStream(const String &asset_name, FileOpenMode open_mode, FileWorkMode work_mode)
 {
+    const auto start = std::chrono::steady_clock::now();
     AssetLocation loc;
-    if (GetAssetByPriority(asset_name, loc, open_mode, work_mode))
+    bool from_lib = false;
+    if (GetAssetByPriority(asset_name, loc, open_mode, work_mode, &from_lib))
     {
-        Stream *s = File::OpenFile(loc.FileName, open_mode, work_mode);
-        if (s)
+        Stream *s = from_lib ? OpenMappedAsset(loc) : nullptr;
+        if (!s)
         {
-            s->Seek(loc.Offset, kSeekBegin);
-            _lastAssetSize = loc.Size;
+            s = File::OpenFile(loc.FileName, open_mode, work_mode);
+            if (s)
+                s->Seek(loc.Offset, kSeekBegin);
         }
+        if (s)
+            _lastAssetSize = loc.Size;
+        if (s && AssetTrace::IsEnabled())
+            s = AssetTrace::TraceStream(s, asset_name, loc.FileName, loc.Offset,
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count());
         return s;
     }
     return nullptr;
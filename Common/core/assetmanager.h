@@ -34,13 +34,19 @@
 #ifndef __AGS_CN_CORE__ASSETMANAGER_H
 #define __AGS_CN_CORE__ASSETMANAGER_H
 
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "util/file.h" // TODO: extract filestream mode constants or introduce generic ones
+#include "util/string_types.h"
 
 namespace AGS
 {
 namespace Common
 {
 
+class MappedFile;
 class Stream;
 struct MultiFileLib;
 struct AssetLibInfo;
@@ -127,23 +133,51 @@ private:
     soff_t      _GetLastAssetSize();
 
     AssetError  RegisterAssetLib(const String &data_file, const String &password);
+    // Maps the files of the current library into memory, if there's enough address space
+    void        MapLibraryFiles();
 
     bool        _DoesAssetExist(const String &asset_name);
 
-    AssetInfo   *FindAssetByFileName(const String &asset_name);
+    const AssetInfo *FindAssetByFileName(const String &asset_name);
     String      MakeLibraryFileNameForAsset(const AssetInfo *asset);
 
     bool        GetAssetFromLib(const String &asset_name, AssetLocation &loc, Common::FileOpenMode open_mode, Common::FileWorkMode work_mode);
     bool        GetAssetFromDir(const String &asset_name, AssetLocation &loc, Common::FileOpenMode open_mode, Common::FileWorkMode work_mode);
-    bool        GetAssetByPriority(const String &asset_name, AssetLocation &loc, Common::FileOpenMode open_mode, Common::FileWorkMode work_mode);
+    bool        GetAssetByPriority(const String &asset_name, AssetLocation &loc, Common::FileOpenMode open_mode, Common::FileWorkMode work_mode,
+                                   bool *from_lib = nullptr);
     Stream      *OpenAssetAsStream(const String &asset_name, FileOpenMode open_mode, FileWorkMode work_mode);
+    // Opens stream over the asset in the mapped library file, or returns null if it cannot be mapped
+    Stream      *OpenMappedAsset(const AssetLocation &loc);
 
     static AssetManager     *_theAssetManager;
     AssetSearchPriority     _searchPriority;
 
-    AssetLibInfo            &_assetLib;
+    // Library registered earlier; these are kept, so that switching back to
+    // one does not require reading and indexing its contents again
+    struct RegisteredLib
+    {
+        std::unique_ptr<AssetLibInfo> Lib;
+        String BasePath;
+    };
+
+    std::vector<RegisteredLib> _libs;
+    // Library files mapped whole when their library was registered; the
+    // asset streams share these mappings
+    std::unordered_map<String, std::shared_ptr<MappedFile>> _mappedLibFiles;
+    // Library files which failed to map into memory, and are read as the
+    // regular files instead
+    std::unordered_set<String> _unmappedLibFiles;
+    std::unique_ptr<AssetLibInfo> _noLib;       // used when no library is set
+    AssetLibInfo            *_assetLib;         // current library
     String                  _basePath;          // library's parent path (directory)
     soff_t                  _lastAssetSize;     // size of asset that was opened last time
+
+    // Asset lookup statistics
+    uint32_t                _lookupCount;
+    uint32_t                _lookupFoundCount;
+    int64_t                 _lookupTimeNs;
+    uint32_t                _libReadCount;
+    uint32_t                _libSwitchCount;
 };
 
 } // namespace Common
@@ -0,0 +1,496 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "debug/assettrace.h"
+#include "util/file.h"
+#include "util/proxystream.h"
+#include "util/textstreamwriter.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+namespace AssetTrace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+// Reads and seeks made through the stream while in one room
+struct IOUsage
+{
+    int      Room = 0;
+    uint32_t FirstLoop = 0;
+    uint32_t LastLoop = 0;
+    uint64_t Reads = 0;
+    uint64_t Bytes = 0;
+    uint64_t Seeks = 0;
+    int64_t  IoUs = 0;
+};
+
+// Single asset open; usage is added by the thread using the stream, and may
+// be read by the report at any time, so it is guarded by the mutex
+struct OpenRecord
+{
+    String   AssetName;
+    String   FileName;
+    soff_t   Offset = 0;
+    int      Room = 0;
+    uint32_t Loop = 0;
+    bool     Background = false;
+    // the reads are not counted
+    bool     Untraced = false;
+    int64_t  OpenUs = 0;
+    std::mutex Mutex;
+    std::vector<IOUsage> Usage;
+};
+
+static std::atomic<bool> Enabled(false);
+static std::thread::id   MainThread;
+static std::atomic<int>  CurRoom(-1);
+static std::atomic<uint32_t> CurLoop(0);
+static std::mutex        RecordsMutex;
+static std::vector<std::shared_ptr<OpenRecord>> Records;
+
+class TracedStream : public ProxyStream
+{
+public:
+    TracedStream(Stream *stream, std::shared_ptr<OpenRecord> rec)
+        : ProxyStream(stream, kDisposeAfterUse)
+        , _rec(rec)
+    {
+    }
+
+    size_t Read(void *buffer, size_t size) override
+    {
+        const Clock::time_point t0 = Clock::now();
+        size_t read = ProxyStream::Read(buffer, size);
+        AddRead(t0, read);
+        return read;
+    }
+
+    int32_t ReadByte() override
+    {
+        const Clock::time_point t0 = Clock::now();
+        int32_t b = ProxyStream::ReadByte();
+        AddRead(t0, b >= 0 ? 1 : 0);
+        return b;
+    }
+
+    int16_t ReadInt16() override
+    {
+        const Clock::time_point t0 = Clock::now();
+        int16_t val = ProxyStream::ReadInt16();
+        AddRead(t0, sizeof(val));
+        return val;
+    }
+
+    int32_t ReadInt32() override
+    {
+        const Clock::time_point t0 = Clock::now();
+        int32_t val = ProxyStream::ReadInt32();
+        AddRead(t0, sizeof(val));
+        return val;
+    }
+
+    int64_t ReadInt64() override
+    {
+        const Clock::time_point t0 = Clock::now();
+        int64_t val = ProxyStream::ReadInt64();
+        AddRead(t0, sizeof(val));
+        return val;
+    }
+
+    size_t ReadArray(void *buffer, size_t elem_size, size_t count) override
+    {
+        const Clock::time_point t0 = Clock::now();
+        size_t read = ProxyStream::ReadArray(buffer, elem_size, count);
+        AddRead(t0, read * elem_size);
+        return read;
+    }
+
+    size_t ReadArrayOfInt16(int16_t *buffer, size_t count) override
+    {
+        const Clock::time_point t0 = Clock::now();
+        size_t read = ProxyStream::ReadArrayOfInt16(buffer, count);
+        AddRead(t0, read * sizeof(int16_t));
+        return read;
+    }
+
+    size_t ReadArrayOfInt32(int32_t *buffer, size_t count) override
+    {
+        const Clock::time_point t0 = Clock::now();
+        size_t read = ProxyStream::ReadArrayOfInt32(buffer, count);
+        AddRead(t0, read * sizeof(int32_t));
+        return read;
+    }
+
+    size_t ReadArrayOfInt64(int64_t *buffer, size_t count) override
+    {
+        const Clock::time_point t0 = Clock::now();
+        size_t read = ProxyStream::ReadArrayOfInt64(buffer, count);
+        AddRead(t0, read * sizeof(int64_t));
+        return read;
+    }
+
+    bool Seek(soff_t offset, StreamSeek origin) override
+    {
+        const Clock::time_point t0 = Clock::now();
+        bool res = ProxyStream::Seek(offset, origin);
+        AddIO(t0, 0, 0, 1);
+        return res;
+    }
+
+private:
+    static inline int64_t ElapsedUs(const Clock::time_point &t0)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+    }
+
+    inline void AddRead(const Clock::time_point &t0, size_t bytes)
+    {
+        AddIO(t0, 1, bytes, 0);
+    }
+
+    // Adds to the usage in the current room, starting the new one if the
+    // room has changed since the last call
+    void AddIO(const Clock::time_point &t0, uint64_t reads, uint64_t bytes, uint64_t seeks)
+    {
+        const int64_t us = ElapsedUs(t0);
+        const int room = CurRoom.load(std::memory_order_relaxed);
+        const uint32_t loop = CurLoop.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lk(_rec->Mutex);
+        if (_rec->Usage.empty() || _rec->Usage.back().Room != room)
+        {
+            IOUsage usage;
+            usage.Room = room;
+            usage.FirstLoop = loop;
+            _rec->Usage.push_back(usage);
+        }
+        IOUsage &usage = _rec->Usage.back();
+        usage.LastLoop = loop;
+        usage.Reads += reads;
+        usage.Bytes += bytes;
+        usage.Seeks += seeks;
+        usage.IoUs += us;
+    }
+
+    std::shared_ptr<OpenRecord> _rec;
+};
+
+void Enable()
+{
+    Disable();
+    MainThread = std::this_thread::get_id();
+    Enabled = true;
+}
+
+void Disable()
+{
+    Enabled = false;
+    std::lock_guard<std::mutex> lk(RecordsMutex);
+    // the streams which are still open keep their records to themselves
+    Records.clear();
+    Records.shrink_to_fit();
+}
+
+bool IsEnabled()
+{
+    return Enabled.load(std::memory_order_relaxed);
+}
+
+void SetRoom(int room)
+{
+    CurRoom = room;
+}
+
+void SetLoop(uint32_t loop)
+{
+    CurLoop.store(loop, std::memory_order_relaxed);
+}
+
+static std::shared_ptr<OpenRecord> AddOpenRecord(const String &asset_name, const String &filename,
+    soff_t offset, int64_t open_us, bool untraced)
+{
+    std::shared_ptr<OpenRecord> rec(new OpenRecord());
+    rec->AssetName = asset_name;
+    rec->FileName = filename;
+    rec->Offset = offset;
+    rec->Room = CurRoom;
+    rec->Loop = CurLoop.load(std::memory_order_relaxed);
+    rec->Background = std::this_thread::get_id() != MainThread;
+    rec->Untraced = untraced;
+    rec->OpenUs = open_us;
+    std::lock_guard<std::mutex> lk(RecordsMutex);
+    Records.push_back(rec);
+    return rec;
+}
+
+Stream *TraceStream(Stream *s, const String &asset_name, const String &filename,
+    soff_t offset, int64_t open_us)
+{
+    if (!s || !IsEnabled())
+        return s;
+    return new TracedStream(s, AddOpenRecord(asset_name, filename, offset, open_us, false));
+}
+
+void TraceOpen(const String &asset_name, const String &filename, soff_t offset, int64_t open_us)
+{
+    if (!IsEnabled())
+        return;
+    AddOpenRecord(asset_name, filename, offset, open_us, true);
+}
+
+// Sums of the records of a single asset, or of a room and kind of assets
+struct IOTotals
+{
+    uint32_t Opens = 0;
+    uint32_t BgOpens = 0;
+    uint64_t Reads = 0;
+    uint64_t Bytes = 0;
+    uint64_t Seeks = 0;
+    int64_t  OpenUs = 0;
+    int64_t  IoUs = 0;
+
+    inline int64_t TotalUs() const { return OpenUs + IoUs; }
+
+    void AddOpen(const OpenRecord &rec)
+    {
+        Opens++;
+        BgOpens += rec.Background ? 1 : 0;
+        OpenUs += rec.OpenUs;
+    }
+
+    void Add(const IOUsage &usage)
+    {
+        Reads += usage.Reads;
+        Bytes += usage.Bytes;
+        Seeks += usage.Seeks;
+        IoUs += usage.IoUs;
+    }
+
+    void Add(const IOTotals &t)
+    {
+        Opens += t.Opens;
+        BgOpens += t.BgOpens;
+        Reads += t.Reads;
+        Bytes += t.Bytes;
+        Seeks += t.Seeks;
+        OpenUs += t.OpenUs;
+        IoUs += t.IoUs;
+    }
+};
+
+// Kind of asset is told by its file extension
+static String GetAssetKind(const String &asset_name)
+{
+    size_t dot = asset_name.FindCharReverse('.');
+    if (dot == -1 || dot + 1 == asset_name.GetLength())
+        return "-";
+    String ext = asset_name.Mid(dot + 1);
+    ext.MakeLower();
+    return ext;
+}
+
+static String GetRoomName(int room)
+{
+    return room >= 0 ? String::FromFormat("%d", room) : String("none");
+}
+
+static inline double ToMs(int64_t us)
+{
+    return us / 1000.0;
+}
+
+static inline double ToKB(uint64_t bytes)
+{
+    return bytes / 1024.0;
+}
+
+// Picks the character for the value, from blank to the densest one for max
+static char GetHeatChar(int64_t value, int64_t max_value)
+{
+    static const char HeatChars[] = " .:-=+*#%@";
+    const int levels = sizeof(HeatChars) - 1;
+    if (value <= 0 || max_value <= 0)
+        return HeatChars[0];
+    int level = 1 + (int)((value * (levels - 1)) / max_value);
+    return HeatChars[std::min(level, levels - 1)];
+}
+
+bool WriteReport(const String &filename)
+{
+    if (!IsEnabled())
+        return false;
+    TextStreamWriter writer(File::CreateFile(filename));
+    if (!writer.IsValid())
+        return false;
+
+    const size_t max_assets = 40;
+    const size_t max_kinds = 8;
+    std::map<String, IOTotals> assets;
+    std::map<String, IOTotals> kinds;
+    std::map<int, std::map<String, IOTotals>> rooms;
+    std::set<String> untraced;
+    IOTotals total;
+    {
+        std::lock_guard<std::mutex> lk(RecordsMutex);
+        for (const auto &rec : Records)
+        {
+            const String kind = GetAssetKind(rec->AssetName);
+            assets[rec->AssetName].AddOpen(*rec);
+            kinds[kind].AddOpen(*rec);
+            rooms[rec->Room][kind].AddOpen(*rec);
+            total.AddOpen(*rec);
+            if (rec->Untraced)
+                untraced.insert(rec->AssetName);
+            // reads are counted in the rooms they were made in
+            std::lock_guard<std::mutex> rec_lk(rec->Mutex);
+            for (const IOUsage &usage : rec->Usage)
+            {
+                assets[rec->AssetName].Add(usage);
+                kinds[kind].Add(usage);
+                rooms[usage.Room][kind].Add(usage);
+                total.Add(usage);
+            }
+        }
+    }
+
+    writer.WriteFormat("Asset I/O: %u opens (%u in background), %.1f KB read in %llu reads, %llu seeks\n",
+        total.Opens, total.BgOpens, ToKB(total.Bytes), (unsigned long long)total.Reads, (unsigned long long)total.Seeks);
+    writer.WriteFormat("Time spent: %.1f ms opening, %.1f ms reading and seeking\n\n",
+        ToMs(total.OpenUs), ToMs(total.IoUs));
+
+    // Top assets by total time
+    std::vector<std::pair<String, IOTotals>> top(assets.begin(), assets.end());
+    std::sort(top.begin(), top.end(),
+        [](const std::pair<String, IOTotals> &a, const std::pair<String, IOTotals> &b)
+        { return a.second.TotalUs() > b.second.TotalUs(); });
+    if (top.size() > max_assets)
+        top.resize(max_assets);
+    writer.WriteFormat("Top %u assets by I/O time\n", (unsigned)top.size());
+    writer.WriteFormat("%-32s %7s %7s %12s %9s %7s %10s %10s\n",
+        "asset", "opens", "bg", "KB read", "reads", "seeks", "open ms", "io ms");
+    for (const auto &a : top)
+    {
+        const IOTotals &t = a.second;
+        writer.WriteFormat("%-32s %7u %7u %12.1f %9llu %7llu %10.2f %10.2f%s\n",
+            a.first.GetCStr(), t.Opens, t.BgOpens, ToKB(t.Bytes), (unsigned long long)t.Reads,
+            (unsigned long long)t.Seeks, ToMs(t.OpenUs), ToMs(t.IoUs), untraced.count(a.first) ? " *" : "");
+    }
+    if (!untraced.empty())
+        writer.WriteFormat("* opened as PACKFILE at least once, those reads are not counted\n");
+
+    // Per-room heatmap: kinds of assets which took the most time get their
+    // own columns, the rest are summed in the last one
+    std::vector<std::pair<String, IOTotals>> kind_cols(kinds.begin(), kinds.end());
+    std::sort(kind_cols.begin(), kind_cols.end(),
+        [](const std::pair<String, IOTotals> &a, const std::pair<String, IOTotals> &b)
+        { return a.second.TotalUs() > b.second.TotalUs(); });
+    const bool has_other = kind_cols.size() > max_kinds;
+    if (has_other)
+        kind_cols.resize(max_kinds);
+    const size_t num_cols = kind_cols.size() + (has_other ? 1 : 0);
+
+    std::map<int, std::vector<IOTotals>> room_rows;
+    int64_t max_cell_us = 0;
+    for (const auto &room : rooms)
+    {
+        std::vector<IOTotals> &row = room_rows[room.first];
+        row.resize(num_cols + 1); // last is the room's total
+        for (const auto &kind : room.second)
+        {
+            size_t col = num_cols - 1;
+            for (size_t i = 0; i < kind_cols.size(); ++i)
+            {
+                if (kind_cols[i].first == kind.first)
+                {
+                    col = i;
+                    break;
+                }
+            }
+            row[col].Add(kind.second);
+            row[num_cols].Add(kind.second);
+        }
+        for (size_t i = 0; i < num_cols; ++i)
+            max_cell_us = std::max(max_cell_us, row[i].TotalUs());
+    }
+
+    writer.WriteFormat("\nPer-room load heatmap, I/O time in ms (' .:-=+*#%%@' from none to the most)\n");
+    writer.WriteFormat("%-6s %7s %12s %10s |", "room", "opens", "KB read", "total ms");
+    for (const auto &kind : kind_cols)
+        writer.WriteFormat(" %10s", kind.first.GetCStr());
+    if (has_other)
+        writer.WriteFormat(" %10s", "other");
+    writer.WriteLineBreak();
+    for (const auto &row : room_rows)
+    {
+        const IOTotals &room_total = row.second[num_cols];
+        writer.WriteFormat("%-6s %7u %12.1f %10.2f |", GetRoomName(row.first).GetCStr(),
+            room_total.Opens, ToKB(room_total.Bytes), ToMs(room_total.TotalUs()));
+        for (size_t i = 0; i < num_cols; ++i)
+        {
+            const int64_t us = row.second[i].TotalUs();
+            writer.WriteFormat(" %c%9.2f", GetHeatChar(us, max_cell_us), ToMs(us));
+        }
+        writer.WriteLineBreak();
+    }
+    return true;
+}
+
+bool WriteCSV(const String &filename)
+{
+    if (!IsEnabled())
+        return false;
+    TextStreamWriter writer(File::CreateFile(filename));
+    if (!writer.IsValid())
+        return false;
+    // one line per room the asset was read in, or just the open if it was not
+    writer.WriteLine("asset,file,offset,open_room,open_loop,background,untraced,open_us,room,first_loop,last_loop,reads,bytes,seeks,io_us");
+    std::lock_guard<std::mutex> lk(RecordsMutex);
+    for (const auto &rec : Records)
+    {
+        std::lock_guard<std::mutex> rec_lk(rec->Mutex);
+        std::vector<IOUsage> usages = rec->Usage;
+        if (usages.empty())
+        {
+            IOUsage usage;
+            usage.Room = rec->Room;
+            usage.FirstLoop = usage.LastLoop = rec->Loop;
+            usages.push_back(usage);
+        }
+        for (const IOUsage &usage : usages)
+        {
+            writer.WriteFormat("\"%s\",\"%s\",%lld,%d,%u,%d,%d,%lld,%d,%u,%u,%llu,%llu,%llu,%lld\n",
+                rec->AssetName.GetCStr(), rec->FileName.GetCStr(), (long long)rec->Offset,
+                rec->Room, rec->Loop, rec->Background ? 1 : 0, rec->Untraced ? 1 : 0, (long long)rec->OpenUs,
+                usage.Room, usage.FirstLoop, usage.LastLoop, (unsigned long long)usage.Reads,
+                (unsigned long long)usage.Bytes, (unsigned long long)usage.Seeks, (long long)usage.IoUs);
+        }
+    }
+    return true;
+}
+
+} // namespace AssetTrace
+
+} // namespace Common
+} // namespace AGS
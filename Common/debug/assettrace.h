@@ -0,0 +1,69 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// AssetTrace records every asset opened by the engine: how long it took to
+// open, how many bytes were read from it, how many reads and seeks were made
+// and the time spent in them. Each open is tagged with the room and the game
+// loop it happened in, and with whether it was made on a background thread;
+// the reads and seeks are counted for the room they were made in, with the
+// range of game loops, because a stream may be kept open across the rooms.
+//
+// The streams are traced by wrapping them in a proxy stream, which counts
+// the calls made through it; the record is kept after the stream is closed.
+// Assets opened as allegro's PACKFILE (audio and video) are only recorded as
+// opened, their reads are not counted.
+// The report lists the assets which took the most time, and the amount of
+// reading done in each room per kind of asset.
+//
+//=============================================================================
+#ifndef __AGS_CN_DEBUG__ASSETTRACE_H
+#define __AGS_CN_DEBUG__ASSETTRACE_H
+
+#include "core/types.h"
+#include "util/string.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+class Stream;
+
+namespace AssetTrace
+{
+    // Starts recording; the calling thread is considered the main one
+    void Enable();
+    // Stops recording and frees the records
+    void Disable();
+    bool IsEnabled();
+    // Sets the room and game loop the next opens are tagged with
+    void SetRoom(int room);
+    void SetLoop(uint32_t loop);
+    // Returns the stream which records the use of the given one, and owns it.
+    // File name and offset tell where the asset is stored; open time is how
+    // long it took to find and open the asset, in microseconds.
+    Stream *TraceStream(Stream *s, const String &asset_name, const String &filename,
+        soff_t offset, int64_t open_us);
+    // Records the open of the asset which is read without the Stream
+    void TraceOpen(const String &asset_name, const String &filename, soff_t offset, int64_t open_us);
+    // Writes the report of the top assets by I/O time and per-room heatmap
+    bool WriteReport(const String &filename);
+    // Writes every recorded open as a line of comma-separated values
+    bool WriteCSV(const String &filename);
+}
+
+} // namespace Common
+} // namespace AGS
+
+#endif // __AGS_CN_DEBUG__ASSETTRACE_H
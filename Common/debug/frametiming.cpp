@@ -0,0 +1,188 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string.h>
+#include "debug/frametiming.h"
+#include "util/file.h"
+#include "util/stream.h"
+#include "util/textstreamwriter.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+namespace FrameTiming
+{
+
+typedef std::chrono::steady_clock Clock;
+
+// Single timed stage
+struct StageEvent
+{
+    uint32_t Frame;
+    FrameStage Stage;
+    int64_t  StartUs; // since recording start
+    int64_t  DurUs;
+};
+
+static const char *StageNames[kNumFrameStages] =
+{
+    "Input", "Update", "Script", "RoomSprites", "GuiOverlays", "Render", "Wait", "Audio", "SpriteLoad"
+};
+
+static std::atomic<bool> Enabled(false);
+static std::thread::id   TimedThread;
+static Clock::time_point StartTime;
+static std::vector<StageEvent> Events;
+static size_t  EventHead = 0;   // next write position
+static size_t  EventCount = 0;
+static std::vector<FrameTimes> Frames;
+static size_t  FrameHead = 0;
+static size_t  FrameCount = 0;
+static bool    FrameStarted = false;
+static FrameTimes CurFrame;
+static int64_t FrameStartUs = 0;
+// Start time and nesting depth of each stage, for the reentrant calls
+static int64_t StageStartUs[kNumFrameStages];
+static int     StageDepth[kNumFrameStages];
+
+static inline int64_t NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - StartTime).count();
+}
+
+static inline bool IsTimedThread()
+{
+    return Enabled.load(std::memory_order_relaxed) && std::this_thread::get_id() == TimedThread;
+}
+
+void Enable(size_t max_events, size_t max_frames)
+{
+    Disable();
+    Events.resize(max_events > 0 ? max_events : 1);
+    Frames.resize(max_frames > 0 ? max_frames : 1);
+    TimedThread = std::this_thread::get_id();
+    StartTime = Clock::now();
+    Enabled = true;
+}
+
+void Disable()
+{
+    Enabled = false;
+    Events.clear();
+    Events.shrink_to_fit();
+    Frames.clear();
+    Frames.shrink_to_fit();
+    EventHead = EventCount = 0;
+    FrameHead = FrameCount = 0;
+    FrameStarted = false;
+    memset(StageDepth, 0, sizeof(StageDepth));
+}
+
+bool IsEnabled()
+{
+    return Enabled;
+}
+
+static void FinishFrame(int64_t now)
+{
+    CurFrame.TotalUs = now - FrameStartUs;
+    Frames[FrameHead] = CurFrame;
+    FrameHead = (FrameHead + 1) % Frames.size();
+    if (FrameCount < Frames.size())
+        FrameCount++;
+}
+
+void BeginFrame(uint32_t frame)
+{
+    if (!IsTimedThread())
+        return;
+    const int64_t now = NowUs();
+    if (FrameStarted)
+        FinishFrame(now);
+    memset(&CurFrame, 0, sizeof(CurFrame));
+    CurFrame.Frame = frame;
+    FrameStartUs = now;
+    FrameStarted = true;
+}
+
+void BeginStage(FrameStage stage)
+{
+    if (!IsTimedThread())
+        return;
+    if (StageDepth[stage]++ == 0)
+        StageStartUs[stage] = NowUs();
+}
+
+void EndStage(FrameStage stage)
+{
+    if (!IsTimedThread() || StageDepth[stage] == 0)
+        return;
+    if (--StageDepth[stage] > 0)
+        return;
+    const int64_t start = StageStartUs[stage];
+    const int64_t dur = NowUs() - start;
+    StageEvent &ev = Events[EventHead];
+    ev.Frame = CurFrame.Frame;
+    ev.Stage = stage;
+    ev.StartUs = start;
+    ev.DurUs = dur;
+    EventHead = (EventHead + 1) % Events.size();
+    if (EventCount < Events.size())
+        EventCount++;
+    CurFrame.StageUs[stage] += dur;
+}
+
+void GetFrameTimes(std::vector<FrameTimes> &frames)
+{
+    frames.clear();
+    if (!Enabled)
+        return;
+    const size_t first = (FrameHead + Frames.size() - FrameCount) % Frames.size();
+    for (size_t i = 0; i < FrameCount; ++i)
+        frames.push_back(Frames[(first + i) % Frames.size()]);
+}
+
+const char *GetStageName(FrameStage stage)
+{
+    return (stage >= 0 && stage < kNumFrameStages) ? StageNames[stage] : "";
+}
+
+bool ExportChromeTrace(const String &filename)
+{
+    if (!Enabled)
+        return false;
+    TextStreamWriter writer(File::CreateFile(filename));
+    if (!writer.IsValid())
+        return false;
+    writer.WriteLine("{\"traceEvents\":[");
+    const size_t first = (EventHead + Events.size() - EventCount) % Events.size();
+    for (size_t i = 0; i < EventCount; ++i)
+    {
+        const StageEvent &ev = Events[(first + i) % Events.size()];
+        writer.WriteFormat("{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":1,\"args\":{\"frame\":%u}}%s\n",
+            StageNames[ev.Stage], (long long)ev.StartUs, (long long)ev.DurUs, ev.Frame,
+            (i + 1 < EventCount) ? "," : "");
+    }
+    writer.WriteLine("],\"displayTimeUnit\":\"ms\"}");
+    return true;
+}
+
+} // namespace FrameTiming
+
+} // namespace Common
+} // namespace AGS
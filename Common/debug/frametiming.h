@@ -0,0 +1,92 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// FrameTiming records how long each stage of the game frame takes.
+// Every timed stage is stored as an event in the ring buffer, which may be
+// exported in Chrome's trace event format (open it in chrome://tracing or
+// Perfetto). Stage durations are also summed per frame, for the on-screen
+// stage breakdown graph.
+//
+// Only the thread which enabled recording is timed; calls from other threads
+// are ignored. Stages may be nested (e.g. audio polling during render), in
+// which case inner stage's time is also counted in the outer one.
+//
+//=============================================================================
+#ifndef __AGS_CN_DEBUG__FRAMETIMING_H
+#define __AGS_CN_DEBUG__FRAMETIMING_H
+
+#include <vector>
+#include "core/types.h"
+#include "util/string.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+enum FrameStage
+{
+    kFrameStage_Input,          // player controls
+    kFrameStage_Update,         // game state update
+    kFrameStage_Script,         // repeatedly_execute and queued script events
+    kFrameStage_RoomSprites,    // preparing room objects and characters for drawing
+    kFrameStage_GuiOverlays,    // preparing GUI and overlays for drawing
+    kFrameStage_Render,         // renderer pass and presenting the frame
+    kFrameStage_Wait,           // waiting for the next frame
+    kFrameStage_Audio,          // audio polling
+    kFrameStage_SpriteLoad,     // loading sprites from the file
+    kNumFrameStages
+};
+
+// Summed stage durations of a single game frame
+struct FrameTimes
+{
+    uint32_t Frame;
+    int64_t  TotalUs;
+    int64_t  StageUs[kNumFrameStages];
+};
+
+namespace FrameTiming
+{
+    // Starts recording; sizes define how many stage events and frames are kept
+    void Enable(size_t max_events = 65536, size_t max_frames = 256);
+    // Stops recording and frees the buffers
+    void Disable();
+    bool IsEnabled();
+    // Marks the start of the new game frame
+    void BeginFrame(uint32_t frame);
+    void BeginStage(FrameStage stage);
+    void EndStage(FrameStage stage);
+    // Returns times of the last finished frames, ordered from oldest to newest
+    void GetFrameTimes(std::vector<FrameTimes> &frames);
+    const char *GetStageName(FrameStage stage);
+    // Writes recorded events in Chrome's trace event JSON format
+    bool ExportChromeTrace(const String &filename);
+}
+
+// Times a stage for the duration of the scope
+class FrameStageTimer
+{
+public:
+    FrameStageTimer(FrameStage stage) : _stage(stage) { FrameTiming::BeginStage(stage); }
+    ~FrameStageTimer() { FrameTiming::EndStage(_stage); }
+
+private:
+    FrameStage _stage;
+};
+
+} // namespace Common
+} // namespace AGS
+
+#endif // __AGS_CN_DEBUG__FRAMETIMING_H
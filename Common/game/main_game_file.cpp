@@ -106,15 +106,8 @@ bool IsMainGameLibrary(const String &filename)
     AssetLibInfo lib;
     if (AssetManager::ReadDataFileTOC(filename, lib) != kAssetNoError)
         return false;
-    for (size_t i = 0; i < lib.AssetInfos.size(); ++i)
-    {
-        if (lib.AssetInfos[i].FileName.CompareNoCase(MainGameSource::DefaultFilename_v3) == 0 ||
-            lib.AssetInfos[i].FileName.CompareNoCase(MainGameSource::DefaultFilename_v2) == 0)
-        {
-            return true;
-        }
-    }
-    return false;
+    return lib.FindAsset(MainGameSource::DefaultFilename_v3) != nullptr ||
+        lib.FindAsset(MainGameSource::DefaultFilename_v2) != nullptr;
 }
 
 // Begins reading main game file from a generic stream
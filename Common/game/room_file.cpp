@@ -12,6 +12,8 @@
 //
 //=============================================================================
 
+#include <future>
+#include <system_error>
 #include "ac/common.h" // update_polled_stuff
 #include "ac/common_defines.h"
 #include "ac/gamestructdefines.h"
@@ -25,6 +27,7 @@
 #include "script/cc_error.h"
 #include "script/cc_script.h"
 #include "util/compress.h"
+#include "util/decodedcache.h"
 #include "util/string_utils.h"
 
 // default number of hotspots to read from the room file
@@ -41,6 +44,171 @@ namespace AGS
 namespace Common
 {
 
+// Background frame which is being unpacked on a worker thread
+struct PendingBgFrame
+{
+    size_t Index;
+    // unpacked data, or empty if the packed data was corrupt
+    std::future<std::vector<uint8_t>> Data;
+};
+typedef std::vector<PendingBgFrame> PendingBgFrames;
+
+static std::vector<uint8_t> UnpackBgFrame(std::vector<uint8_t> packed, size_t unpacked_size, uint64_t cache_key)
+{
+    std::vector<uint8_t> unpacked;
+    if (!unpack_lzw(packed, unpacked_size, unpacked))
+        unpacked.clear();
+    else if (DecodedCache::IsEnabled())
+        DecodedCache::Store("bg", cache_key, unpacked.data(), unpacked.size());
+    return unpacked;
+}
+
+// Reads the packed background frame and starts unpacking it on a worker
+// thread, while the rest of the room data is read
+static void ReadBgFrame(Stream *in, size_t index, color *pal, PendingBgFrames &pending)
+{
+    std::vector<uint8_t> packed;
+    size_t unpacked_size;
+    read_lzw(in, pal, packed, unpacked_size);
+    PendingBgFrame frame;
+    frame.Index = index;
+    uint64_t cache_key = 0;
+    if (DecodedCache::IsEnabled())
+    {
+        // the frame was unpacked before, take it from the cache
+        cache_key = DecodedCache::Hash(packed.data(), packed.size(), unpacked_size);
+        CachedData cached;
+        if (DecodedCache::Find("bg", cache_key, cached) && cached.Size == unpacked_size)
+        {
+            std::promise<std::vector<uint8_t>> data;
+            data.set_value(std::vector<uint8_t>(cached.Data, cached.Data + cached.Size));
+            frame.Data = data.get_future();
+            pending.push_back(std::move(frame));
+            return;
+        }
+    }
+    try
+    {
+        frame.Data = std::async(std::launch::async, UnpackBgFrame, std::move(packed), unpacked_size, cache_key);
+    }
+    catch (const std::system_error&)
+    {
+        // could not start a thread, unpack when the frame is needed
+        frame.Data = std::async(std::launch::deferred, UnpackBgFrame, std::move(packed), unpacked_size, cache_key);
+    }
+    pending.push_back(std::move(frame));
+}
+
+// Lets the engine handle its events while the room is read, unless the room
+// is read on a background thread
+static void PollGame(bool poll_game)
+{
+    if (poll_game)
+        update_polled_stuff_if_runtime();
+}
+
+// Reads one mask bitmap
+static HRoomFileError ReadMask(Stream *in, PBitmap &mask, bool poll_game)
+{
+    mask.reset(read_rle_bitmap8(in, poll_game));
+    if (!mask)
+        return new RoomFileError(kRoomFileErr_ImageCreateFailed);
+    return HRoomFileError::None();
+}
+
+// Reads the four room masks
+static HRoomFileError ReadMasks(RoomStruct *room, Stream *in, bool poll_game)
+{
+    HRoomFileError err = ReadMask(in, room->RegionMask, poll_game);
+    if (!err)
+        return err;
+    PollGame(poll_game);
+    err = ReadMask(in, room->WalkAreaMask, poll_game);
+    if (!err)
+        return err;
+    PollGame(poll_game);
+    err = ReadMask(in, room->WalkBehindMask, poll_game);
+    if (!err)
+        return err;
+    PollGame(poll_game);
+    return ReadMask(in, room->HotspotMask, poll_game);
+}
+
+// Takes the unpacked masks from the cache, or reads them and puts them
+// there; the masks are the last data in the block, which ends at block_end
+static HRoomFileError ReadMasksCached(RoomStruct *room, Stream *in, soff_t block_end, bool poll_game)
+{
+    const soff_t start = in->GetPosition();
+    std::vector<uint8_t> packed(block_end > start ? (size_t)(block_end - start) : 0);
+    if (packed.empty() || in->Read(packed.data(), packed.size()) != packed.size())
+    {
+        in->Seek(start, kSeekBegin);
+        return ReadMasks(room, in, poll_game);
+    }
+    const uint64_t cache_key = DecodedCache::Hash(packed.data(), packed.size());
+
+    // each mask is saved as its width, height and 8-bit pixels
+    PBitmap *masks[] = { &room->RegionMask, &room->WalkAreaMask, &room->WalkBehindMask, &room->HotspotMask };
+    CachedData cached;
+    if (DecodedCache::Find("masks", cache_key, cached))
+    {
+        const uint8_t *data = cached.Data;
+        const uint8_t *data_end = cached.Data + cached.Size;
+        size_t i = 0;
+        for (; i < 4; ++i)
+        {
+            int32_t size[2];
+            if (data_end - data < (ptrdiff_t)sizeof(size))
+                break;
+            memcpy(size, data, sizeof(size));
+            data += sizeof(size);
+            if (size[0] <= 0 || size[1] <= 0 || (uint64_t)(data_end - data) < (uint64_t)size[0] * size[1])
+                break;
+            Bitmap *mask = BitmapHelper::CreateBitmap(size[0], size[1], 8);
+            if (!mask)
+                break;
+            for (int y = 0; y < size[1]; ++y, data += size[0])
+                memcpy(mask->GetScanLineForWriting(y), data, size[0]);
+            masks[i]->reset(mask);
+        }
+        if (i == 4)
+            return HRoomFileError::None();
+    }
+
+    in->Seek(start, kSeekBegin);
+    HRoomFileError err = ReadMasks(room, in, poll_game);
+    if (!err)
+        return err;
+    std::vector<uint8_t> unpacked;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        const Bitmap *mask = masks[i]->get();
+        int32_t size[2] = { mask->GetWidth(), mask->GetHeight() };
+        const uint8_t *p = (const uint8_t*)size;
+        unpacked.insert(unpacked.end(), p, p + sizeof(size));
+        for (int y = 0; y < size[1]; ++y)
+            unpacked.insert(unpacked.end(), mask->GetScanLine(y), mask->GetScanLine(y) + size[0]);
+    }
+    DecodedCache::Store("masks", cache_key, unpacked.data(), unpacked.size());
+    return HRoomFileError::None();
+}
+
+// Waits for the background frames to finish unpacking and assigns them to the room
+static HRoomFileError FinishBgFrames(RoomStruct *room, PendingBgFrames &pending)
+{
+    HRoomFileError err;
+    for (PendingBgFrame &frame : pending)
+    {
+        std::vector<uint8_t> data = frame.Data.get();
+        Bitmap *bmp = create_lzw_bitmap(data, room->BackgroundBPP);
+        if (!bmp && err)
+            err = new RoomFileError(kRoomFileErr_InvalidBgFrame, String::FromFormat("Frame: %u.", (unsigned)frame.Index));
+        room->BgFrames[frame.Index].Graphic.reset(bmp);
+    }
+    pending.clear();
+    return err;
+}
+
 RoomDataSource::RoomDataSource()
     : DataVersion(kRoomVersion_Undefined)
 {
@@ -76,6 +244,10 @@ String GetRoomFileErrorText(RoomFileErrorType err)
         return "Errors encountered when reading custom properties.";
     case kRoomFileErr_BlockNotFound:
         return "Required block was not found.";
+    case kRoomFileErr_InvalidBgFrame:
+        return "Room background is corrupted.";
+    case kRoomFileErr_ImageCreateFailed:
+        return "Not enough memory to create the room images.";
     }
     return "Unknown error.";
 }
@@ -145,7 +317,8 @@ void WriteRoomObject(const RoomObjectInfo &obj, Stream *out)
 
 
 // Main room data
-HRoomFileError ReadMainBlock(RoomStruct *room, Stream *in, RoomFileVersion data_ver)
+HRoomFileError ReadMainBlock(RoomStruct *room, Stream *in, RoomFileVersion data_ver, soff_t block_end,
+                             PendingBgFrames &pending, bool poll_game)
 {
     int bpp;
     if (data_ver >= kRoomVersion_208)
@@ -209,7 +382,7 @@ HRoomFileError ReadMainBlock(RoomStruct *room, Stream *in, RoomFileVersion data_
             wallpoints[i].Read(in);
     */
 
-    update_polled_stuff_if_runtime();
+    PollGame(poll_game);
 
     room->Edges.Top = in->ReadInt16();
     room->Edges.Bottom = in->ReadInt16();
@@ -376,39 +549,46 @@ HRoomFileError ReadMainBlock(RoomStruct *room, Stream *in, RoomFileVersion data_
             room->Regions[i].Tint = in->ReadInt32();
     }
 
-    update_polled_stuff_if_runtime();
+    PollGame(poll_game);
     // Primary background
-    Bitmap *mask = nullptr;
+    HRoomFileError err;
     if (data_ver >= kRoomVersion_pre114_5)
-        load_lzw(in, &mask, room->BackgroundBPP, room->Palette);
+    {
+        ReadBgFrame(in, 0, room->Palette, pending);
+    }
     else
-        loadcompressed_allegro(in, &mask, room->Palette);
-    room->BgFrames[0].Graphic.reset(mask);
+    {
+        err = ReadMask(in, room->BgFrames[0].Graphic, poll_game);
+        if (!err)
+            return err;
+    }
 
-    update_polled_stuff_if_runtime();
-    // Mask bitmaps
+    PollGame(poll_game);
+    // Mask bitmaps, unpacked here while the background is unpacked on another thread
     if (data_ver >= kRoomVersion_255b)
     {
-        loadcompressed_allegro(in, &mask, room->Palette);
+        if (DecodedCache::IsEnabled())
+            return ReadMasksCached(room, in, block_end, poll_game);
+        return ReadMasks(room, in, poll_game);
     }
     else if (data_ver >= kRoomVersion_114)
     {
         // an old version - clear the 'shadow' area into a blank regions bmp
-        loadcompressed_allegro(in, &mask, room->Palette);
-        delete mask;
-        mask = nullptr;
-    }
-    room->RegionMask.reset(mask);
-    update_polled_stuff_if_runtime();
-    loadcompressed_allegro(in, &mask, room->Palette);
-    room->WalkAreaMask.reset(mask);
-    update_polled_stuff_if_runtime();
-    loadcompressed_allegro(in, &mask, room->Palette);
-    room->WalkBehindMask.reset(mask);
-    update_polled_stuff_if_runtime();
-    loadcompressed_allegro(in, &mask, room->Palette);
-    room->HotspotMask.reset(mask);
-    return HRoomFileError::None();
+        err = ReadMask(in, room->RegionMask, poll_game);
+        if (!err)
+            return err;
+    }
+    room->RegionMask.reset();
+    PollGame(poll_game);
+    err = ReadMask(in, room->WalkAreaMask, poll_game);
+    if (!err)
+        return err;
+    PollGame(poll_game);
+    err = ReadMask(in, room->WalkBehindMask, poll_game);
+    if (!err)
+        return err;
+    PollGame(poll_game);
+    return ReadMask(in, room->HotspotMask, poll_game);
 }
 
 // Room script sources (original text)
@@ -469,7 +649,8 @@ HRoomFileError ReadObjScNamesBlock(RoomStruct *room, Stream *in, RoomFileVersion
 }
 
 // Secondary backgrounds
-HRoomFileError ReadAnimBgBlock(RoomStruct *room, Stream *in, RoomFileVersion data_ver)
+HRoomFileError ReadAnimBgBlock(RoomStruct *room, Stream *in, RoomFileVersion data_ver, PendingBgFrames &pending,
+                               bool poll_game)
 {
     room->BgFrameCount = in->ReadByte();
     if (room->BgFrameCount > MAX_ROOM_BGFRAMES)
@@ -484,10 +665,8 @@ HRoomFileError ReadAnimBgBlock(RoomStruct *room, Stream *in, RoomFileVersion dat
 
     for (size_t i = 1; i < room->BgFrameCount; ++i)
     {
-        update_polled_stuff_if_runtime();
-        Bitmap *frame = nullptr;
-        load_lzw(in, &frame, room->BackgroundBPP, room->BgFrames[i].Palette);
-        room->BgFrames[i].Graphic.reset(frame);
+        PollGame(poll_game);
+        ReadBgFrame(in, i, room->BgFrames[i].Palette, pending);
     }
     return HRoomFileError::None();
 }
@@ -511,7 +690,8 @@ HRoomFileError ReadPropertiesBlock(RoomStruct *room, Stream *in, RoomFileVersion
     return HRoomFileError::None();
 }
 
-HRoomFileError ReadRoomBlock(RoomStruct *room, Stream *in, RoomFileBlock block, RoomFileVersion data_ver)
+HRoomFileError ReadRoomBlock(RoomStruct *room, Stream *in, RoomFileBlock block, RoomFileVersion data_ver,
+                             PendingBgFrames &pending, bool poll_game)
 {
     soff_t block_len = data_ver < kRoomVersion_350 ? in->ReadInt32() : in->ReadInt64();
     soff_t block_end = in->GetPosition() + block_len;
@@ -520,7 +700,7 @@ HRoomFileError ReadRoomBlock(RoomStruct *room, Stream *in, RoomFileBlock block,
     switch (block)
     {
     case kRoomFblk_Main:
-        err = ReadMainBlock(room, in, data_ver);
+        err = ReadMainBlock(room, in, data_ver, block_end, pending, poll_game);
         break;
     case kRoomFblk_Script:
         in->Seek(block_len); // no longer read source script text into RoomStruct
@@ -535,7 +715,7 @@ HRoomFileError ReadRoomBlock(RoomStruct *room, Stream *in, RoomFileBlock block,
         err = ReadObjScNamesBlock(room, in, data_ver);
         break;
     case kRoomFblk_AnimBg:
-        err = ReadAnimBgBlock(room, in, data_ver);
+        err = ReadAnimBgBlock(room, in, data_ver, pending, poll_game);
         break;
     case kRoomFblk_Properties:
         err = ReadPropertiesBlock(room, in, data_ver);
@@ -574,27 +754,33 @@ void SkipRoomBlock(Stream *in, RoomFileVersion data_ver)
 }
 
 
-HRoomFileError ReadRoomData(RoomStruct *room, Stream *in, RoomFileVersion data_ver)
+HRoomFileError ReadRoomData(RoomStruct *room, Stream *in, RoomFileVersion data_ver, bool poll_game)
 {
     room->DataVersion = data_ver;
 
+    // background frames are unpacked on worker threads, and these must be
+    // finished before returning, even if reading fails
+    PendingBgFrames pending;
     RoomFileBlock block;
     do
     {
-        update_polled_stuff_if_runtime();
+        PollGame(poll_game);
         int b = in->ReadByte();
         if (b < 0)
             return new RoomFileError(kRoomFileErr_UnexpectedEOF);
         block = (RoomFileBlock)b;
         if (block != kRoomFile_EOF)
         {
-            HRoomFileError err = ReadRoomBlock(room, in, block, data_ver);
+            HRoomFileError err = ReadRoomBlock(room, in, block, data_ver, pending, poll_game);
             if (!err)
+            {
+                FinishBgFrames(room, pending);
                 return err;
+            }
         }
     }
     while (block != kRoomFile_EOF);
-    return HRoomFileError::None();
+    return FinishBgFrames(room, pending);
 }
 
 HRoomFileError UpdateRoomData(RoomStruct *room, RoomFileVersion data_ver, bool game_is_hires, const std::vector<SpriteInfo> &sprinfos)
@@ -50,7 +50,9 @@ enum RoomFileErrorType
     kRoomFileErr_InconsistentData,
     kRoomFileErr_PropertiesBlockFormat,
     kRoomFileErr_InvalidPropertyValues,
-    kRoomFileErr_BlockNotFound
+    kRoomFileErr_BlockNotFound,
+    kRoomFileErr_InvalidBgFrame,
+    kRoomFileErr_ImageCreateFailed
 };
 
 String GetRoomFileErrorText(RoomFileErrorType err);
@@ -75,8 +77,9 @@ struct RoomDataSource
 
 // Opens room file for reading from an arbitrary file
 HRoomFileError OpenRoomFile(const String &filename, RoomDataSource &src);
-// Reads room data
-HRoomFileError ReadRoomData(RoomStruct *room, Stream *in, RoomFileVersion data_ver);
+// Reads room data; lets the engine handle its events meanwhile if poll_game
+// is set, otherwise it may be called on any thread
+HRoomFileError ReadRoomData(RoomStruct *room, Stream *in, RoomFileVersion data_ver, bool poll_game = true);
 // Applies necessary updates, conversions and fixups to the loaded data
 // making it compatible with current engine
 HRoomFileError UpdateRoomData(RoomStruct *room, RoomFileVersion data_ver, bool game_is_hires, const std::vector<SpriteInfo> &sprinfos);
@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <cstring>
 #include <stdexcept>
+#include <system_error>
 #include "util/bufferedstream.h"
 #include "util/stdio_compat.h"
 #include "util/string.h"
@@ -23,8 +24,18 @@ namespace AGS
 namespace Common
 {
 
-BufferedStream::BufferedStream(const String &file_name, FileOpenMode open_mode, FileWorkMode work_mode, DataEndianess stream_endianess)
-        : FileStream(file_name, open_mode, work_mode, stream_endianess), _buffer(BufferStreamSize), _bufferPosition(0), _position(0)
+BufferedStream::BufferedStream(const String &file_name, FileOpenMode open_mode, FileWorkMode work_mode,
+        DataEndianess stream_endianess, bool read_ahead)
+    : FileStream(file_name, open_mode, work_mode, stream_endianess)
+    , _bufferPosition(0)
+    , _bufferSize(BufferStreamSize)
+    , _position(0)
+    , _eos(false)
+    , _readAhead(read_ahead)
+    , _aheadPosition(-1)
+    , _aheadSize(0)
+    , _aheadPending(false)
+    , _aheadStop(false)
 {
     if (FileStream::Seek(0, kSeekEnd) == false)
         throw std::runtime_error("Error determining stream end.");
@@ -35,25 +46,143 @@ BufferedStream::BufferedStream(const String &file_name, FileOpenMode open_mode,
 
     if (FileStream::Seek(0, kSeekBegin) == false)
         throw std::runtime_error("Error determining stream end.");
+}
 
-    _buffer.resize(0);
+BufferedStream::~BufferedStream()
+{
+    StopReadAhead();
+}
 
+void BufferedStream::Close()
+{
+    StopReadAhead();
+    DropBuffers();
+    FileStream::Close();
 }
 
 void BufferedStream::FillBufferFromPosition(soff_t position)
 {
-    FileStream::Seek(position, kSeekBegin);
+    WaitReadAhead();
+
+    // Reading forward, just past the buffer end, continues from the buffer end:
+    // the buffer grows, and keeps the tail of the previous data
+    const soff_t buffer_end = _bufferPosition + (soff_t)_buffer.size();
+    const bool forward = !_buffer.empty() && position >= buffer_end &&
+        position < buffer_end + (soff_t)_bufferSize;
+    size_t keep = 0;
+    soff_t read_from = position;
+    if (forward)
+    {
+        _bufferSize = std::min(_bufferSize * 2, BufferStreamMaxSize);
+        keep = std::min(_buffer.size(), BufferStreamKeepBehind);
+        std::memmove(_buffer.data(), _buffer.data() + _buffer.size() - keep, keep);
+        read_from = buffer_end;
+    }
+    else
+    {
+        _bufferSize = BufferStreamSize;
+    }
+
+    _bufferPosition = read_from - keep;
+    _buffer.resize(keep + _bufferSize);
+    size_t sz = 0;
+    if (_aheadPosition == read_from && !_aheadBuffer.empty())
+    {
+        sz = std::min(_aheadBuffer.size(), _bufferSize);
+        std::memcpy(_buffer.data() + keep, _aheadBuffer.data(), sz);
+    }
+    _aheadBuffer.clear();
+    _aheadPosition = -1;
+    if (sz < _bufferSize && read_from + (soff_t)sz < _end)
+    {
+        FileStream::Seek(read_from + sz, kSeekBegin);
+        sz += FileStream::Read(_buffer.data() + keep + sz, _bufferSize - sz);
+    }
+    _buffer.resize(keep + sz);
+
+    if (_readAhead && forward && read_from + (soff_t)sz < _end)
+        StartReadAhead(read_from + sz, std::min(_bufferSize * 2, BufferStreamMaxSize));
+}
+
+void BufferedStream::StartReadAhead(soff_t position, size_t size)
+{
+    if (!_aheadThread.joinable())
+    {
+        try
+        {
+            _aheadThread = std::thread(&BufferedStream::ReadAheadThread, this);
+        }
+        catch (const std::system_error&)
+        {
+            // could not start a thread, the blocks will be read when needed
+            _readAhead = false;
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(_aheadMutex);
+    _aheadPosition = position;
+    _aheadSize = size;
+    _aheadPending = true;
+    _aheadCond.notify_all();
+}
+
+void BufferedStream::WaitReadAhead()
+{
+    if (!_aheadThread.joinable())
+        return;
+    std::unique_lock<std::mutex> lk(_aheadMutex);
+    _aheadCond.wait(lk, [this]() { return !_aheadPending; });
+}
 
-    _buffer.resize(BufferStreamSize);
-    auto sz = FileStream::Read(_buffer.data(), BufferStreamSize);
-    _buffer.resize(sz);
+void BufferedStream::StopReadAhead()
+{
+    if (!_aheadThread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lk(_aheadMutex);
+        _aheadStop = true;
+        _aheadCond.notify_all();
+    }
+    _aheadThread.join();
+    _readAhead = false;
+}
+
+void BufferedStream::ReadAheadThread()
+{
+    std::unique_lock<std::mutex> lk(_aheadMutex);
+    for (;;)
+    {
+        _aheadCond.wait(lk, [this]() { return _aheadPending || _aheadStop; });
+        if (_aheadStop)
+            break;
+        const soff_t position = _aheadPosition;
+        const size_t size = _aheadSize;
+        lk.unlock();
+        _aheadBuffer.resize(size);
+        FileStream::Seek(position, kSeekBegin);
+        _aheadBuffer.resize(FileStream::Read(_aheadBuffer.data(), size));
+        lk.lock();
+        _aheadPending = false;
+        _aheadCond.notify_all();
+    }
+}
 
-    _bufferPosition = position;
+void BufferedStream::DropBuffers()
+{
+    _buffer.clear();
+    _aheadBuffer.clear();
+    _aheadPosition = -1;
 }
 
 bool BufferedStream::EOS() const
 {
-    return _position == _end;
+    return _eos;
+}
+
+soff_t BufferedStream::GetLength() const
+{
+    return IsValid() ? _end : 0;
 }
 
 soff_t BufferedStream::GetPosition() const
@@ -67,12 +196,23 @@ size_t BufferedStream::Read(void *toBuffer, size_t toSize)
 
     while(toSize > 0)
     {
-        if (_position < _bufferPosition || _position >= _bufferPosition + _buffer.size())
+        if (_position < _bufferPosition || _position >= _bufferPosition + (soff_t)_buffer.size())
         {
+            // large reads go to the destination directly
+            if (toSize >= _bufferSize)
+            {
+                WaitReadAhead();
+                FileStream::Seek(_position, kSeekBegin);
+                auto sz = FileStream::Read(to, toSize);
+                to += sz;
+                _position += sz;
+                toSize -= sz;
+                break;
+            }
             FillBufferFromPosition(_position);
         }
-        if (_buffer.size() <= 0) { break; } // reached EOS
-        assert(_position >= _bufferPosition && _position < _bufferPosition + _buffer.size());  // sanity check only, should be checked by above.
+        if (_position >= _bufferPosition + (soff_t)_buffer.size()) { break; } // reached EOS
+        assert(_position >= _bufferPosition && _position < _bufferPosition + (soff_t)_buffer.size());  // sanity check only, should be checked by above.
 
         soff_t bufferOffset = _position - _bufferPosition;
         assert(bufferOffset >= 0);
@@ -86,11 +226,16 @@ size_t BufferedStream::Read(void *toBuffer, size_t toSize)
         toSize -= chunkSize;
     }
 
+    // like the file stream, report the end of stream only after failing to read
+    if (toSize > 0)
+        _eos = true;
     return to - (char*)toBuffer;
 }
 
 int32_t BufferedStream::ReadByte()
 {
+    if (_position >= _bufferPosition && _position < _bufferPosition + (soff_t)_buffer.size())
+        return (uint8_t)_buffer[(size_t)(_position++ - _bufferPosition)];
     uint8_t ch;
     auto bytesRead = Read(&ch, 1);
     if (bytesRead != 1) { return EOF; }
@@ -99,11 +244,12 @@ int32_t BufferedStream::ReadByte()
 
 size_t BufferedStream::Write(const void *buffer, size_t size)
 { 
+    WaitReadAhead();
+    DropBuffers();
     FileStream::Seek(_position, kSeekBegin);
     auto sz = FileStream::Write(buffer, size);
-    if (_position == _end)
-        _end += sz;
     _position += sz;
+    _end = std::max(_end, _position);
     return sz;
 }
 
@@ -125,9 +271,13 @@ bool BufferedStream::Seek(soff_t offset, StreamSeek origin)
         break;
     }
 
-    // clamp
-    _position = std::min(std::max(want_pos, (soff_t)0), _end);
-    return _position == want_pos;
+    // like the file stream, fail on the negative position but allow one
+    // past the end: reading there gives nothing, writing extends the file
+    if (want_pos < 0)
+        return false;
+    _position = want_pos;
+    _eos = false;
+    return true;
 }
 
 } // namespace Common
@@ -18,6 +18,9 @@
 #ifndef __AGS_CN_UTIL__BUFFEREDSTREAM_H
 #define __AGS_CN_UTIL__BUFFEREDSTREAM_H
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include "util/filestream.h"
 #include "util/file.h" // TODO: extract filestream mode constants
@@ -28,7 +31,14 @@ namespace Common
 {
 
 // Needs tuning depending on the platform.
-const auto BufferStreamSize = 8*1024;
+// The buffer starts at the minimal size and doubles with each refill while
+// the stream is read forward, up to the maximal size; random access makes
+// it go back to the minimal size.
+const size_t BufferStreamSize = 8*1024;
+const size_t BufferStreamMaxSize = 256*1024;
+// How much of the previous buffer is kept when refilling it, so that the
+// short seeks back don't make the stream read from the file again.
+const size_t BufferStreamKeepBehind = 4*1024;
 
 class BufferedStream : public FileStream
 {
@@ -39,9 +49,17 @@ public:
     // - the open mode could not be determined
     // - could not determine the length of the stream
     // It is recommended to use File::OpenFile to safely construct this object.
-    BufferedStream(const String &file_name, FileOpenMode open_mode, FileWorkMode work_mode, DataEndianess stream_endianess = kLittleEndian);
+    // If read_ahead is set, then while the stream is read forward the next
+    // block is read from the file on a background thread; the thread is
+    // started on the first such read and kept until the stream is closed.
+    BufferedStream(const String &file_name, FileOpenMode open_mode, FileWorkMode work_mode,
+        DataEndianess stream_endianess = kLittleEndian, bool read_ahead = false);
+    ~BufferedStream() override;
+
+    void    Close() override;
 
     bool    EOS() const override; ///< Is end of stream
+    soff_t  GetLength() const override; ///< Total length of stream
     soff_t  GetPosition() const override; ///< Current position (if known)
 
     size_t  Read(void *buffer, size_t size) override;
@@ -56,11 +74,35 @@ private:
 
     soff_t _bufferPosition;
     std::vector<char> _buffer;
+    // how much to read from the file on the next refill
+    size_t _bufferSize;
 
     soff_t _position;
     soff_t _end;
+    // set when the read hit the end of stream, like the end-of-file flag
+    bool   _eos;
+
+    // The block being read, or already read ahead; while the request is
+    // pending the worker thread is the only user of the file.
+    bool   _readAhead;
+    soff_t _aheadPosition;
+    size_t _aheadSize;
+    std::vector<char> _aheadBuffer;
+    std::thread _aheadThread;
+    std::mutex _aheadMutex;
+    std::condition_variable _aheadCond;
+    bool   _aheadPending;
+    bool   _aheadStop;
 
     void FillBufferFromPosition(soff_t position);
+    void StartReadAhead(soff_t position, size_t size);
+    // Waits for the pending read ahead, if there's any
+    void WaitReadAhead();
+    // Stops the read ahead thread, if it was started
+    void StopReadAhead();
+    void ReadAheadThread();
+    // Drops all the buffered data, for when the file is written to
+    void DropBuffers();
 };
 
 } // namespace Common
@@ -19,6 +19,8 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <algorithm>
 #include "ac/common.h"	// quit, update_polled_stuff
 #include "gfx/bitmap.h"
 #include "util/compress.h"
@@ -167,6 +169,8 @@ void csavecompressed(Stream *out, const unsigned char * tobesaved, const color p
   free(ress);
 }
 
+// The runs and sequences are copied whole, rather than a byte at a time;
+// a packet which would overflow the line is cut and the line is failed.
 int cunpackbitl(uint8_t *line, int size, Stream *in)
 {
   int n = 0;                    // number of bytes decoded
@@ -183,22 +187,18 @@ int cunpackbitl(uint8_t *line, int size, Stream *in)
     if (cx < 0) {                //.............run
       int i = 1 - cx;
       char ch = in->ReadInt8();
-      while (i--) {
-        // test for buffer overflow
-        if (n >= size)
-          return -1;
-
-        line[n++] = ch;
-      }
+      int fit = std::min(i, size - n);
+      memset(line + n, ch, fit);
+      n += fit;
+      if (fit < i)
+        return -1;
     } else {                     //.....................seq
       int i = cx + 1;
-      while (i--) {
-        // test for buffer overflow
-        if (n >= size)
-          return -1;
-
-        line[n++] = in->ReadByte();
-      }
+      int fit = std::min(i, size - n);
+      in->Read(line + n, fit);
+      n += fit;
+      if (fit < i)
+        return -1;
     }
   }
 
@@ -221,22 +221,18 @@ int cunpackbitl16(uint16_t *line, int size, Stream *in)
     if (cx < 0) {                //.............run
       int i = 1 - cx;
       unsigned short ch = in->ReadInt16();
-      while (i--) {
-        // test for buffer overflow
-        if (n >= size)
-          return -1;
-
-        line[n++] = ch;
-      }
+      int fit = std::min(i, size - n);
+      std::fill(line + n, line + n + fit, ch);
+      n += fit;
+      if (fit < i)
+        return -1;
     } else {                     //.....................seq
       int i = cx + 1;
-      while (i--) {
-        // test for buffer overflow
-        if (n >= size)
-          return -1;
-
-        line[n++] = in->ReadInt16();
-      }
+      int fit = std::min(i, size - n);
+      in->ReadArrayOfInt16((int16_t*)line + n, fit);
+      n += fit;
+      if (fit < i)
+        return -1;
     }
   }
 
@@ -259,22 +255,18 @@ int cunpackbitl32(uint32_t *line, int size, Stream *in)
     if (cx < 0) {                //.............run
       int i = 1 - cx;
       unsigned int ch = in->ReadInt32();
-      while (i--) {
-        // test for buffer overflow
-        if (n >= size)
-          return -1;
-
-        line[n++] = ch;
-      }
+      int fit = std::min(i, size - n);
+      std::fill(line + n, line + n + fit, ch);
+      n += fit;
+      if (fit < i)
+        return -1;
     } else {                     //.....................seq
       int i = cx + 1;
-      while (i--) {
-        // test for buffer overflow
-        if (n >= size)
-          return -1;
-
-        line[n++] = (unsigned int)in->ReadInt32();
-      }
+      int fit = std::min(i, size - n);
+      in->ReadArrayOfInt32((int32_t*)line + n, fit);
+      n += fit;
+      if (fit < i)
+        return -1;
     }
   }
 
@@ -317,29 +309,36 @@ void save_lzw(Stream *out, const Bitmap *bmpp, const color *pall)
   out->Seek(toret, kSeekBegin);
 }
 
-void load_lzw(Stream *in, Bitmap **dst_bmp, int dst_bpp, color *pall) {
-  soff_t        uncompsiz;
-  int           *loptr;
-  unsigned char *membuffer;
-  int           arin;
-
+void read_lzw(Stream *in, color *pall, std::vector<uint8_t> &packed, size_t &unpacked_size) {
   in->Read(&pall[0], sizeof(color)*256);
-  maxsize = in->ReadInt32();
-  uncompsiz = in->ReadInt32();
-
-  uncompsiz += in->GetPosition();
-  outbytes = 0; putbytes = 0;
+  unpacked_size = (uint32_t)in->ReadInt32();
+  size_t packed_size = (uint32_t)in->ReadInt32();
+  packed.resize(packed_size);
+  packed.resize(in->Read(packed.data(), packed_size));
+}
 
-  update_polled_stuff_if_runtime();
-  membuffer = lzwexpand_to_mem(in);
-  update_polled_stuff_if_runtime();
+bool unpack_lzw(const std::vector<uint8_t> &packed, size_t unpacked_size, std::vector<uint8_t> &unpacked) {
+  unpacked.resize(unpacked_size);
+  return lzwexpand(packed.data(), packed.size(), unpacked.data(), unpacked_size) == unpacked_size;
+}
 
-  loptr = (int *)&membuffer[0];
-  membuffer += 8;
+Bitmap *create_lzw_bitmap(std::vector<uint8_t> &unpacked, int dst_bpp) {
+  // unpacked data starts with the line length in bytes and the number of lines
+  if (unpacked.size() < 8)
+    return nullptr;
+  int32_t *loptr = (int32_t *)&unpacked[0];
+  uint8_t *membuffer = &unpacked[8];
 #if AGS_PLATFORM_ENDIAN_BIG
   loptr[0] = BBOp::SwapBytesInt32(loptr[0]);
   loptr[1] = BBOp::SwapBytesInt32(loptr[1]);
-  int bitmapNumPixels = loptr[0]*loptr[1]/ dst_bpp;
+#endif
+  const int line_len = loptr[0];
+  const int height = loptr[1];
+  if (line_len <= 0 || height <= 0 || line_len % dst_bpp != 0 ||
+      (uint64_t)line_len * height > unpacked.size() - 8)
+    return nullptr;
+#if AGS_PLATFORM_ENDIAN_BIG
+  int bitmapNumPixels = line_len * height / dst_bpp;
   switch (dst_bpp) // bytes per pixel!
   {
     case 1:
@@ -370,30 +369,30 @@ void load_lzw(Stream *in, Bitmap **dst_bmp, int dst_bpp, color *pall) {
   }
 #endif // AGS_PLATFORM_ENDIAN_BIG
 
-  update_polled_stuff_if_runtime();
-
-  Bitmap *bmm = BitmapHelper::CreateBitmap((loptr[0] / dst_bpp), loptr[1], dst_bpp * 8);
+  Bitmap *bmm = BitmapHelper::CreateBitmap((line_len / dst_bpp), height, dst_bpp * 8);
   if (bmm == nullptr)
-    quit("!load_room: not enough memory to load room background");
-
-  update_polled_stuff_if_runtime();
+    return nullptr;
 
   bmm->Acquire ();
 
-  for (arin = 0; arin < loptr[1]; arin++)
-    memcpy(&bmm->GetScanLineForWriting(arin)[0], &membuffer[arin * loptr[0]], loptr[0]);
+  for (int arin = 0; arin < height; arin++)
+    memcpy(&bmm->GetScanLineForWriting(arin)[0], &membuffer[arin * line_len], line_len);
 
   bmm->Release ();
+  return bmm;
+}
 
+void load_lzw(Stream *in, Bitmap **dst_bmp, int dst_bpp, color *pall) {
+  std::vector<uint8_t> packed, unpacked;
+  size_t unpacked_size;
+  read_lzw(in, pall, packed, unpacked_size);
   update_polled_stuff_if_runtime();
-
-  free(membuffer-8);
-
-  if (in->GetPosition() != uncompsiz)
-    in->Seek(uncompsiz, kSeekBegin);
-
+  Bitmap *bmm = nullptr;
+  if (unpack_lzw(packed, unpacked_size, unpacked))
+    bmm = create_lzw_bitmap(unpacked, dst_bpp);
+  if (bmm == nullptr)
+    quit("Read error decompressing image - file is corrupt");
   update_polled_stuff_if_runtime();
-
   *dst_bmp = bmm;
 }
 
@@ -410,7 +409,7 @@ void savecompressed_allegro(Stream *out, const Bitmap *bmpp, const color *pall)
   free(wgtbl);
 }
 
-void loadcompressed_allegro(Stream *in, Bitmap **bimpp, color *pall) {
+Bitmap *read_rle_bitmap8(Stream *in, bool poll_game) {
   short widd,hitt;
   int   ii;
 
@@ -418,14 +417,21 @@ void loadcompressed_allegro(Stream *in, Bitmap **bimpp, color *pall) {
   hitt = in->ReadInt16();
   Bitmap *bim = BitmapHelper::CreateBitmap(widd, hitt, 8);
   if (bim == nullptr)
-    quit("!load_room: not enough memory to decompress masks");
+    return nullptr;
 
   for (ii = 0; ii < hitt; ii++) {
     cunpackbitl(&bim->GetScanLineForWriting(ii)[0], widd, in);
-    if (ii % 20 == 0)
+    if (poll_game && ii % 20 == 0)
       update_polled_stuff_if_runtime();
   }
 
   in->Seek(768);  // skip palette
+  return bim;
+}
+
+void loadcompressed_allegro(Stream *in, Bitmap **bimpp, color *pall) {
+  Bitmap *bim = read_rle_bitmap8(in, true);
+  if (bim == nullptr)
+    quit("!load_room: not enough memory to decompress masks");
   *bimpp = bim;
 }
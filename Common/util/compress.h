@@ -15,6 +15,7 @@
 #ifndef __AC_COMPRESS_H
 #define __AC_COMPRESS_H
 
+#include <vector>
 #include "util/wgt2allg.h" // color (allegro RGB)
 
 namespace AGS { namespace Common { class Stream; class Bitmap; } }
@@ -34,7 +35,19 @@ int  cunpackbitl32(uint32_t *line, int size, Common::Stream *in);
 
 void save_lzw(Common::Stream *out, const Common::Bitmap *bmpp, const color *pall);
 void load_lzw(Common::Stream *in, Common::Bitmap **bmm, int dst_bpp, color *pall);
+// Loading LZW-compressed bitmap in steps, for unpacking it on another thread:
+// reads the bitmap's palette and packed data
+void read_lzw(Common::Stream *in, color *pall, std::vector<uint8_t> &packed, size_t &unpacked_size);
+// unpacks the data, returns false if it is corrupt; may be run on any thread
+bool unpack_lzw(const std::vector<uint8_t> &packed, size_t unpacked_size, std::vector<uint8_t> &unpacked);
+// creates bitmap of the unpacked data, returns null if the data is invalid
+// or the bitmap could not be created; may be run on any thread
+Common::Bitmap *create_lzw_bitmap(std::vector<uint8_t> &unpacked, int dst_bpp);
 void savecompressed_allegro(Common::Stream *out, const Common::Bitmap *bmpp, const color *pall);
 void loadcompressed_allegro(Common::Stream *in, Common::Bitmap **bimpp, color *pall);
+// Reads 8-bit RLE-compressed bitmap, returns null if it could not be created;
+// lets the engine handle its events while reading if poll_game is set,
+// otherwise may be run on any thread
+Common::Bitmap *read_rle_bitmap8(Common::Stream *in, bool poll_game);
 
 #endif // __AC_COMPRESS_H
@@ -0,0 +1,230 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "util/decodedcache.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "allegro/file.h"
+#include "util/directory.h"
+#include "util/file.h"
+#include "util/memorymappedstream.h"
+#include "util/path.h"
+#include "util/stream.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+namespace DecodedCache
+{
+
+// Each cache file starts with the signature, key and size of the data
+static const char CacheFileSig[8] = { 'A', 'G', 'S', 'D', 'C', 'A', 'C', '1' };
+static const size_t CacheHeaderSize = 8 + 8 + 8;
+
+// Set once on engine start, before anything is loaded
+static String CacheDir;
+static uint64_t CacheMaxSize;
+// Total size of the cache files, as far as this process knows; other games
+// sharing the directory are only seen when it is scanned again
+static std::atomic<uint64_t> CacheSize(0);
+// Only one thread deletes the old files at a time
+static std::mutex EvictMutex;
+// Makes the names of the files which are being written unique
+static std::atomic<unsigned> TempFileCounter(0);
+
+static String MakeFileName(const char *kind, uint64_t key)
+{
+    return String::FromFormat("%s/%s-%08x%08x.bin", CacheDir.GetCStr(), kind,
+        (unsigned)(key >> 32), (unsigned)(key & 0xFFFFFFFF));
+}
+
+struct CacheFile
+{
+    String  Name;
+    time_t  Time;
+    uint64_t Size;
+};
+
+// Deletes the oldest cache files, until they take at most the given size
+static void Evict(uint64_t keep_size)
+{
+    std::lock_guard<std::mutex> lk(EvictMutex);
+    std::vector<CacheFile> files;
+    uint64_t total_size = 0;
+    al_ffblk ffb;
+    int done = al_findfirst(String::FromFormat("%s/*.bin", CacheDir.GetCStr()), &ffb, FA_ALL & ~FA_DIREC);
+    while (!done)
+    {
+        CacheFile f;
+        f.Name = String::FromFormat("%s/%s", CacheDir.GetCStr(), ffb.name);
+        f.Time = ffb.time;
+        f.Size = al_ffblk_get_size(&ffb);
+        total_size += f.Size;
+        files.push_back(f);
+        done = al_findnext(&ffb);
+    }
+    al_findclose(&ffb);
+
+    std::sort(files.begin(), files.end(),
+        [](const CacheFile &a, const CacheFile &b) { return a.Time < b.Time; });
+    for (const CacheFile &f : files)
+    {
+        if (total_size <= keep_size)
+            break;
+        // the file may still be mapped by a reader, or another process
+        if (File::DeleteFile(f.Name))
+            total_size -= f.Size;
+    }
+    CacheSize = total_size;
+}
+
+bool SetDirectory(const String &path, uint64_t max_size)
+{
+    CacheDir = Path::MakePathNoSlash(path);
+    CacheMaxSize = max_size;
+    if (CacheDir.IsEmpty())
+        return true;
+    if (!Directory::CreateDirectory(CacheDir) || !Path::IsDirectory(CacheDir))
+    {
+        CacheDir.Empty();
+        return false;
+    }
+    Evict(CacheMaxSize);
+    return true;
+}
+
+bool IsEnabled()
+{
+    return !CacheDir.IsEmpty();
+}
+
+static inline uint64_t Rotl64(uint64_t v, int r)
+{
+    return (v << r) | (v >> (64 - r));
+}
+
+static inline uint64_t Mix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t Hash(const void *data, size_t size, uint64_t seed)
+{
+    const uint64_t k1 = 0x87C37B91114253D5ull;
+    const uint64_t k2 = 0x4CF5AD432745937Full;
+    const uint8_t *p = (const uint8_t*)data;
+    uint64_t h = seed ^ ((uint64_t)size * k1);
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        h ^= Rotl64(v * k1, 31) * k2;
+        h = Rotl64(h, 27) * 5 + 0x52DCE729;
+    }
+    uint64_t tail = 0;
+    for (size_t i = 0; i < size; ++i)
+        tail |= (uint64_t)p[i] << (i * 8);
+    h ^= Rotl64(tail * k1, 31) * k2;
+    return Mix64(h);
+}
+
+bool Find(const char *kind, uint64_t key, CachedData &data)
+{
+    data = CachedData();
+    if (CacheDir.IsEmpty())
+        return false;
+    String filename = MakeFileName(kind, key);
+    const uint8_t *file_data;
+    size_t file_size;
+    std::shared_ptr<MappedFile> file = MappedFile::Map(filename);
+    if (file)
+    {
+        file_data = file->GetData();
+        file_size = (size_t)file->GetSize();
+    }
+    else
+    {
+        // system cannot map files, read it instead
+        std::unique_ptr<Stream> in(File::OpenFileRead(filename));
+        if (!in)
+            return false;
+        data.Buffer.resize((size_t)in->GetLength());
+        data.Buffer.resize(in->Read(data.Buffer.data(), data.Buffer.size()));
+        file_data = data.Buffer.data();
+        file_size = data.Buffer.size();
+    }
+
+    uint64_t file_key, data_size;
+    if (file_size < CacheHeaderSize || memcmp(file_data, CacheFileSig, sizeof(CacheFileSig)) != 0)
+        return false;
+    memcpy(&file_key, file_data + 8, 8);
+    memcpy(&data_size, file_data + 16, 8);
+    // the file may be cut short if the game was closed while writing it
+    if (file_key != key || data_size != file_size - CacheHeaderSize)
+        return false;
+    data.File = file;
+    data.Data = file_data + CacheHeaderSize;
+    data.Size = (size_t)data_size;
+    return true;
+}
+
+bool Store(const char *kind, uint64_t key, const void *data, size_t size)
+{
+    if (CacheDir.IsEmpty())
+        return false;
+    // the file is written under a temporary name and then renamed, so that
+    // it is never found incomplete
+    String filename = MakeFileName(kind, key);
+    String temp_filename = String::FromFormat("%s.%u.tmp", filename.GetCStr(), TempFileCounter++);
+    std::unique_ptr<Stream> out(File::CreateFile(temp_filename));
+    if (!out)
+        return false;
+    uint64_t data_size = size;
+    out->Write(CacheFileSig, sizeof(CacheFileSig));
+    out->Write(&key, 8);
+    out->Write(&data_size, 8);
+    bool ok = out->Write(data, size) == size;
+    out.reset();
+    if (ok)
+    {
+        ok = rename(temp_filename.GetCStr(), filename.GetCStr()) == 0;
+        // rename does not replace the existing files on some systems
+        if (!ok && File::DeleteFile(filename))
+            ok = rename(temp_filename.GetCStr(), filename.GetCStr()) == 0;
+    }
+    if (!ok)
+    {
+        File::DeleteFile(temp_filename);
+        return false;
+    }
+    // leave some room, so that the directory is not scanned on every write
+    if ((CacheSize += CacheHeaderSize + size) > CacheMaxSize)
+        Evict(CacheMaxSize - CacheMaxSize / 4);
+    return true;
+}
+
+} // namespace DecodedCache
+
+} // namespace Common
+} // namespace AGS
@@ -0,0 +1,69 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Decoded data cache keeps the results of unpacking the game's assets in
+// files of its own directory, so that the next time the same data is needed
+// it is mapped into memory instead of being unpacked again. Entries are
+// found by the kind of data and a key, which is normally the hash of the
+// packed data, so the same data is found in any room or game.
+//
+// The cache directory is limited in size: when the files written there
+// exceed the limit, the oldest of them are deleted.
+//
+// The cache may be used from any thread.
+//
+//=============================================================================
+#ifndef __AGS_CN_UTIL__DECODEDCACHE_H
+#define __AGS_CN_UTIL__DECODEDCACHE_H
+
+#include <memory>
+#include <vector>
+#include "util/string.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+class MappedFile;
+
+// Cached data, valid while this object exists
+struct CachedData
+{
+    const uint8_t *Data = nullptr;
+    size_t  Size = 0;
+    // the mapped file, or the buffer when the file could not be mapped
+    std::shared_ptr<MappedFile> File;
+    std::vector<uint8_t> Buffer;
+};
+
+namespace DecodedCache
+{
+    // Sets the directory for the cache files, creating it if needed, and
+    // the size limit for them in bytes; empty path disables the cache.
+    // Returns false if the directory cannot be used.
+    bool        SetDirectory(const String &path, uint64_t max_size);
+    bool        IsEnabled();
+    // Calculates the hash of the data, for making the keys
+    uint64_t    Hash(const void *data, size_t size, uint64_t seed = 0);
+    // Finds the cached data of the given kind; returns false if there is none
+    bool        Find(const char *kind, uint64_t key, CachedData &data);
+    // Writes the data to the cache, replacing any existing entry
+    bool        Store(const char *kind, uint64_t key, const void *data, size_t size);
+} // namespace DecodedCache
+
+} // namespace Common
+} // namespace AGS
+
+#endif // __AGS_CN_UTIL__DECODEDCACHE_H
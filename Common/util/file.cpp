@@ -155,12 +155,23 @@ String File::GetCMode(FileOpenMode open_mode, FileWorkMode work_mode)
     return mode;
 }
 
+static bool ReadAhead = false;
+
+void File::SetReadAhead(bool on)
+{
+    ReadAhead = on;
+}
+
 Stream *File::OpenFile(const String &filename, FileOpenMode open_mode, FileWorkMode work_mode)
 {
     FileStream *fs = nullptr;
     try {
-        fs = new FileStream(filename, open_mode, work_mode);
-        //fs = new BufferedStream(filename, open_mode, work_mode);
+        // only the files opened for reading are buffered, because
+        // BufferedStream passes writes straight to the file
+        if (open_mode == kFile_Open && work_mode == kFile_Read)
+            fs = new BufferedStream(filename, open_mode, work_mode, kLittleEndian, ReadAhead);
+        else
+            fs = new FileStream(filename, open_mode, work_mode);
         if (fs != nullptr && !fs->IsValid()) {
             delete fs;
             fs = nullptr;
@@ -61,6 +61,9 @@ namespace File
     // Gets C-style file mode from FileOpenMode and FileWorkMode
     String      GetCMode(FileOpenMode open_mode, FileWorkMode work_mode);
 
+    // Sets whether the files opened for reading should read ahead on a background thread
+    void        SetReadAhead(bool on);
+
     Stream      *OpenFile(const String &filename, FileOpenMode open_mode, FileWorkMode work_mode);
     // Convenience helpers
     // Create a totally new file, overwrite existing one
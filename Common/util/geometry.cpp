@@ -12,6 +12,7 @@
 //
 //=============================================================================
 #include "util/geometry.h"
+#include <algorithm>
 
 //namespace AGS
 //{
@@ -97,6 +98,27 @@ Rect ClampToRect(const Rect &place, const Rect &item)
     );
 }
 
+Rect UnionRects(const Rect &r1, const Rect &r2)
+{
+    if (r1.IsEmpty())
+        return r2;
+    if (r2.IsEmpty())
+        return r1;
+    return Rect(
+        std::min(r1.Left, r2.Left), std::min(r1.Top, r2.Top),
+        std::max(r1.Right, r2.Right), std::max(r1.Bottom, r2.Bottom));
+}
+
+Rect IntersectRects(const Rect &r1, const Rect &r2)
+{
+    Rect r(
+        std::max(r1.Left, r2.Left), std::max(r1.Top, r2.Top),
+        std::min(r1.Right, r2.Right), std::min(r1.Bottom, r2.Bottom));
+    if (r.IsEmpty())
+        return Rect();
+    return r;
+}
+
 Rect PlaceInRect(const Rect &place, const Rect &item, const RectPlacement &placement)
 {
     switch (placement)
@@ -18,6 +18,7 @@
 #ifndef __AGS_CN_UTIL__GEOMETRY_H
 #define __AGS_CN_UTIL__GEOMETRY_H
 
+#include <math.h>
 #include "util/math.h"
 
 namespace AGSMath = AGS::Common::Math;
@@ -396,7 +397,63 @@ Size ProportionalStretch(const Size &dest, const Size &item);
 Rect OffsetRect(const Rect &r, const Point off);
 Rect CenterInRect(const Rect &place, const Rect &item);
 Rect ClampToRect(const Rect &place, const Rect &item);
+// Returns the smallest rectangle containing both; empty rectangles are ignored
+Rect UnionRects(const Rect &r1, const Rect &r2);
+// Returns the overlapping part of two rectangles, or empty rectangle if there's none
+Rect IntersectRects(const Rect &r1, const Rect &r2);
 Rect PlaceInRect(const Rect &place, const Rect &item, const RectPlacement &placement);
+
+// Looks among the points (x1 + i * step, y1 + j * step) inside [x1, x2) x [y1, y2)
+// for the one accepted by the test and nearest to the destination, with the
+// distance truncated to whole pixels. Of the equally near points returns the
+// one with the lowest x, then lowest y, which is what a column by column scan
+// of the grid keeping the first nearest point finds. The grid is searched in
+// rings around the destination, so the cost depends on how far the result is.
+template <typename TTest>
+bool FindNearestGridPoint(int x1, int y1, int x2, int y2, int step,
+    int dest_x, int dest_y, TTest test, int &near_x, int &near_y)
+{
+    if ((x2 <= x1) || (y2 <= y1) || (step <= 0))
+        return false;
+    const int cols = (x2 - x1 + step - 1) / step;
+    const int rows = (y2 - y1 + step - 1) / step;
+    // grid cell containing destination, or the closest one if it's outside
+    const int ci = dest_x < x1 ? 0 : AGSMath::Min((dest_x - x1) / step, cols - 1);
+    const int cj = dest_y < y1 ? 0 : AGSMath::Min((dest_y - y1) / step, rows - 1);
+    int nearest = -1;
+    for (int r = 0; ; ++r)
+    {
+        // points of this ring are at least (r - 1) * step away
+        if ((nearest >= 0) && ((r - 1) * step >= nearest + 1))
+            break;
+        const int i1 = ci - r, i2 = ci + r, j1 = cj - r, j2 = cj + r;
+        if ((i1 < 0) && (i2 >= cols) && (j1 < 0) && (j2 >= rows))
+            break;
+        for (int i = AGSMath::Max(i1, 0); i <= AGSMath::Min(i2, cols - 1); ++i)
+        {
+            const bool full_col = (i == i1) || (i == i2);
+            const int jstep = full_col ? 1 : (j2 - j1);
+            for (int j = full_col ? AGSMath::Max(j1, 0) : j1;
+                 j <= AGSMath::Min(j2, rows - 1); j += AGSMath::Max(jstep, 1))
+            {
+                if (j < 0)
+                    continue;
+                const int x = x1 + i * step, y = y1 + j * step;
+                if (!test(x, y))
+                    continue;
+                const int dist = (int)sqrt((double)((x - dest_x) * (x - dest_x) + (y - dest_y) * (y - dest_y)));
+                if ((nearest < 0) || (dist < nearest) ||
+                    ((dist == nearest) && ((x < near_x) || ((x == near_x) && (y < near_y)))))
+                {
+                    nearest = dist;
+                    near_x = x;
+                    near_y = y;
+                }
+            }
+        }
+    }
+    return nearest >= 0;
+}
 //} // namespace Common
 //} // namespace AGS
 
@@ -17,6 +17,8 @@
 //=============================================================================
 
 #include <stdlib.h>
+#include <string.h>
+#include "util/lzw.h"
 #include "ac/common.h" // quit
 #include "util/stream.h"
 
@@ -44,7 +46,7 @@ void _delete(int);
 char *lzbuffer;
 int *node;
 int pos;
-long outbytes = 0, maxsize = 0, putbytes = 0;
+long outbytes = 0;
 
 int insert(int i, int run)
 {
@@ -192,80 +194,79 @@ void lzwcompress(Stream *lzw_in, Stream *out)
   free(lzbuffer);
 }
 
-int expand_to_mem = 0;
-unsigned char *membfptr = nullptr;
-void myputc(int ccc, Stream *out)
+// Copies a back reference from the already unpacked data. The format's
+// window starts zeroed, so the part of the reference which falls before
+// the start of the output gives zeroes.
+static inline uint8_t *lzwcopyref(uint8_t *dst, const uint8_t *dst_start, size_t dist, size_t len)
 {
-  if (maxsize > 0) {
-    putbytes++;
-    if (putbytes > maxsize)
-      return;
+  const size_t done = dst - dst_start;
+  if (dist > done) {
+    const size_t zeros = min(dist - done, len);
+    memset(dst, 0, zeros);
+    dst += zeros;
+    len -= zeros;
   }
-
-  outbytes++;
-  if (expand_to_mem) {
-    membfptr[0] = ccc;
-    membfptr++;
-  } else
-    out->WriteInt8(ccc);
+  const uint8_t *ref = dst - dist;
+  if (dist >= len) {
+    memcpy(dst, ref, len);
+    return dst + len;
+  }
+  // overlapping reference repeats the last dist bytes
+  while (len--)
+    *dst++ = *ref++;
+  return dst;
 }
 
-void lzwexpand(Stream *lzw_in, Stream *out)
+size_t lzwexpand(const uint8_t *src, size_t src_sz, uint8_t *dst, size_t dst_sz)
 {
-  int bits, ch, i, j, len, mask;
-  char *lzbuffer;
-//  printf(" UnShrinking: %s ",filena);
-  putbytes = 0;
-
-  lzbuffer = (char *)malloc(N);
-  if (lzbuffer == nullptr) {
-    quit("compress.cpp: unable to decompress: insufficient memory");
-  }
-  i = N - F;
-
-  // this end condition just checks for EOF, which is no good to us
-  while ((bits = lzw_in->ReadByte()) != -1) {
-    for (mask = 0x01; mask & 0xFF; mask <<= 1) {
-      if (bits & mask) {
-        // MACPORT FIX: read to short and expand
-        short jshort = 0;
-        jshort = lzw_in->ReadInt16();
-        j = jshort;
-
-        len = ((j >> 12) & 15) + 3;
-        j = (i - j - 1) & (N - 1);
-
-        while (len--) {
-          myputc(lzbuffer[i] = lzbuffer[j], out);
-          j = (j + 1) & (N - 1);
-          i = (i + 1) & (N - 1);
+  // The window is the last N bytes of the output, and all the output is in
+  // the destination buffer, so the references are copied straight from it.
+  // Uses no shared state, so that several images may be unpacked at once.
+  const uint8_t *src_end = src + src_sz;
+  uint8_t *const dst_start = dst;
+  uint8_t *const dst_end = dst + dst_sz;
+  const size_t max_len = F + THRESHOLD - 1;
+
+  while ((src < src_end) && (dst < dst_end)) {
+    unsigned bits = *src++;
+    // a group of 8 tokens takes up to 16 bytes of input and 8 max_len bytes
+    // of output; when both fit, the group is unpacked without bound checks
+    if ((src_end - src >= 16) && ((size_t)(dst_end - dst) >= 8 * max_len)) {
+      for (int k = 0; k < 8; ++k, bits >>= 1) {
+        if (bits & 1) {
+          const unsigned j = src[0] | (src[1] << 8);
+          src += 2;
+          const size_t len = (j >> 12) + THRESHOLD;
+          const size_t dist = (j & (N - 1)) + 1;
+          if (dist >= max_len && dist <= (size_t)(dst - dst_start)) {
+            // copy the whole max length, the extra bytes are overwritten later
+            memcpy(dst, dst - dist, max_len);
+            dst += len;
+          } else {
+            dst = lzwcopyref(dst, dst_start, dist, len);
+          }
+        } else {
+          *dst++ = *src++;
         }
-      } else {
-        ch = lzw_in->ReadByte();
-        myputc(lzbuffer[i] = ch, out);
-        i = (i + 1) & (N - 1);
       }
+      continue;
+    }
 
-      if ((putbytes >= maxsize) && (maxsize > 0))
-        break;
-
-      if ((lzw_in->EOS()) && (maxsize > 0))
-        quit("Read error decompressing image - file is corrupt");
-    }                           // end for mask
-
-    if ((putbytes >= maxsize) && (maxsize > 0))
-      break;
+    for (int k = 0; (k < 8) && (dst < dst_end); ++k, bits >>= 1) {
+      if (bits & 1) {
+        if (src_end - src < 2)
+          return dst - dst_start; // data is cut short
+        const unsigned j = src[0] | (src[1] << 8);
+        src += 2;
+        const size_t len = (j >> 12) + THRESHOLD;
+        const size_t dist = (j & (N - 1)) + 1;
+        dst = lzwcopyref(dst, dst_start, dist, min(len, (size_t)(dst_end - dst)));
+      } else {
+        if (src == src_end)
+          return dst - dst_start; // data is cut short
+        *dst++ = *src++;
+      }
+    }
   }
-
-  free(lzbuffer);
-  expand_to_mem = 0;
-}
-
-unsigned char *lzwexpand_to_mem(Stream *in)
-{
-  unsigned char *membuff = (unsigned char *)malloc(maxsize + 10);
-  expand_to_mem = 1;
-  membfptr = membuff;
-  lzwexpand(in, nullptr);
-  return membuff;
+  return dst - dst_start;
 }
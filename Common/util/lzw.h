@@ -18,12 +18,18 @@
 #ifndef __AGS_CN_UTIL__LZW_H
 #define __AGS_CN_UTIL__LZW_H
 
+#include <stddef.h>
+#include "core/types.h"
+
 namespace AGS { namespace Common { class Stream; } }
 using namespace AGS; // FIXME later
 
 void lzwcompress(Common::Stream *lzw_in, Common::Stream *out);
-unsigned char *lzwexpand_to_mem(Common::Stream *in);
+// Unpacks the data into the given buffer, up to its size; returns number of
+// bytes written, which is less than the buffer size if the data is cut short.
+// Uses no shared state, so may be run on several threads at once.
+size_t lzwexpand(const uint8_t *src, size_t src_sz, uint8_t *dst, size_t dst_sz);
 
-extern long outbytes, maxsize, putbytes;
+extern long outbytes;
 
 #endif // __AGS_CN_UTIL__LZW_H
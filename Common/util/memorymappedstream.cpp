@@ -0,0 +1,290 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "util/memorymappedstream.h"
+
+#include <string.h>
+#include <algorithm>
+#if AGS_PLATFORM_OS_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif AGS_PLATFORM_OS_LINUX || AGS_PLATFORM_OS_MACOS || AGS_PLATFORM_OS_ANDROID || AGS_PLATFORM_OS_IOS
+#define AGS_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AGS
+{
+namespace Common
+{
+
+MappedFile::~MappedFile()
+{
+#if AGS_PLATFORM_OS_WINDOWS
+    if (_view)
+        UnmapViewOfFile(_view);
+    if (_mapHandle)
+        CloseHandle((HANDLE)_mapHandle);
+    if (_fileHandle)
+        CloseHandle((HANDLE)_fileHandle);
+#elif defined (AGS_HAS_MMAP)
+    if (_view)
+        munmap((void*)_view, _viewSize);
+#endif
+}
+
+// Fits the requested part into the file, and finds where the view must
+// begin to be aligned by the given granularity; returns false if there's
+// nothing to map, or the view would not fit into the address space
+static bool GetMappedRange(uint64_t file_size, uint64_t granularity, soff_t &offset, soff_t &size,
+                           uint64_t &view_offset, size_t &view_size)
+{
+    if (offset < 0 || (uint64_t)offset >= file_size)
+        return false;
+    if (size < 0 || (uint64_t)size > file_size - offset)
+        size = (soff_t)(file_size - offset);
+    if (size == 0)
+        return false;
+    view_offset = granularity > 0 ? (uint64_t)offset - (uint64_t)offset % granularity : (uint64_t)offset;
+    const uint64_t view_size64 = (uint64_t)offset - view_offset + (uint64_t)size;
+    if (view_size64 > (uint64_t)SIZE_MAX)
+        return false;
+    view_size = (size_t)view_size64;
+    return true;
+}
+
+std::shared_ptr<MappedFile> MappedFile::Map(const String &file_name, soff_t offset, soff_t size)
+{
+    std::shared_ptr<MappedFile> mf(new MappedFile());
+    uint64_t view_offset;
+    size_t view_size;
+#if AGS_PLATFORM_OS_WINDOWS
+    HANDLE file = CreateFileA(file_name.GetCStr(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+    mf->_fileHandle = file;
+    LARGE_INTEGER file_size;
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    if (!GetFileSizeEx(file, &file_size) ||
+        !GetMappedRange((uint64_t)file_size.QuadPart, si.dwAllocationGranularity, offset, size, view_offset, view_size))
+        return nullptr;
+    HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!map)
+        return nullptr;
+    mf->_mapHandle = map;
+    const void *view = MapViewOfFile(map, FILE_MAP_READ,
+        (DWORD)(view_offset >> 32), (DWORD)(view_offset & 0xFFFFFFFF), view_size);
+    if (!view)
+        return nullptr;
+#elif defined (AGS_HAS_MMAP)
+    int fd = open(file_name.GetCStr(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat st;
+    const long page = sysconf(_SC_PAGESIZE);
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        !GetMappedRange((uint64_t)st.st_size, page > 0 ? (uint64_t)page : 0, offset, size, view_offset, view_size))
+    {
+        close(fd);
+        return nullptr;
+    }
+    void *view = mmap(nullptr, view_size, PROT_READ, MAP_PRIVATE, fd, (off_t)view_offset);
+    // the mapping stays valid after the file is closed
+    close(fd);
+    if (view == MAP_FAILED)
+        return nullptr;
+#else
+    (void)file_name; (void)offset; (void)size; (void)view_offset; (void)view_size;
+    return nullptr;
+#endif
+#if AGS_PLATFORM_OS_WINDOWS || defined (AGS_HAS_MMAP)
+    mf->_view = view;
+    mf->_viewSize = view_size;
+    mf->_data = (const uint8_t*)view + (offset - (soff_t)view_offset);
+    mf->_offset = offset;
+    mf->_size = size;
+    return mf;
+#endif
+}
+
+void MappedFile::Advise(soff_t offset, soff_t size, MappedAccess access) const
+{
+#if defined (AGS_HAS_MMAP)
+    // the range is given in file, and is limited by the mapped part
+    if (offset < _offset)
+    {
+        size -= _offset - offset;
+        offset = _offset;
+    }
+    offset -= _offset;
+    if (offset >= _size || size <= 0)
+        return;
+    if (size > _size - offset)
+        size = _size - offset;
+    int advice;
+    switch (access)
+    {
+    case kMappedAccess_Sequential: advice = MADV_SEQUENTIAL; break;
+    case kMappedAccess_Random:     advice = MADV_RANDOM; break;
+    case kMappedAccess_WillNeed:   advice = MADV_WILLNEED; break;
+    default:                       advice = MADV_NORMAL; break;
+    }
+    // the range must start at the page boundary, which the view starts at
+    const uint8_t *start = _data + offset;
+    const size_t skip = (size_t)(start - (const uint8_t*)_view) % (size_t)std::max<long>(sysconf(_SC_PAGESIZE), 1);
+    madvise((void*)(start - skip), (size_t)size + skip, advice);
+#else
+    (void)offset; (void)size; (void)access;
+#endif
+}
+
+
+MemoryMappedStream::MemoryMappedStream(std::shared_ptr<MappedFile> file, soff_t offset, soff_t size,
+        DataEndianess stream_endianess)
+    : DataStream(stream_endianess)
+    , _file(file)
+    , _begin(0)
+    , _end(0)
+    , _pos(offset)
+    , _eos(false)
+{
+    if (_file)
+    {
+        const soff_t mapped_end = _file->GetOffset() + _file->GetSize();
+        _begin = std::min(std::max(offset, _file->GetOffset()), mapped_end);
+        _end = size < 0 ? mapped_end : std::max(std::min(offset + size, mapped_end), _begin);
+    }
+}
+
+MemoryMappedStream::~MemoryMappedStream()
+{
+    MemoryMappedStream::Close();
+}
+
+void MemoryMappedStream::Close()
+{
+    _file.reset();
+    _pos = 0;
+}
+
+bool MemoryMappedStream::Flush()
+{
+    return false;
+}
+
+bool MemoryMappedStream::IsValid() const
+{
+    return _file != nullptr;
+}
+
+bool MemoryMappedStream::EOS() const
+{
+    return !IsValid() || _eos;
+}
+
+soff_t MemoryMappedStream::GetLength() const
+{
+    return IsValid() ? _end : 0;
+}
+
+soff_t MemoryMappedStream::GetPosition() const
+{
+    return IsValid() ? _pos : -1;
+}
+
+bool MemoryMappedStream::CanRead() const
+{
+    return IsValid();
+}
+
+bool MemoryMappedStream::CanWrite() const
+{
+    return false;
+}
+
+bool MemoryMappedStream::CanSeek() const
+{
+    return IsValid();
+}
+
+size_t MemoryMappedStream::Read(void *buffer, size_t size)
+{
+    if (!_file || !buffer)
+        return 0;
+    // data before the range cannot be read
+    if (_pos < _begin)
+        return 0;
+    const soff_t avail = _pos < _end ? _end - _pos : 0;
+    if ((soff_t)size > avail)
+    {
+        size = (size_t)avail;
+        _eos = true;
+    }
+    if (size > 0)
+        memcpy(buffer, _file->GetData() + (_pos - _file->GetOffset()), size);
+    _pos += size;
+    return size;
+}
+
+int32_t MemoryMappedStream::ReadByte()
+{
+    if (!_file)
+        return -1;
+    if (_pos < _begin)
+        return -1;
+    if (_pos >= _end)
+    {
+        _eos = true;
+        return -1;
+    }
+    return _file->GetData()[_pos++ - _file->GetOffset()];
+}
+
+size_t MemoryMappedStream::Write(const void *buffer, size_t size)
+{
+    return 0;
+}
+
+int32_t MemoryMappedStream::WriteByte(uint8_t b)
+{
+    return -1;
+}
+
+bool MemoryMappedStream::Seek(soff_t offset, StreamSeek origin)
+{
+    if (!_file)
+        return false;
+    soff_t pos;
+    switch (origin)
+    {
+    case kSeekBegin:    pos = offset; break;
+    case kSeekCurrent:  pos = _pos + offset; break;
+    case kSeekEnd:      pos = GetLength() + offset; break;
+    default:
+        return false;
+    }
+    // like with files, seeking past the end is allowed, but not before the start
+    if (pos < 0)
+        return false;
+    _pos = pos;
+    _eos = false;
+    return true;
+}
+
+} // namespace Common
+} // namespace AGS
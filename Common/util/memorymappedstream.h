@@ -0,0 +1,115 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// MappedFile is a part of file (or the whole file) mapped into memory for
+// reading. MemoryMappedStream reads a range of the MappedFile, which it shares
+// with other streams; it behaves like a FileStream opened for reading, with
+// the positions counted from the beginning of file, except that it cannot
+// read outside of its range.
+//
+//=============================================================================
+#ifndef __AGS_CN_UTIL__MEMORYMAPPEDSTREAM_H
+#define __AGS_CN_UTIL__MEMORYMAPPEDSTREAM_H
+
+#include <memory>
+#include "core/platform.h"
+#include "util/datastream.h"
+#include "util/string.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+enum MappedAccess
+{
+    kMappedAccess_Normal,
+    kMappedAccess_Sequential,
+    kMappedAccess_Random,
+    kMappedAccess_WillNeed
+};
+
+class MappedFile
+{
+public:
+    ~MappedFile();
+
+    // Maps the given part of file for reading, or the whole file if the size
+    // is negative; returns null if it cannot be mapped
+    static std::shared_ptr<MappedFile> Map(const String &file_name, soff_t offset = 0, soff_t size = -1);
+
+    // Mapped data, which begins at the given offset in file
+    inline const uint8_t *GetData() const { return _data; }
+    inline soff_t GetOffset() const { return _offset; }
+    inline soff_t GetSize() const { return _size; }
+    // Hints the system on how the given range of file is going to be read
+    void Advise(soff_t offset, soff_t size, MappedAccess access) const;
+
+private:
+    MappedFile() = default;
+
+    // the view begins at the page boundary, which may be before the data
+    const void *_view = nullptr;
+    size_t  _viewSize = 0;
+    const uint8_t *_data = nullptr;
+    soff_t  _offset = 0;
+    soff_t  _size = 0;
+#if AGS_PLATFORM_OS_WINDOWS
+    void   *_fileHandle = nullptr;
+    void   *_mapHandle = nullptr;
+#endif
+};
+
+class MemoryMappedStream : public DataStream
+{
+public:
+    // Makes a stream over the given range of the mapped file, or over all of
+    // the mapped part if the size is negative; the stream is positioned at
+    // the range's offset
+    MemoryMappedStream(std::shared_ptr<MappedFile> file, soff_t offset = 0, soff_t size = -1,
+        DataEndianess stream_endianess = kLittleEndian);
+    ~MemoryMappedStream() override;
+
+    void    Close() override;
+    bool    Flush() override;
+
+    bool    IsValid() const override;
+    bool    EOS() const override;
+    soff_t  GetLength() const override;
+    soff_t  GetPosition() const override;
+    bool    CanRead() const override;
+    bool    CanWrite() const override;
+    bool    CanSeek() const override;
+
+    size_t  Read(void *buffer, size_t size) override;
+    int32_t ReadByte() override;
+    size_t  Write(const void *buffer, size_t size) override;
+    int32_t WriteByte(uint8_t b) override;
+
+    bool    Seek(soff_t offset, StreamSeek origin) override;
+
+private:
+    std::shared_ptr<MappedFile> _file;
+    // readable range in file, within the mapped part
+    soff_t  _begin;
+    soff_t  _end;
+    soff_t  _pos;
+    // set when the read hit the end of data, like the end-of-file flag
+    bool    _eos;
+};
+
+} // namespace Common
+} // namespace AGS
+
+#endif // __AGS_CN_UTIL__MEMORYMAPPEDSTREAM_H
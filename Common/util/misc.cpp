@@ -79,14 +79,110 @@ char *ci_find_file(const char *dir_name, const char *file_name)
   return diamond;
 }
 
+void ci_reset_file_index()
+{
+}
+
 #else
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Listing of a directory made for the case-insensitive lookups. It is read
+// once and then reused for as long as the directory's modification time
+// stays the same.
+struct DirIndex
+{
+  time_t MTime = 0;
+  time_t ScanTime = 0;
+  std::unordered_map<std::string, std::string> Files; // lowercase name to real name
+};
+
+static std::mutex dir_index_mutex;
+static std::unordered_map<std::string, DirIndex> dir_index;
+
+static std::string make_lowercase(const char *str)
+{
+  std::string lower(str);
+  for (char &c : lower)
+    c = tolower((unsigned char)c);
+  return lower;
+}
+
+// Fills index with the regular files and links found in the directory
+static bool scan_directory(const char *directory, DirIndex &index)
+{
+  DIR *rough = opendir(directory);
+  if (rough == nullptr)
+    return false;
+  std::string path = directory;
+  path += '/';
+  const size_t dir_len = path.size();
+  struct dirent *entry;
+  struct stat statbuf;
+  while ((entry = readdir(rough)) != nullptr) {
+    path.resize(dir_len);
+    path += entry->d_name;
+    if (lstat(path.c_str(), &statbuf) != 0)
+      continue;
+    // if names differ only by case, the first one listed is used, like before
+    if (S_ISREG(statbuf.st_mode) || S_ISLNK(statbuf.st_mode))
+      index.Files.insert(std::make_pair(make_lowercase(entry->d_name), std::string(entry->d_name)));
+  }
+  closedir(rough);
+  return true;
+}
+
+// Returns the actual name of the file in the directory, or empty string
+static std::string find_in_directory(const char *directory, const char *filename)
+{
+  struct stat dirstat;
+  if (stat(directory, &dirstat) != 0 || !S_ISDIR(dirstat.st_mode)) {
+    fprintf(stderr, "ci_find_file: cannot open directory: %s\n", directory);
+    return std::string();
+  }
+
+  std::string dir_path;
+  if (directory[0] != '/') {
+    char cwd[PATH_MAX];
+    if (getcwd(cwd, sizeof(cwd)) != nullptr) {
+      dir_path = cwd;
+      dir_path += '/';
+    }
+  }
+  dir_path += directory;
+
+  std::lock_guard<std::mutex> lock(dir_index_mutex);
+  DirIndex &index = dir_index[dir_path];
+  // modification time has a granularity of a second, so if the directory
+  // was changed in the same second when it was scanned, it is scanned again
+  if ((index.ScanTime == 0) || (index.MTime != dirstat.st_mtime) || (index.MTime >= index.ScanTime)) {
+    index.Files.clear();
+    index.MTime = dirstat.st_mtime;
+    index.ScanTime = time(nullptr);
+    if (!scan_directory(directory, index)) {
+      fprintf(stderr, "ci_find_file: cannot open directory: %s\n", directory);
+      dir_index.erase(dir_path);
+      return std::string();
+    }
+  }
+  auto it = index.Files.find(make_lowercase(filename));
+  return it != index.Files.end() ? it->second : std::string();
+}
+
+void ci_reset_file_index()
+{
+  std::lock_guard<std::mutex> lock(dir_index_mutex);
+  dir_index.clear();
+}
+
 /* Case Insensitive File Find */
 char *ci_find_file(const char *dir_name, const char *file_name)
 {
-  struct stat   statbuf;
-  struct dirent *entry     = nullptr;
-  DIR           *rough     = nullptr;
-  DIR           *prevdir   = nullptr;
   char          *diamond   = nullptr;
   char          *directory = nullptr;
   char          *filename  = nullptr;
@@ -116,8 +212,10 @@ char *ci_find_file(const char *dir_name, const char *file_name)
     int   dir_len   = 0;
 
     match = get_filename(filename);
-    if (match == nullptr)
+    if (match == nullptr) {
+      free(filename);
       return nullptr;
+    }
 
     match_len = strlen(match);
     dir_len   = (match - filename);
@@ -127,47 +225,23 @@ char *ci_find_file(const char *dir_name, const char *file_name)
       strcpy(directory,".");
     } else {
       directory = (char *)malloc(dir_len + 1);
-      strncpy(directory, file_name, dir_len);
+      strncpy(directory, filename, dir_len);
       directory[dir_len] = '\0';
     }
 
-    filename = (char *)malloc(match_len + 1);
-    strncpy(filename, match, match_len);
-    filename[match_len] = '\0';
+    memmove(filename, match, match_len + 1);
   }
 
-  if ((prevdir = opendir(".")) == nullptr) {
-    fprintf(stderr, "ci_find_file: cannot open current working directory\n");
-    return nullptr;
-  }
-
-  if (chdir(directory) == -1) {
-    fprintf(stderr, "ci_find_file: cannot change to directory: %s\n", directory);
-    return nullptr;
-  }
-  
-  if ((rough = opendir(directory)) == nullptr) {
-    fprintf(stderr, "ci_find_file: cannot open directory: %s\n", directory);
-    return nullptr;
-  }
-
-  while ((entry = readdir(rough)) != nullptr) {
-    lstat(entry->d_name, &statbuf);
-    if (S_ISREG(statbuf.st_mode) || S_ISLNK(statbuf.st_mode)) {
-      if (strcasecmp(filename, entry->d_name) == 0) {
+  if (filename != nullptr) {
+    std::string found = find_in_directory(directory, filename);
+    if (!found.empty()) {
 #if AGS_PLATFORM_DEBUG
-        fprintf(stderr, "ci_find_file: Looked for %s in rough %s, found diamond %s.\n", filename, directory, entry->d_name);
+      fprintf(stderr, "ci_find_file: Looked for %s in rough %s, found diamond %s.\n", filename, directory, found.c_str());
 #endif // AGS_PLATFORM_DEBUG
-        diamond = (char *)malloc(strlen(directory) + strlen(entry->d_name) + 2);
-        append_filename(diamond, directory, entry->d_name, strlen(directory) + strlen(entry->d_name) + 2);
-        break;
-      }
+      diamond = (char *)malloc(strlen(directory) + found.size() + 2);
+      append_filename(diamond, directory, found.c_str(), strlen(directory) + found.size() + 2);
     }
   }
-  closedir(rough);
-
-  fchdir(dirfd(prevdir));
-  closedir(prevdir);
 
   free(directory);
   free(filename);
@@ -60,6 +60,10 @@ Common::Stream *ci_fopen(const char *file_name,
                              Common::FileWorkMode work_mode = Common::kFile_Read);
 // TODO: return String object
 char *ci_find_file(const char *dir_name, const char *file_name);
+// Case-sensitive systems keep listings of the searched directories, which
+// are read again when the directory's modification time changes; this
+// function discards them all, forcing directories to be read again.
+void ci_reset_file_index();
 
 
 #endif  // __MISC_H
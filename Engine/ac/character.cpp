@@ -51,6 +51,7 @@
 #include "main/update.h"
 #include "ac/spritecache.h"
 #include "util/string_compat.h"
+#include "util/geometry.h"
 #include <math.h>
 #include "gfx/graphicsdriver.h"
 #include "script/runtimescriptvalue.h"
@@ -158,11 +159,18 @@ void Character_AddInventory(CharacterInfo *chaa, ScriptInvItem *invi, int addInd
 
 }
 
+// Makes sure that the character's movelist holds the real route
+static void wait_character_route(CharacterInfo *chaa) {
+    if (is_route_requested(chaa->index_id + CHMLSOFFS))
+        complete_character_walks();
+}
+
 void Character_AddWaypoint(CharacterInfo *chaa, int x, int y) {
 
     if (chaa->room != displayed_room)
         quit("!MoveCharacterPath: specified character not in current room");
 
+    wait_character_route(chaa);
     // not already walking, so just do a normal move
     if (chaa->walking <= 0) {
         Character_Walk(chaa, x, y, IN_BACKGROUND, ANYWHERE);
@@ -955,6 +963,7 @@ void Character_StopMoving(CharacterInfo *charp) {
     int chaa = charp->index_id;
     if (chaa == play.skip_until_char_stops)
         EndSkippingUntilCharStops();
+    cancel_route_request(chaa + CHMLSOFFS);
 
     if (charextra[chaa].xwas != INVALID_X) {
         charp->x = charextra[chaa].xwas;
@@ -1395,6 +1404,7 @@ int Character_GetMoving(CharacterInfo *chaa) {
 }
 
 int Character_GetDestinationX(CharacterInfo *chaa) {
+    wait_character_route(chaa);
     if (chaa->walking) {
         MoveList *cmls = &mls[chaa->walking % TURNING_AROUND];
         return cmls->pos[cmls->numstage - 1] >> 16;
@@ -1404,6 +1414,7 @@ int Character_GetDestinationX(CharacterInfo *chaa) {
 }
 
 int Character_GetDestinationY(CharacterInfo *chaa) {
+    wait_character_route(chaa);
     if (chaa->walking) {
         MoveList *cmls = &mls[chaa->walking % TURNING_AROUND];
         return cmls->pos[cmls->numstage - 1] & 0xFFFF;
@@ -1720,7 +1731,14 @@ void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
 
     set_route_move_speed(move_speed_x, move_speed_y);
     set_color_depth(8);
-    int mslot=find_route(charX, charY, tox, toy, prepare_walkable_areas(chac), chac+CHMLSOFFS, 1, ignwal);
+    int mslot;
+    Bitmap *walkable = prepare_walkable_areas(chac);
+    // if the route is solved in background, they stand on a placeholder
+    // movelist until complete_character_walks() gets the result
+    if (request_route(charX, charY, tox, toy, walkable, chac+CHMLSOFFS, 1, ignwal))
+        mslot = chac+CHMLSOFFS;
+    else
+        mslot=find_route(charX, charY, tox, toy, walkable, chac+CHMLSOFFS, 1, ignwal);
     set_color_depth(game.GetColorDepth());
     if (mslot>0) {
         chin->walking = mslot;
@@ -1747,6 +1765,32 @@ void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
         chin->frame = 0;
 }
 
+void complete_character_walks() {
+    static std::vector<RouteResult> results;
+    complete_route_requests(results);
+    for (const RouteResult &r : results) {
+        const int chac = r.MoveList - CHMLSOFFS;
+        if ((chac < 0) || (chac >= game.numcharacters))
+            continue;
+        CharacterInfo *chin = &game.chars[chac];
+        if (chin->walking % TURNING_AROUND != r.MoveList)
+            continue;
+
+        if (r.Found) {
+            MoveList *cmls = &mls[r.MoveList];
+            convert_move_path_to_room_resolution(cmls);
+            if (((chin->flags & CHF_MOVENOTWALK) == 0) && (cmls->pos[0] != cmls->pos[1]))
+                fix_player_sprite(cmls, chin);
+        }
+        else {
+            // pathfinder couldn't get a route, stand them still
+            chin->walking = 0;
+            if ((chin->flags & CHF_MOVENOTWALK) == 0)
+                chin->frame = 0;
+        }
+    }
+}
+
 int find_looporder_index (int curloop) {
     int rr;
     for (rr = 0; rr < 8; rr++) {
@@ -1852,6 +1896,91 @@ void fix_player_sprite(MoveList*cmls,CharacterInfo*chinf) {
     start_character_turning (chinf, useloop, no_diagonal);
 }
 
+// Blocking rectangles of the characters in the current room, kept in
+// contiguous arrays while characters are updated, so that collision tests
+// don't have to work out every character's rectangle for each move step.
+// A character's rectangle only changes during its own update, after which
+// its entry is refreshed.
+struct CharacterBlockers {
+    bool Active = false;
+    std::vector<int> Slot; // entry index by character, -1 if none
+    std::vector<int> CharIndex;
+    std::vector<int> Left, Right, Top, Bottom; // right is exclusive, bottom inclusive
+};
+static CharacterBlockers char_blockers;
+
+static void set_character_blocker(int charid) {
+    CharacterInfo *chi = &game.chars[charid];
+    int slot = char_blockers.Slot[charid];
+    if ((chi->on != 1) || (chi->room != displayed_room) || (chi->flags & CHF_NOBLOCKING)) {
+        // empty rectangle never contains anything
+        if (slot >= 0)
+            char_blockers.Right[slot] = char_blockers.Left[slot];
+        return;
+    }
+
+    if (slot < 0) {
+        slot = (int)char_blockers.CharIndex.size();
+        char_blockers.Slot[charid] = slot;
+        char_blockers.CharIndex.push_back(charid);
+        char_blockers.Left.push_back(0);
+        char_blockers.Right.push_back(0);
+        char_blockers.Top.push_back(0);
+        char_blockers.Bottom.push_back(0);
+    }
+    int fromx, y1, cwidth, y2;
+    get_char_blocking_rect(charid, &fromx, &y1, &cwidth, &y2);
+    char_blockers.Left[slot] = fromx;
+    char_blockers.Right[slot] = fromx + cwidth;
+    char_blockers.Top[slot] = y1;
+    char_blockers.Bottom[slot] = y2;
+}
+
+void begin_character_blockers() {
+    char_blockers.Active = true;
+    char_blockers.Slot.assign(game.numcharacters, -1);
+    char_blockers.CharIndex.clear();
+    char_blockers.Left.clear();
+    char_blockers.Right.clear();
+    char_blockers.Top.clear();
+    char_blockers.Bottom.clear();
+    for (int ww = 0; ww < game.numcharacters; ww++)
+        set_character_blocker(ww);
+}
+
+void update_character_blocker(int charid) {
+    if (char_blockers.Active)
+        set_character_blocker(charid);
+}
+
+void end_character_blockers() {
+    char_blockers.Active = false;
+}
+
+// Same test as the loop in has_hit_another_character, over the blockers arrays
+static int find_hit_character(int sourceChar) {
+    const int x = game.chars[sourceChar].x;
+    const int y = game.chars[sourceChar].y;
+    const int *left = char_blockers.Left.data();
+    const int *right = char_blockers.Right.data();
+    const int *top = char_blockers.Top.data();
+    const int *bottom = char_blockers.Bottom.data();
+    const size_t count = char_blockers.CharIndex.size();
+    int hit = -1;
+    for (size_t i = 0; i < count; i++) {
+        if ((x >= left[i]) & (x < right[i]) & (y >= top[i]) & (y <= bottom[i])) {
+            // entries may be out of order, so look for the lowest index
+            const int ww = char_blockers.CharIndex[i];
+            if ((ww == sourceChar) || ((hit >= 0) && (ww > hit)))
+                continue;
+            if ((game.chars[ww].walking) &&
+                ((game.chars[ww].flags & CHF_AWAITINGMOVE) == 0))
+                hit = ww;
+        }
+    }
+    return hit;
+}
+
 // Check whether two characters have walked into each other
 int has_hit_another_character(int sourceChar) {
 
@@ -1859,6 +1988,9 @@ int has_hit_another_character(int sourceChar) {
     if (game.chars[sourceChar].flags & CHF_NOBLOCKING)
         return -1;
 
+    if (char_blockers.Active)
+        return find_hit_character(sourceChar);
+
     for (int ww = 0; ww < game.numcharacters; ww++) {
         if (game.chars[ww].on != 1) continue;
         if (game.chars[ww].room != displayed_room) continue;
@@ -1918,7 +2050,7 @@ int doNextCharMoveStep (CharacterInfo *chi, int &char_index, CharacterExtras *ch
 
 int find_nearest_walkable_area_within(int *xx, int *yy, int range, int step)
 {
-    int ex, ey, nearest = 99999, thisis, nearx = 0, neary = 0;
+    int nearx = 0, neary = 0;
     int startx = 0, starty = 14;
     int roomWidthLowRes = room_to_mask_coord(thisroom.Width);
     int roomHeightLowRes = room_to_mask_coord(thisroom.Height);
@@ -1950,20 +2082,18 @@ int find_nearest_walkable_area_within(int *xx, int *yy, int range, int step)
         if (yheight > roomHeightLowRes) yheight = roomHeightLowRes;
     }
 
-    for (ex = startx; ex < xwidth; ex += step) {
-        for (ey = starty; ey < yheight; ey += step) {
-            // non-walkalbe, so don't go here
-            if (thisroom.WalkAreaMask->GetPixel(ex,ey) == 0) continue;
-            // off a screen edge, don't move them there
-            if ((ex <= leftEdge) || (ex >= rightEdge) ||
-                (ey <= topEdge) || (ey >= bottomEdge))
-                continue;
-            // otherwise, calculate distance from target
-            thisis=(int) ::sqrt((double)((ex - xLowRes) * (ex - xLowRes) + (ey - yLowRes) * (ey - yLowRes)));
-            if (thisis<nearest) { nearest=thisis; nearx=ex; neary=ey; }
-        }
-    }
-    if (nearest < 90000) 
+    Bitmap *mask = thisroom.WalkAreaMask.get();
+    auto is_suitable = [&](int ex, int ey)
+    {
+        // off a screen edge, don't move them there
+        if ((ex <= leftEdge) || (ex >= rightEdge) ||
+            (ey <= topEdge) || (ey >= bottomEdge))
+            return false;
+        // non-walkable, so don't go here
+        return mask->GetPixel(ex, ey) != 0;
+    };
+    if (FindNearestGridPoint(startx, starty, xwidth, yheight, step, xLowRes, yLowRes,
+            is_suitable, nearx, neary))
     {
         xx[0] = mask_to_room_coord(nearx);
         yy[0] = mask_to_room_coord(neary);
@@ -2234,6 +2364,14 @@ int is_pos_on_character(int xx,int yy) {
         int xxx = chin->x - game_to_data_coord(usewid) / 2;
         int yyy = chin->get_effective_y() - game_to_data_coord(usehit);
 
+        // Reject by the bounding box and baseline first: getting the image
+        // may require loading the sprite, and pixel test is only needed for
+        // the characters under the cursor
+        if (!is_pos_in_sprite_box(xx, yy, xxx, yyy, game_to_data_coord(usewid), game_to_data_coord(usehit)))
+            continue;
+        int use_base = chin->get_baseline();
+        if (use_base < lowestyp) continue;
+
         int mirrored = views[chin->view].loops[chin->loop].frames[chin->frame].flags & VFLG_FLIPSPRITE;
         Bitmap *theImage = GetCharacterImage(cc, &mirrored);
 
@@ -2242,8 +2380,6 @@ int is_pos_on_character(int xx,int yy) {
             game_to_data_coord(usehit), mirrored) == FALSE)
             continue;
 
-        int use_base = chin->get_baseline();
-        if (use_base < lowestyp) continue;
         lowestyp=use_base;
         lowestwas=cc;
     }
@@ -161,6 +161,8 @@ using namespace AGS; // FIXME later
 
 void animate_character(CharacterInfo *chap, int loopn,int sppd,int rept, int noidleoverride = 0, int direction = 0, int sframe = 0);
 void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims);
+// Applies the routes found in background to the walking characters
+void complete_character_walks();
 int  find_looporder_index (int curloop);
 // returns 0 to use diagonal, 1 to not
 int  useDiagonal (CharacterInfo *char1);
@@ -170,6 +172,11 @@ void start_character_turning (CharacterInfo *chinf, int useloop, int no_diagonal
 void fix_player_sprite(MoveList*cmls,CharacterInfo*chinf);
 // Check whether two characters have walked into each other
 int  has_hit_another_character(int sourceChar);
+// Collects blocking rectangles of the characters for the duration of the
+// characters update; the updated character must be refreshed afterwards
+void begin_character_blockers();
+void update_character_blocker(int charid);
+void end_character_blockers();
 int  doNextCharMoveStep (CharacterInfo *chi, int &char_index, CharacterExtras *chex);
 int  find_nearest_walkable_area_within(int *xx, int *yy, int range, int step);
 void find_nearest_walkable_area (int *xx, int *yy);
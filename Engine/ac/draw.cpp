@@ -50,6 +50,7 @@
 #include "ac/dynobj/scriptsystem.h"
 #include "debug/debugger.h"
 #include "debug/debug_log.h"
+#include "debug/frametiming.h"
 #include "font/fonts.h"
 #include "gui/guimain.h"
 #include "platform/base/agsplatformdriver.h"
@@ -136,6 +137,8 @@ IDriverDependantBitmap* *actspswbbmp;
 CachedActSpsData* actspswbcache;
 
 bool current_background_is_dirty = false;
+// Changed region of the background, valid if the whole background is not dirty
+Rect current_background_dirty_rect;
 
 // Room background sprite
 IDriverDependantBitmap* roomBackgroundBmp = nullptr;
@@ -721,6 +724,12 @@ void mark_current_background_dirty()
     current_background_is_dirty = true;
 }
 
+void mark_current_background_dirty(const Rect &rc)
+{
+    if (!current_background_is_dirty)
+        current_background_dirty_rect = UnionRects(current_background_dirty_rect, rc);
+}
+
 
 void draw_and_invalidate_text(Bitmap *ds, int x1, int y1, int font, color_t text_color, const char *text)
 {
@@ -757,6 +766,7 @@ void render_black_borders()
 
 void render_to_screen()
 {
+    FrameStageTimer timer(kFrameStage_Render);
     // Stage: final plugin callback (still drawn on game screen
     if (pl_any_want_hook(AGSE_FINALSCREENDRAW))
     {
@@ -768,6 +778,7 @@ void render_to_screen()
 
     // only vsync in full screen mode, it makes things worse in a window
     gfxDriver->EnableVsyncBeforeRender((scsystem.vsync > 0) && (!scsystem.windowed));
+    gfxDriver->EnableThreadedPresent(usetup.RenderThreaded);
 
     bool succeeded = false;
     while (!succeeded)
@@ -1998,6 +2009,7 @@ void prepare_characters_for_drawing() {
 // Compiles a list of room sprites (characters, objects, background)
 void prepare_room_sprites()
 {
+    FrameStageTimer timer(kFrameStage_RoomSprites);
     // Background sprite is required for the non-software renderers always,
     // and for software renderer in case there are overlapping viewports.
     // Note that software DDB is just a tiny wrapper around bitmap, so overhead is negligible.
@@ -2011,18 +2023,24 @@ void prepare_room_sprites()
         update_polled_stuff_if_runtime();
         gfxDriver->UpdateDDBFromBitmap(roomBackgroundBmp, thisroom.BgFrames[play.bg_frame].Graphic.get(), false);
     }
+    else if (!current_background_dirty_rect.IsEmpty())
+    {
+        gfxDriver->UpdateDDBRegionFromBitmap(roomBackgroundBmp, thisroom.BgFrames[play.bg_frame].Graphic.get(),
+            current_background_dirty_rect, false);
+    }
     if (gfxDriver->RequiresFullRedrawEachFrame())
     {
-        if (current_background_is_dirty || walkBehindsCachedForBgNum != play.bg_frame)
+        if (walkBehindMethod == DrawAsSeparateSprite)
         {
-            if (walkBehindMethod == DrawAsSeparateSprite)
-            {
+            if (current_background_is_dirty || walkBehindsCachedForBgNum != play.bg_frame)
                 update_walk_behind_images();
-            }
+            else if (!current_background_dirty_rect.IsEmpty())
+                update_walk_behind_images(current_background_dirty_rect);
         }
         add_thing_to_draw(roomBackgroundBmp, 0, 0, 0, false);
     }
     current_background_is_dirty = false; // Note this is only place where this flag is checked
+    current_background_dirty_rect = Rect();
 
     clear_sprite_list();
 
@@ -2134,9 +2152,76 @@ void draw_fps(const Rect &viewport)
     invalidate_sprite(1, yp, ddb, false);
 }
 
+// Draws the stage breakdown of the recent frames as a stacked bar graph,
+// one column per frame, placed right above the fps counter
+void draw_frame_timing(const Rect &viewport)
+{
+    static IDriverDependantBitmap* ddb = nullptr;
+    static Bitmap *graphDisplay = nullptr;
+    static std::vector<FrameTimes> frames;
+    // Stage colors, in the order of FrameStage
+    static const int stage_colors[kNumFrameStages] = { 9, 10, 12, 14, 11, 13, 8, 3, 5 };
+    const int font = FONT_NORMAL;
+    const int legend_height = getfontheight_outlined(font) + get_fixed_pixel_size(2);
+    const int bar_height = get_fixed_pixel_size(40);
+    if (graphDisplay == nullptr)
+    {
+        graphDisplay = BitmapHelper::CreateBitmap(viewport.GetWidth(), legend_height + bar_height, game.GetColorDepth());
+        graphDisplay = ReplaceBitmapWithSupportedFormat(graphDisplay);
+    }
+    graphDisplay->ClearTransparent();
+
+    // Legend, as much as fits in the line
+    int x = 1;
+    for (int stage = 0; stage < kNumFrameStages; ++stage)
+    {
+        const char *name = FrameTiming::GetStageName((FrameStage)stage);
+        const int name_width = wgettextwidth_compensate(name, font);
+        if (x + name_width >= graphDisplay->GetWidth())
+            break;
+        wouttext_outline(graphDisplay, x, 1, font, graphDisplay->GetCompatibleColor(stage_colors[stage]), name);
+        x += name_width + get_fixed_pixel_size(4);
+    }
+
+    // Full graph height stands for two frames at the current game speed;
+    // the frame budget is marked with a line in the middle
+    const int game_fps = (frames_per_second > 0 && frames_per_second < 1000) ? frames_per_second : 40;
+    const int64_t graph_us = 2000000 / game_fps;
+    const int bar_bottom = graphDisplay->GetHeight() - 1;
+    const int col_width = get_fixed_pixel_size(1);
+    FrameTiming::GetFrameTimes(frames);
+    const size_t max_cols = graphDisplay->GetWidth() / col_width;
+    const size_t first = frames.size() > max_cols ? frames.size() - max_cols : 0;
+    x = 0;
+    for (size_t i = first; i < frames.size(); ++i, x += col_width)
+    {
+        int y = bar_bottom;
+        for (int stage = 0; stage < kNumFrameStages && y >= legend_height; ++stage)
+        {
+            const int h = (int)(frames[i].StageUs[stage] * bar_height / graph_us);
+            if (h <= 0)
+                continue;
+            const int top = std::max(legend_height, y - h + 1);
+            graphDisplay->FillRect(Rect(x, top, x + col_width - 1, y), graphDisplay->GetCompatibleColor(stage_colors[stage]));
+            y = top - 1;
+        }
+    }
+    const int budget_y = bar_bottom - bar_height / 2;
+    graphDisplay->DrawLine(Line(0, budget_y, graphDisplay->GetWidth() - 1, budget_y), graphDisplay->GetCompatibleColor(15));
+
+    if (ddb)
+        gfxDriver->UpdateDDBFromBitmap(ddb, graphDisplay, false);
+    else
+        ddb = gfxDriver->CreateDDBFromBitmap(graphDisplay, false);
+    int yp = viewport.GetHeight() - (getfontheight_outlined(font) + get_fixed_pixel_size(5)) - graphDisplay->GetHeight();
+    gfxDriver->DrawSprite(1, yp, ddb);
+    invalidate_sprite(1, yp, ddb, false);
+}
+
 // Draw GUI and overlays of all kinds, anything outside the room space
 void draw_gui_and_overlays()
 {
+    FrameStageTimer timer(kFrameStage_GuiOverlays);
     int gg;
 
     if(pl_any_want_hook(AGSE_PREGUIDRAW))
@@ -2390,7 +2475,6 @@ void construct_game_scene(bool full_redraw)
         if (displayed_room >= 0)
         {
             construct_room_view();
-            update_polled_mp3();
         }
         else if (!gfxDriver->RequiresFullRedrawEachFrame())
         {
@@ -2509,7 +2593,11 @@ void construct_engine_overlay()
     }
 
     if (display_fps)
+    {
         draw_fps(viewport);
+        if (FrameTiming::IsEnabled())
+            draw_frame_timing(viewport);
+    }
 }
 
 static void update_shakescreen()
@@ -22,6 +22,7 @@
 #include "core/types.h"
 #include "ac/common_defines.h"
 #include "gfx/gfx_def.h"
+#include "util/geometry.h"
 #include "util/wgt2allg.h"
 
 namespace AGS
@@ -95,6 +96,8 @@ void invalidate_camera_frame(int index);
 void invalidate_rect(int x1, int y1, int x2, int y2, bool in_room);
 
 void mark_current_background_dirty();
+// marks only a region of the current room background as changed, in room coordinates
+void mark_current_background_dirty(const Rect &rc);
 void invalidate_cached_walkbehinds();
 // Avoid freeing and reallocating the memory if possible
 Common::Bitmap *recycle_bitmap(Common::Bitmap *bimp, int coldep, int wid, int hit, bool make_transparent = false);
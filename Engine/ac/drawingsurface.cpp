@@ -12,6 +12,7 @@
 //
 //=============================================================================
 
+#include <algorithm>
 #include "ac/draw.h"
 #include "ac/drawingsurface.h"
 #include "ac/common.h"
@@ -55,8 +56,17 @@ void DrawingSurface_Release(ScriptDrawingSurface* sds)
         {
             if (sds->roomBackgroundNumber == play.bg_frame)
             {
-                invalidate_screen();
-                mark_current_background_dirty();
+                const Rect &dirty = sds->dirtyRect;
+                if (dirty.IsEmpty())
+                {
+                    invalidate_screen();
+                    mark_current_background_dirty();
+                }
+                else
+                {
+                    invalidate_rect(dirty.Left, dirty.Top, dirty.Right, dirty.Bottom, true);
+                    mark_current_background_dirty(dirty);
+                }
             }
             play.raw_modified[sds->roomBackgroundNumber] = 1;
         }
@@ -102,6 +112,7 @@ void DrawingSurface_Release(ScriptDrawingSurface* sds)
         sds->dynamicSurfaceNumber = -1;
     }
     sds->modified = 0;
+    sds->dirtyRect = Rect();
 }
 
 void ScriptDrawingSurface::PointToGameResolution(int *xcoord, int *ycoord)
@@ -159,7 +170,7 @@ void DrawingSurface_DrawSurface(ScriptDrawingSurface* target, ScriptDrawingSurfa
     if (translev == 0) {
         // just draw it over the top, no transparency
         ds->Blit(surfaceToDraw, 0, 0, 0, 0, surfaceToDraw->GetWidth(), surfaceToDraw->GetHeight());
-        target->FinishedDrawing();
+        target->FinishedDrawing(RectWH(0, 0, surfaceToDraw->GetWidth(), surfaceToDraw->GetHeight()));
         return;
     }
 
@@ -169,7 +180,7 @@ void DrawingSurface_DrawSurface(ScriptDrawingSurface* target, ScriptDrawingSurfa
     // Draw it transparently
     GfxUtil::DrawSpriteWithTransparency(ds, surfaceToDraw, 0, 0,
         GfxDef::Trans100ToAlpha255(translev));
-    target->FinishedDrawing();
+    target->FinishedDrawing(RectWH(0, 0, surfaceToDraw->GetWidth(), surfaceToDraw->GetHeight()));
 }
 
 void DrawingSurface_DrawImage(ScriptDrawingSurface* sds, int xx, int yy, int slot, int trans, int width, int height)
@@ -218,7 +229,7 @@ void DrawingSurface_DrawImage(ScriptDrawingSurface* sds, int xx, int yy, int slo
     draw_sprite_support_alpha(ds, sds->hasAlphaChannel != 0, xx, yy, sourcePic, (game.SpriteInfos[slot].Flags & SPF_ALPHACHANNEL) != 0,
         kBlendMode_Alpha, GfxDef::Trans100ToAlpha255(trans));
 
-    sds->FinishedDrawing();
+    sds->FinishedDrawing(RectWH(xx, yy, sourcePic->GetWidth(), sourcePic->GetHeight()));
 
     if (needToFreeBitmap)
         delete sourcePic;
@@ -299,7 +310,7 @@ void DrawingSurface_DrawCircle(ScriptDrawingSurface *sds, int x, int y, int radi
 
     Bitmap *ds = sds->StartDrawing();
     ds->FillCircle(Circle(x, y, radius), sds->currentColour);
-    sds->FinishedDrawing();
+    sds->FinishedDrawing(Rect(x - radius, y - radius, x + radius, y + radius));
 }
 
 void DrawingSurface_DrawRectangle(ScriptDrawingSurface *sds, int x1, int y1, int x2, int y2)
@@ -309,7 +320,7 @@ void DrawingSurface_DrawRectangle(ScriptDrawingSurface *sds, int x1, int y1, int
 
     Bitmap *ds = sds->StartDrawing();
     ds->FillRect(Rect(x1,y1,x2,y2), sds->currentColour);
-    sds->FinishedDrawing();
+    sds->FinishedDrawing(Rect(std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2)));
 }
 
 void DrawingSurface_DrawTriangle(ScriptDrawingSurface *sds, int x1, int y1, int x2, int y2, int x3, int y3)
@@ -320,7 +331,8 @@ void DrawingSurface_DrawTriangle(ScriptDrawingSurface *sds, int x1, int y1, int
 
     Bitmap *ds = sds->StartDrawing();
     ds->DrawTriangle(Triangle(x1,y1,x2,y2,x3,y3), sds->currentColour);
-    sds->FinishedDrawing();
+    sds->FinishedDrawing(Rect(std::min(x1, std::min(x2, x3)), std::min(y1, std::min(y2, y3)),
+        std::max(x1, std::max(x2, x3)), std::max(y1, std::max(y2, y3))));
 }
 
 void DrawingSurface_DrawString(ScriptDrawingSurface *sds, int xx, int yy, int font, const char* text)
@@ -399,7 +411,9 @@ void DrawingSurface_DrawLine(ScriptDrawingSurface *sds, int fromx, int fromy, in
             ds->DrawLine (Line(fromx + xx, fromy + yy, tox + xx, toy + yy), draw_color);
         }
     }
-    sds->FinishedDrawing();
+    const int off1 = -(thickness / 2), off2 = thickness - 1 - (thickness / 2);
+    sds->FinishedDrawing(Rect(std::min(fromx, tox) + off1, std::min(fromy, toy) + off1,
+        std::max(fromx, tox) + off2, std::max(fromy, toy) + off2));
 }
 
 void DrawingSurface_DrawPixel(ScriptDrawingSurface *sds, int x, int y) {
@@ -417,7 +431,7 @@ void DrawingSurface_DrawPixel(ScriptDrawingSurface *sds, int x, int y) {
             ds->PutPixel(x + ii, y + jj, draw_color);
         }
     }
-    sds->FinishedDrawing();
+    sds->FinishedDrawing(RectWH(x, y, thickness, thickness));
 }
 
 int DrawingSurface_GetPixel(ScriptDrawingSurface *sds, int x, int y) {
@@ -61,6 +61,17 @@ void ScriptDrawingSurface::FinishedDrawingReadOnly()
 void ScriptDrawingSurface::FinishedDrawing()
 {
     FinishedDrawingReadOnly();
+    // changed area is not known, empty rect marks the whole surface
+    dirtyRect = Rect();
+    modified = 1;
+}
+
+void ScriptDrawingSurface::FinishedDrawing(const Rect &area)
+{
+    FinishedDrawingReadOnly();
+    // if surface was modified before without known area, then keep it whole
+    if (!modified || !dirtyRect.IsEmpty())
+        dirtyRect = UnionRects(dirtyRect, area);
     modified = 1;
 }
 
@@ -16,6 +16,7 @@
 #define __AC_SCRIPTDRAWINGSURFACE_H
 
 #include "ac/dynobj/cc_agsdynamicobject.h"
+#include "util/geometry.h"
 
 namespace AGS { namespace Common { class Bitmap; }}
 
@@ -29,6 +30,9 @@ struct ScriptDrawingSurface final : AGSCCDynamicObject {
     int currentColourScript;
     int highResCoordinates;
     int modified;
+    // Part of the surface changed since it was acquired;
+    // empty rect while modified flag is set means the whole surface
+    Rect dirtyRect;
     int hasAlphaChannel;
     //Common::Bitmap* abufBackup;
 
@@ -43,6 +47,8 @@ struct ScriptDrawingSurface final : AGSCCDynamicObject {
     void SizeToGameResolution(int *adjustValue);
     void SizeToDataResolution(int *adjustValue);
     void FinishedDrawing();
+    // Same as FinishedDrawing, but marks only the given area as changed
+    void FinishedDrawing(const Rect &area);
     void FinishedDrawingReadOnly();
 
     ScriptDrawingSurface();
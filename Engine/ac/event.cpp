@@ -291,7 +291,6 @@ void process_event(EventHappened*evp) {
                     temp_scr->Blit(saved_backbuf, lxp, lyp, lxp, lyp, 
                         boxwid, boxhit);
                     render_to_screen();
-                    update_polled_mp3();
                     WaitForNextFrame();
                 }
                 gfxDriver->SetMemoryBackBuffer(saved_backbuf);
@@ -12,6 +12,7 @@
 //
 //=============================================================================
 
+#include <chrono>
 #include "aldumb.h"
 #include "ac/asset_helper.h"
 #include "ac/audiocliptype.h"
@@ -24,6 +25,7 @@
 #include "ac/path_helper.h"
 #include "ac/runtime_defines.h"
 #include "ac/string.h"
+#include "debug/assettrace.h"
 #include "debug/debug_log.h"
 #include "debug/debugger.h"
 #include "util/misc.h"
@@ -397,6 +399,7 @@ bool LocateAsset(const AssetPath &path, AssetLocation &loc)
 
 PACKFILE *PackfileFromAsset(const AssetPath &path)
 {
+    const auto start = std::chrono::steady_clock::now();
     AssetLocation loc;
     if (LocateAsset(path, loc))
     {
@@ -405,6 +408,11 @@ PACKFILE *PackfileFromAsset(const AssetPath &path)
         {
             pack_fseek(pf, loc.Offset);
             pf->normal.todo = loc.Size;
+            // the reads go through allegro and cannot be counted, only the open
+            if (AssetTrace::IsEnabled())
+                AssetTrace::TraceOpen(path.second, loc.FileName, loc.Offset,
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start).count());
         }
         return pf;
     }
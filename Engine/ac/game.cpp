@@ -1127,6 +1127,9 @@ void save_game(int slotn, const char*descript) {
 
     update_polled_stuff_if_runtime();
 
+    // save the real routes rather than placeholders of the pending requests
+    complete_character_walks();
+
     // Actual dynamic game data is saved here
     SaveGameState(out);
 
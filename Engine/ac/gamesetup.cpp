@@ -34,6 +34,12 @@ GameSetup::GameSetup()
     mouse_speed_def = kMouseSpeed_CurrentDisplay;
     RenderAtScreenRes = false;
     Supersampling = 1;
+    RenderThreaded = false;
+    PathfinderThreads = 0;
+    FileReadAhead = false;
+    RoomPreloadCount = 0;
+    RoomPreloadMemKb = 65536;
+    DecodedCacheMaxKb = 262144;
 
     Screen.DisplayMode.ScreenSize.MatchDeviceRatio = true;
     Screen.DisplayMode.ScreenSize.SizeDef = kScreenDef_MaxDisplay;
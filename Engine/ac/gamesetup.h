@@ -72,6 +72,13 @@ struct GameSetup {
     MouseSpeedDef mouse_speed_def;
     bool  RenderAtScreenRes; // render sprites at screen resolution, as opposed to native one
     int   Supersampling;
+    bool  RenderThreaded; // present finished frames on a separate thread
+    int   PathfinderThreads; // number of threads solving character routes in background
+    bool  FileReadAhead; // read files ahead on a background thread
+    int   RoomPreloadCount; // number of the likely next rooms to preload
+    int   RoomPreloadMemKb; // memory limit for the preloaded rooms, in KB
+    String DecodedCacheDir; // directory to keep the unpacked assets in
+    int   DecodedCacheMaxKb; // size limit for the unpacked assets directory, in KB
 
     ScreenSetup Screen;
 
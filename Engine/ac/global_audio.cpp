@@ -440,14 +440,14 @@ void PlaySilentMIDI (int mnum) {
     {
         quitprintf("!PlaySilentMIDI: failed to load aMusic%d", mnum);
     }
-    AudioChannelsLock lock;
-    lock.SetChannel(play.silent_midi_channel, clip);
     if (!clip->play()) {
         clip->destroy();
         delete clip;
         clip = nullptr;
         quitprintf("!PlaySilentMIDI: failed to play aMusic%d", mnum);
     }
+    AudioChannelsLock lock;
+    lock.SetChannel(play.silent_midi_channel, clip);
     clip->set_volume_percent(0);
 }
 
@@ -40,6 +40,7 @@
 #include "ac/path_helper.h"
 #include "ac/sys_events.h"
 #include "ac/room.h"
+#include "ac/roompreload.h"
 #include "ac/roomstatus.h"
 #include "ac/string.h"
 #include "ac/system.h"
@@ -262,6 +263,7 @@ int RunAGSGame (const char *newgame, unsigned int mode, int data) {
 
     unload_old_room();
     displayed_room = -10;
+    reset_room_preload();
 
     unload_game_file();
 
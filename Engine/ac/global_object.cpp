@@ -79,6 +79,12 @@ int GetObjectIDAtRoom(int roomx, int roomy)
         int isflipped = 0;
         int spWidth = game_to_data_coord(objs[aa].get_width());
         int spHeight = game_to_data_coord(objs[aa].get_height());
+        // Reject by the bounding box and baseline before getting the image
+        if (!is_pos_in_sprite_box(roomx, roomy, xxx, yyy - spHeight, spWidth, spHeight))
+            continue;
+        int usebasel = objs[aa].get_baseline();
+        if (usebasel < bestshotyp) continue;
+
         if (objs[aa].view >= 0)
             isflipped = views[objs[aa].view].loops[objs[aa].loop].frames[objs[aa].frame].flags & VFLG_FLIPSPRITE;
 
@@ -88,9 +94,6 @@ int GetObjectIDAtRoom(int roomx, int roomy)
             spWidth, spHeight, isflipped) == FALSE)
             continue;
 
-        int usebasel = objs[aa].get_baseline();   
-        if (usebasel < bestshotyp) continue;
-
         bestshotwas = aa;
         bestshotyp = usebasel;
     }
@@ -50,7 +50,7 @@ int GetRegionIDAtRoom(int xxx, int yyy) {
             yyy = 0;
     }
 
-    int hsthere = thisroom.RegionMask->GetPixel (xxx, yyy);
+    int hsthere = get_room_mask_pixel(thisroom.RegionMask.get(), xxx, yyy);
     if (hsthere < 0)
         hsthere = 0;
 
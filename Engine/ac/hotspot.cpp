@@ -123,7 +123,7 @@ bool Hotspot_SetTextProperty(ScriptHotspot *hss, const char *property, const cha
 }
 
 int get_hotspot_at(int xpp,int ypp) {
-    int onhs=thisroom.HotspotMask->GetPixel(room_to_mask_coord(xpp), room_to_mask_coord(ypp));
+    int onhs = get_room_mask_pixel(thisroom.HotspotMask.get(), room_to_mask_coord(xpp), room_to_mask_coord(ypp));
     if (onhs<0) return 0;
     if (croom->hotspot_enabled[onhs]==0) return 0;
     return onhs;
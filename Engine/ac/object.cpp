@@ -481,6 +481,14 @@ int isposinbox(int mmx,int mmy,int lf,int tp,int rt,int bt) {
     else return FALSE;
 }
 
+// Tells if the position may be inside the sprite of the given size, without
+// looking at the sprite image; zero size means that it is not known yet
+bool is_pos_in_sprite_box(int xx, int yy, int arx, int ary, int spww, int sphh) {
+    if (spww == 0 || sphh == 0)
+        return true;
+    return isposinbox(xx, yy, arx, ary, arx + spww, ary + sphh) != FALSE;
+}
+
 // xx,yy is the position in room co-ordinates that we are checking
 // arx,ary is the sprite x/y co-ordinates
 int is_pos_in_sprite(int xx,int yy,int arx,int ary, Bitmap *sprit, int spww,int sphh, int flipped) {
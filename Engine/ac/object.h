@@ -80,6 +80,8 @@ const char* Object_GetTextProperty(ScriptObject *objj, const char *property);
 void    move_object(int objj,int tox,int toy,int spee,int ignwal);
 void    get_object_blocking_rect(int objid, int *x1, int *y1, int *width, int *y2);
 int     isposinbox(int mmx,int mmy,int lf,int tp,int rt,int bt);
+// Tells if position is inside the sprite's bounding box, skipping the pixel test
+bool    is_pos_in_sprite_box(int xx, int yy, int arx, int ary, int spww, int sphh);
 int     is_pos_in_sprite(int xx,int yy,int arx,int ary, Common::Bitmap *sprit, int spww,int sphh, int flipped = 0);
 // X and Y co-ordinates must be in native format
 // X and Y are ROOM coordinates
@@ -39,7 +39,9 @@
 #include "ac/sys_events.h"
 #include "ac/room.h"
 #include "ac/roomobject.h"
+#include "ac/roompreload.h"
 #include "ac/roomstatus.h"
+#include "ac/route_finder.h"
 #include "ac/screen.h"
 #include "ac/string.h"
 #include "ac/system.h"
@@ -49,6 +51,7 @@
 #include "ac/dynobj/scripthotspot.h"
 #include "gui/guidefines.h"
 #include "script/cc_instance.h"
+#include "debug/assettrace.h"
 #include "debug/debug_log.h"
 #include "debug/debugger.h"
 #include "debug/out.h"
@@ -243,6 +246,8 @@ void save_room_data_segment () {
 void unload_old_room() {
     int ff;
 
+    cancel_route_requests();
+
     // if switching games on restore, don't do this
     if (displayed_room < 0)
         return;
@@ -440,11 +445,25 @@ static void update_all_viewcams_with_newroom()
 }
 
 // forchar = playerchar on NewRoom, or NULL if restore saved game
+String get_room_filename(int room_no)
+{
+    String room_filename = String::FromFormat("room%d.crm", room_no);
+    if (room_no == 0) {
+        // support both room0.crm and intro.crm
+        // 2.70: Renamed intro.crm to room0.crm, to stop it causing confusion
+        if ((loaded_game_file_version < kGameVersion_270 && Common::AssetManager::DoesAssetExist("intro.crm")) ||
+            (loaded_game_file_version >= kGameVersion_270 && !Common::AssetManager::DoesAssetExist(room_filename)))
+        {
+            room_filename = "intro.crm";
+        }
+    }
+    return room_filename;
+}
+
 void load_new_room(int newnum, CharacterInfo*forchar) {
 
     debug_script_log("Loading room %d", newnum);
 
-    String room_filename;
     int cc;
     done_es_error = 0;
     play.room_changes ++;
@@ -454,24 +473,17 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
     // lead to unexpected errors.
     set_color_depth(8);
     displayed_room=newnum;
+    AssetTrace::SetRoom(newnum);
 
-    room_filename.Format("room%d.crm", newnum);
-    if (newnum == 0) {
-        // support both room0.crm and intro.crm
-        // 2.70: Renamed intro.crm to room0.crm, to stop it causing confusion
-        if ((loaded_game_file_version < kGameVersion_270 && Common::AssetManager::DoesAssetExist("intro.crm")) ||
-            (loaded_game_file_version >= kGameVersion_270 && !Common::AssetManager::DoesAssetExist(room_filename)))
-        {
-            room_filename = "intro.crm";
-        }
-    }
+    String room_filename = get_room_filename(newnum);
 
     update_polled_stuff_if_runtime();
 
-    // load the room from disk
+    // load the room from disk, unless it was preloaded
     our_eip=200;
     thisroom.GameID = NO_GAME_ID_IN_ROOM_FILE;
-    load_room(room_filename, &thisroom, game.IsLegacyHiRes(), game.SpriteInfos);
+    if (!take_preloaded_room(newnum, thisroom))
+        load_room(room_filename, &thisroom, game.IsLegacyHiRes(), game.SpriteInfos);
 
     if ((thisroom.GameID != NO_GAME_ID_IN_ROOM_FILE) &&
         (thisroom.GameID != game.uniqueid)) {
@@ -534,6 +546,7 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
     our_eip=204;
     update_polled_stuff_if_runtime();
     redo_walkable_areas();
+    init_area_scaling();
     update_polled_stuff_if_runtime();
 
     set_color_depth(game.GetColorDepth());
@@ -887,6 +900,7 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
     our_eip=220;
     update_polled_stuff_if_runtime();
     debug_script_log("Now in room %d", displayed_room);
+    room_preload_enter_room(displayed_room);
     guis_need_update = 1;
     pl_run_plugin_hooks(AGSE_ENTERROOM, displayed_room);
     //  MoveToWalkableArea(game.playercharacter);
@@ -925,6 +939,8 @@ void new_room(int newnum,CharacterInfo*forchar) {
     }
     update_polled_stuff_if_runtime();
 
+    room_preload_add_link(displayed_room, newnum);
+
     // change rooms
     unload_old_room();
 
@@ -1052,6 +1068,17 @@ AGS_INLINE int mask_to_room_coord(int coord)
     return coord * thisroom.MaskResolution / game.GetDataUpscaleMult();
 }
 
+int get_room_mask_pixel(const Bitmap *mask, int x, int y)
+{
+    if ((x < 0) || (y < 0) || (x >= mask->GetWidth()) || (y >= mask->GetHeight()))
+        return -1;
+    // Room masks are 8-bit, so read the scanline directly instead of
+    // going through the generic GetPixel
+    if (mask->GetColorDepth() != 8)
+        return mask->GetPixel(x, y);
+    return mask->GetScanLine(y)[x];
+}
+
 void convert_move_path_to_room_resolution(MoveList *ml)
 {
     if ((game.options[OPT_WALKSPEEDABSOLUTE] != 0) && game.GetDataUpscaleMult() > 1)
@@ -23,6 +23,8 @@
 #include "script/runtimescriptvalue.h"
 #include "game/roomstruct.h"
 
+namespace AGS { namespace Common { class Bitmap; } }
+
 ScriptDrawingSurface* Room_GetDrawingSurfaceForBackground(int backgroundNumber);
 int Room_GetObjectCount();
 int Room_GetWidth();
@@ -42,6 +44,8 @@ RuntimeScriptValue Sc_Room_GetProperty(const RuntimeScriptValue *params, int32_t
 
 void  save_room_data_segment ();
 void  unload_old_room();
+// Gets the name of the room's file
+AGS::Common::String get_room_filename(int room_no);
 void  load_new_room(int newnum,CharacterInfo*forchar);
 void  new_room(int newnum,CharacterInfo*forchar);
 int   find_highest_room_entered();
@@ -63,6 +67,9 @@ extern AGS_INLINE int get_roommask_to_data_mul();
 extern AGS_INLINE int room_to_mask_coord(int coord);
 // coordinate conversion mask ---> room ---> data
 extern AGS_INLINE int mask_to_room_coord(int coord);
+// Reads a value from the 8-bit room mask, at position in mask coordinates;
+// returns -1 if position is outside the mask
+int get_room_mask_pixel(const AGS::Common::Bitmap *mask, int x, int y);
 
 struct MoveList;
 // Convert move path from room's mask resolution to room resolution
@@ -0,0 +1,355 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "ac/roompreload.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "ac/common.h" // quitprintf
+#include "ac/gamesetupstruct.h"
+#include "ac/room.h"
+#include "ac/spritecache.h"
+#include "core/assetmanager.h"
+#include "debug/assettrace.h"
+#include "debug/out.h"
+#include "game/room_file.h"
+#include "game/roomstruct.h"
+#include "gfx/bitmap.h"
+#include "util/file.h"
+#include "util/stream.h"
+
+using namespace AGS::Common;
+
+extern GameSetupStruct game;
+extern SpriteCache spriteset;
+
+// How many sprites are loaded per game frame, to not stall it
+#define PRELOAD_SPRITES_PER_FRAME 2
+
+struct RoomToPreload
+{
+    int             Room;
+    String          AssetName;
+    AssetLocation   Location;
+};
+
+struct PreloadedRoom
+{
+    // room data, or null if reading failed
+    std::unique_ptr<RoomStruct> Data;
+    size_t          MemSize;
+    String          Error;
+};
+
+// Accessed only on the game thread
+// number of times the player went from one room to another, per room
+static std::map<int, std::map<int, int>> room_links;
+static int preload_max_rooms;
+static std::vector<int> sprites_to_load;
+
+// Shared with the preloading thread
+static std::thread preload_thread;
+static std::mutex preload_mutex;
+static std::condition_variable preload_work_cv; // new rooms to load or exit
+static std::condition_variable preload_done_cv; // room finished loading
+static std::deque<RoomToPreload> preload_queue;
+static std::map<int, PreloadedRoom> preloaded_rooms;
+// rooms which should be kept preloaded
+static std::vector<int> preload_wanted;
+static int preload_loading_room = -1;
+static size_t preload_mem_used;
+static size_t preload_mem_budget;
+static bool preload_exit;
+// rooms loaded since the last update on the game thread, for the sprites
+static std::vector<int> preload_new_rooms;
+
+
+static size_t get_bitmap_mem_size(const Bitmap *bmp)
+{
+    return bmp ? (size_t)bmp->GetLineLength() * bmp->GetHeight() : 0;
+}
+
+static size_t get_room_mem_size(const RoomStruct &room)
+{
+    size_t size = sizeof(RoomStruct);
+    for (size_t i = 0; i < room.BgFrameCount; ++i)
+        size += get_bitmap_mem_size(room.BgFrames[i].Graphic.get());
+    size += get_bitmap_mem_size(room.HotspotMask.get());
+    size += get_bitmap_mem_size(room.RegionMask.get());
+    size += get_bitmap_mem_size(room.WalkAreaMask.get());
+    size += get_bitmap_mem_size(room.WalkBehindMask.get());
+    return size;
+}
+
+// Reads the room's data, without the fixups which depend on the game state;
+// this is run on the preloading thread, so the errors are returned to be
+// reported on the game thread
+static HRoomFileError read_room(const String &asset_name, const AssetLocation &loc, std::unique_ptr<RoomStruct> &room)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<Stream> in(File::OpenFile(loc.FileName, kFile_Open, kFile_Read));
+    if (!in || !in->Seek(loc.Offset, kSeekBegin))
+        return new RoomFileError(kRoomFileErr_FileOpenFailed, loc.FileName);
+    if (AssetTrace::IsEnabled())
+        in.reset(AssetTrace::TraceStream(in.release(), asset_name, loc.FileName, loc.Offset,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count()));
+    RoomFileVersion data_ver = (RoomFileVersion)in->ReadInt16();
+    if (data_ver < kRoomVersion_250b || data_ver > kRoomVersion_Current)
+        return new RoomFileError(kRoomFileErr_FormatNotSupported, String::FromFormat("Format version: %d.", data_ver));
+    room.reset(new RoomStruct());
+    room->InitDefaults();
+    HRoomFileError err = ReadRoomData(room.get(), in.get(), data_ver, false);
+    if (!err)
+        room.reset();
+    return err;
+}
+
+static void preload_worker()
+{
+    std::unique_lock<std::mutex> lk(preload_mutex);
+    for (;;)
+    {
+        preload_work_cv.wait(lk, [] { return preload_exit || !preload_queue.empty(); });
+        if (preload_exit)
+            return;
+        RoomToPreload next = preload_queue.front();
+        preload_queue.pop_front();
+        if (preload_mem_used >= preload_mem_budget)
+            continue;
+
+        preload_loading_room = next.Room;
+        lk.unlock();
+        std::unique_ptr<RoomStruct> room;
+        HRoomFileError err = read_room(next.AssetName, next.Location, room);
+        lk.lock();
+        preload_loading_room = -1;
+
+        // the player may have gone to another room meanwhile
+        bool wanted = !preload_exit &&
+            std::find(preload_wanted.begin(), preload_wanted.end(), next.Room) != preload_wanted.end();
+        if (!err && wanted)
+        {
+            // keep the error to report it if the room is entered
+            PreloadedRoom &pre = preloaded_rooms[next.Room];
+            pre.MemSize = 0;
+            pre.Error = err->FullMessage();
+        }
+        else if (room && wanted)
+        {
+            size_t mem_size = get_room_mem_size(*room);
+            if (preload_mem_used + mem_size <= preload_mem_budget)
+            {
+                preload_mem_used += mem_size;
+                PreloadedRoom &pre = preloaded_rooms[next.Room];
+                pre.Data = std::move(room);
+                pre.MemSize = mem_size;
+                preload_new_rooms.push_back(next.Room);
+            }
+        }
+        preload_done_cv.notify_all();
+    }
+}
+
+void start_room_preload(int max_rooms, size_t mem_budget)
+{
+    stop_room_preload();
+    preload_max_rooms = max_rooms;
+    preload_mem_budget = mem_budget;
+    if (max_rooms <= 0 || mem_budget == 0)
+        return;
+
+    preload_exit = false;
+    try {
+        preload_thread = std::thread(preload_worker);
+    } catch (std::system_error) {
+        preload_max_rooms = 0;
+        return;
+    }
+    Debug::Printf(kDbgMsg_Init, "Room preload: up to %d room(s), %u KB", max_rooms, (unsigned)(mem_budget / 1024));
+}
+
+void stop_room_preload()
+{
+    if (preload_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lk(preload_mutex);
+            preload_exit = true;
+        }
+        preload_work_cv.notify_all();
+        preload_thread.join();
+    }
+    preload_queue.clear();
+    preload_wanted.clear();
+    preloaded_rooms.clear();
+    preload_new_rooms.clear();
+    preload_mem_used = 0;
+    sprites_to_load.clear();
+}
+
+void room_preload_add_link(int from_room, int to_room)
+{
+    if (preload_max_rooms <= 0 || from_room < 0 || to_room < 0 || from_room == to_room)
+        return;
+    room_links[from_room][to_room]++;
+}
+
+void room_preload_enter_room(int room)
+{
+    if (preload_max_rooms <= 0)
+        return;
+
+    // the neighbours, most often entered first
+    std::vector<std::pair<int, int>> next_rooms;
+    auto links = room_links.find(room);
+    if (links != room_links.end())
+    {
+        for (const auto &link : links->second)
+            next_rooms.push_back(std::make_pair(link.second, link.first));
+    }
+    std::sort(next_rooms.begin(), next_rooms.end(),
+        [](const std::pair<int, int> &a, const std::pair<int, int> &b) { return a.first > b.first; });
+    if (next_rooms.size() > (size_t)preload_max_rooms)
+        next_rooms.resize(preload_max_rooms);
+
+    // asset manager is only used on the game thread, so find the files here
+    std::deque<RoomToPreload> queue;
+    for (const auto &next : next_rooms)
+    {
+        RoomToPreload pre;
+        pre.Room = next.second;
+        pre.AssetName = get_room_filename(pre.Room);
+        if (AssetManager::GetAssetLocation(pre.AssetName, pre.Location))
+            queue.push_back(pre);
+    }
+
+    std::lock_guard<std::mutex> lk(preload_mutex);
+    preload_wanted.clear();
+    for (const auto &next : next_rooms)
+        preload_wanted.push_back(next.second);
+    for (auto it = preloaded_rooms.begin(); it != preloaded_rooms.end();)
+    {
+        if (std::find(preload_wanted.begin(), preload_wanted.end(), it->first) == preload_wanted.end())
+        {
+            preload_mem_used -= it->second.MemSize;
+            it = preloaded_rooms.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    preload_queue.clear();
+    for (const RoomToPreload &pre : queue)
+    {
+        if (pre.Room != preload_loading_room && preloaded_rooms.find(pre.Room) == preloaded_rooms.end())
+            preload_queue.push_back(pre);
+    }
+    if (!preload_queue.empty())
+        preload_work_cv.notify_one();
+}
+
+bool take_preloaded_room(int room, RoomStruct &room_data)
+{
+    if (preload_max_rooms <= 0)
+        return false;
+
+    std::unique_ptr<RoomStruct> data;
+    String error;
+    {
+        std::unique_lock<std::mutex> lk(preload_mutex);
+        // nothing else is needed now, so don't start loading other rooms
+        preload_queue.clear();
+        preload_done_cv.wait(lk, [room] { return preload_loading_room != room; });
+        auto it = preloaded_rooms.find(room);
+        if (it == preloaded_rooms.end())
+            return false;
+        data = std::move(it->second.Data);
+        error = it->second.Error;
+        preload_mem_used -= it->second.MemSize;
+        preloaded_rooms.erase(it);
+    }
+
+    if (!data)
+    {
+        // let the room be loaded the usual way, which reports its errors
+        Debug::Printf(kDbgMsg_Warn, "Room preload: failed to read room %d: %s", room, error.GetCStr());
+        return false;
+    }
+
+    room_data.Free();
+    room_data = *data;
+    HRoomFileError err = UpdateRoomData(&room_data, (RoomFileVersion)room_data.DataVersion,
+        game.IsLegacyHiRes(), game.SpriteInfos);
+    if (!err)
+        quitprintf("Unable to load the room file '%s'.\n%s.", get_room_filename(room).GetCStr(), err->FullMessage().GetCStr());
+    Debug::Printf("Room preload: room %d was ready", room);
+    return true;
+}
+
+void update_room_preload()
+{
+    if (preload_max_rooms <= 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lk(preload_mutex);
+        for (int room : preload_new_rooms)
+        {
+            auto it = preloaded_rooms.find(room);
+            if (it == preloaded_rooms.end())
+                continue;
+            const RoomStruct &data = *it->second.Data;
+            for (size_t i = 0; i < data.ObjectCount; ++i)
+                sprites_to_load.push_back(data.Objects[i].Sprite);
+        }
+        preload_new_rooms.clear();
+    }
+
+    // the sprites are only loaded into the free part of the cache, so that
+    // they don't push out the ones used in the current room
+    for (int i = 0; i < PRELOAD_SPRITES_PER_FRAME && !sprites_to_load.empty(); ++i)
+    {
+        if (spriteset.GetCacheSize() >= spriteset.GetMaxCacheSize() / 4 * 3)
+        {
+            sprites_to_load.clear();
+            break;
+        }
+        int sprite = sprites_to_load.back();
+        sprites_to_load.pop_back();
+        if (spriteset.DoesSpriteExist(sprite))
+            spriteset[sprite];
+    }
+}
+
+void reset_room_preload()
+{
+    std::unique_lock<std::mutex> lk(preload_mutex);
+    preload_queue.clear();
+    preload_wanted.clear();
+    preload_done_cv.wait(lk, [] { return preload_loading_room < 0; });
+    preloaded_rooms.clear();
+    preload_new_rooms.clear();
+    preload_mem_used = 0;
+    lk.unlock();
+    room_links.clear();
+    sprites_to_load.clear();
+}
@@ -0,0 +1,50 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Room preloading. The engine remembers which rooms the player goes to from
+// each room, and while the player is in a room, the rooms most often entered
+// from it are read and unpacked on a background thread. When the player goes
+// to a preloaded room its data is taken from memory, and only the fixups
+// which need the game state are done on the game thread.
+//
+//=============================================================================
+#ifndef __AGS_EE_AC__ROOMPRELOAD_H
+#define __AGS_EE_AC__ROOMPRELOAD_H
+
+#include <stddef.h>
+
+namespace AGS { namespace Common { class RoomStruct; } }
+
+// Starts the preloading thread; max_rooms is how many of the neighbouring
+// rooms are preloaded, and mem_budget is how much memory they may take,
+// in bytes. Zero max_rooms stops preloading.
+void start_room_preload(int max_rooms, size_t mem_budget);
+// Stops the preloading thread and frees all the preloaded rooms
+void stop_room_preload();
+// Records that the player went from one room to another
+void room_preload_add_link(int from_room, int to_room);
+// Schedules the rooms likely to follow the entered one, and drops the
+// preloaded rooms which are no longer likely to be needed
+void room_preload_enter_room(int room);
+// Takes the preloaded room's data, waiting if the room is being read right
+// now; returns false if the room was not preloaded
+bool take_preloaded_room(int room, AGS::Common::RoomStruct &room_data);
+// Loads the sprites of the preloaded rooms' objects into the sprite cache,
+// a few at a time; called on every game frame
+void update_room_preload();
+// Drops everything preloaded and the collected room links, for when
+// another game is run
+void reset_room_preload();
+
+#endif // __AGS_EE_AC__ROOMPRELOAD_H
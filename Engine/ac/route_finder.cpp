@@ -27,11 +27,20 @@ class IRouteFinder
     virtual void init_pathfinder() = 0;
     virtual void shutdown_pathfinder() = 0;
     virtual void set_wallscreen(Bitmap *wallscreen) = 0;
+    virtual void set_walkmask(Bitmap *walkmask) = 0;
+    virtual void set_wallscreen_version(Bitmap *wallscreen, uint32_t version) = 0;
     virtual int can_see_from(int x1, int y1, int x2, int y2) = 0;
     virtual void get_lastcpos(int &lastcx, int &lastcy) = 0;
     virtual void set_route_move_speed(int speed_x, int speed_y) = 0;
     virtual int find_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int movlst, int nocross = 0, int ignore_walls = 0) = 0;
     virtual void calculate_move_stage(MoveList * mlsp, int aaa) = 0;
+    virtual void start_route_requests(int num_threads) = 0;
+    virtual bool can_request_routes() = 0;
+    virtual bool request_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int movlst, int nocross, int ignore_walls) = 0;
+    virtual bool is_route_requested(int movlst) = 0;
+    virtual void complete_route_requests(std::vector<RouteResult> &results) = 0;
+    virtual void cancel_route_request(int movlst) = 0;
+    virtual void cancel_route_requests() = 0;
 };
 
 class AGSRouteFinder : public IRouteFinder 
@@ -49,6 +58,14 @@ class AGSRouteFinder : public IRouteFinder
     { 
         AGS::Engine::RouteFinder::set_wallscreen(wallscreen);
     }
+    void set_walkmask(Bitmap *walkmask) override
+    {
+        AGS::Engine::RouteFinder::set_walkmask(walkmask);
+    }
+    void set_wallscreen_version(Bitmap *wallscreen, uint32_t version) override
+    {
+        AGS::Engine::RouteFinder::set_wallscreen_version(wallscreen, version);
+    }
     int can_see_from(int x1, int y1, int x2, int y2) override
     { 
         return AGS::Engine::RouteFinder::can_see_from(x1, y1, x2, y2); 
@@ -69,6 +86,34 @@ class AGSRouteFinder : public IRouteFinder
     { 
         AGS::Engine::RouteFinder::calculate_move_stage(mlsp, aaa); 
     }
+    void start_route_requests(int num_threads) override
+    {
+        AGS::Engine::RouteFinder::start_route_requests(num_threads);
+    }
+    bool can_request_routes() override
+    {
+        return AGS::Engine::RouteFinder::can_request_routes();
+    }
+    bool request_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int movlst, int nocross, int ignore_walls) override
+    {
+        return AGS::Engine::RouteFinder::request_route(srcx, srcy, xx, yy, onscreen, movlst, nocross, ignore_walls);
+    }
+    bool is_route_requested(int movlst) override
+    {
+        return AGS::Engine::RouteFinder::is_route_requested(movlst);
+    }
+    void complete_route_requests(std::vector<RouteResult> &results) override
+    {
+        AGS::Engine::RouteFinder::complete_route_requests(results);
+    }
+    void cancel_route_request(int movlst) override
+    {
+        AGS::Engine::RouteFinder::cancel_route_request(movlst);
+    }
+    void cancel_route_requests() override
+    {
+        AGS::Engine::RouteFinder::cancel_route_requests();
+    }
 };
 
 class AGSLegacyRouteFinder : public IRouteFinder 
@@ -86,6 +131,14 @@ class AGSLegacyRouteFinder : public IRouteFinder
     { 
         AGS::Engine::RouteFinderLegacy::set_wallscreen(wallscreen); 
     }
+    void set_walkmask(Bitmap *walkmask) override
+    {
+        // legacy path finder does not precalculate anything
+    }
+    void set_wallscreen_version(Bitmap *wallscreen, uint32_t version) override
+    {
+        // legacy path finder does not cache routes
+    }
     int can_see_from(int x1, int y1, int x2, int y2) override
     { 
         return AGS::Engine::RouteFinderLegacy::can_see_from(x1, y1, x2, y2); 
@@ -106,6 +159,17 @@ class AGSLegacyRouteFinder : public IRouteFinder
     { 
         AGS::Engine::RouteFinderLegacy::calculate_move_stage(mlsp, aaa); 
     }
+    // legacy path finder only works synchronously
+    void start_route_requests(int num_threads) override {}
+    bool can_request_routes() override { return false; }
+    bool request_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int movlst, int nocross, int ignore_walls) override
+    {
+        return false;
+    }
+    bool is_route_requested(int movlst) override { return false; }
+    void complete_route_requests(std::vector<RouteResult> &results) override { results.clear(); }
+    void cancel_route_request(int movlst) override {}
+    void cancel_route_requests() override {}
 };
 
 static IRouteFinder *route_finder_impl = nullptr;
@@ -136,6 +200,16 @@ void set_wallscreen(Bitmap *wallscreen)
     route_finder_impl->set_wallscreen(wallscreen);
 }
 
+void set_walkmask(Bitmap *walkmask)
+{
+    route_finder_impl->set_walkmask(walkmask);
+}
+
+void set_wallscreen_version(Bitmap *wallscreen, uint32_t version)
+{
+    route_finder_impl->set_wallscreen_version(wallscreen, version);
+}
+
 int can_see_from(int x1, int y1, int x2, int y2)
 {
     return route_finder_impl->can_see_from(x1, y1, x2, y2);
@@ -160,3 +234,38 @@ void calculate_move_stage(MoveList * mlsp, int aaa)
 {
     route_finder_impl->calculate_move_stage(mlsp, aaa);
 }
+
+void start_route_requests(int num_threads)
+{
+    route_finder_impl->start_route_requests(num_threads);
+}
+
+bool can_request_routes()
+{
+    return route_finder_impl->can_request_routes();
+}
+
+bool request_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int movlst, int nocross, int ignore_walls)
+{
+    return route_finder_impl->request_route(srcx, srcy, xx, yy, onscreen, movlst, nocross, ignore_walls);
+}
+
+bool is_route_requested(int movlst)
+{
+    return route_finder_impl->is_route_requested(movlst);
+}
+
+void complete_route_requests(std::vector<RouteResult> &results)
+{
+    route_finder_impl->complete_route_requests(results);
+}
+
+void cancel_route_request(int movlst)
+{
+    route_finder_impl->cancel_route_request(movlst);
+}
+
+void cancel_route_requests()
+{
+    route_finder_impl->cancel_route_requests();
+}
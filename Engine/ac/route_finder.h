@@ -15,7 +15,9 @@
 #ifndef __AC_ROUTEFND_H
 #define __AC_ROUTEFND_H
 
+#include <vector>
 #include "ac/game_version.h"
+#include "core/types.h"
 
 // Forward declaration
 namespace AGS { namespace Common { class Bitmap; }}
@@ -25,6 +27,12 @@ void init_pathfinder(GameDataVersion game_file_version);
 void shutdown_pathfinder();
 
 void set_wallscreen(AGS::Common::Bitmap *wallscreen);
+// Assigns the room's walkable mask, for which path finder may precalculate
+// data; must be called again whenever the mask changes
+void set_walkmask(AGS::Common::Bitmap *walkmask);
+// Tells the version of the walkable grid currently in the given bitmap;
+// same version means the same grid, so found routes may be reused
+void set_wallscreen_version(AGS::Common::Bitmap *wallscreen, uint32_t version);
 
 int can_see_from(int x1, int y1, int x2, int y2);
 void get_lastcpos(int &lastcx, int &lastcy);
@@ -34,4 +42,30 @@ void set_route_move_speed(int speed_x, int speed_y);
 int find_route(short srcx, short srcy, short xx, short yy, AGS::Common::Bitmap *onscreen, int movlst, int nocross = 0, int ignore_walls = 0);
 void calculate_move_stage(MoveList * mlsp, int aaa);
 
+// Route requests are solved on the worker threads, and written into their
+// movelists by complete_route_requests(); until then the movelist keeps
+// the mover standing at its starting position.
+struct RouteResult
+{
+    int  MoveList;
+    bool Found;
+};
+
+// (Re)starts worker threads for the route requests; 0 disables requests
+void start_route_requests(int num_threads);
+bool can_request_routes();
+// Queues the route search with the current move speed; the walkable bitmap
+// is copied, so it may be changed right after. Returns false if requests
+// are not supported, or if the destination is reached by a straight line,
+// in which case find_route should be called instead.
+bool request_route(short srcx, short srcy, short xx, short yy, AGS::Common::Bitmap *onscreen, int movlst, int nocross = 0, int ignore_walls = 0);
+// Tells if there's an unfinished request for the given movelist
+bool is_route_requested(int movlst);
+// Waits for all the queued requests and writes found routes into movelists;
+// returns the list of requests that were not cancelled meanwhile
+void complete_route_requests(std::vector<RouteResult> &results);
+// Drops the result of the request for the given movelist
+void cancel_route_request(int movlst);
+void cancel_route_requests();
+
 #endif // __AC_ROUTEFND_H
\ No newline at end of file
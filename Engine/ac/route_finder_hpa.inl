@@ -0,0 +1,566 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Hierarchical path planning (HPA*) over the static walkable mask.
+//
+// The map is split into square clusters. Walkable runs along the borders
+// of neighbouring clusters become entrances, and each entrance cell is an
+// abstract node. Nodes of the same cluster are connected by the precomputed
+// shortest distances inside the cluster, nodes of the neighbouring clusters
+// by a single step across the border. Long routes are planned on this
+// abstract graph and then refined by the JPS Navigation between consecutive
+// waypoints, on the actual grid which also has the dynamic obstacles.
+//
+// When the mask changes only the clusters whose contents or entrances
+// changed get their inner distances recalculated.
+//
+//=============================================================================
+
+#include <limits.h>
+#include <unordered_map>
+
+class NavHierarchy
+{
+public:
+	// cluster side, in cells
+	static const int CLUSTER_SIZE = 32;
+	// runs of walkable border cells longer than this get two entrances
+	static const int MAX_SINGLE_ENTRANCE = 6;
+	// step costs for the search inside clusters, 99/70 is just above sqrt(2)
+	static const int COST_STRAIGHT = 70;
+	static const int COST_DIAG = 99;
+	static const int NUM_BUCKETS = COST_DIAG + 1;
+	static const int NO_DIST = INT_MAX;
+
+	// search buffers; each thread planning routes needs its own
+	struct SearchState
+	{
+		// distances inside the cluster, in COST_STRAIGHT units per cell
+		std::vector<int> localDist;
+		std::vector<int> buckets[NUM_BUCKETS];
+		std::vector<unsigned char> localTarget;
+		std::vector<float> nodeDist;
+		std::vector<int> nodePrev;
+		std::vector<int> frameIds;
+		int frameId;
+
+		SearchState() : frameId(0) {}
+	};
+
+	NavHierarchy();
+
+	// (Re)builds abstract graph for the given map rows; only recalculates
+	// clusters which changed since the last build
+	void Build(int width, int height, const unsigned char * const *rows);
+	void Clear();
+
+	bool IsEmpty() const { return clusters.empty(); }
+	int GetWidth() const { return mapWidth; }
+	int GetHeight() const { return mapHeight; }
+
+	// Plans the route on the abstract graph, fills the list of waypoints
+	// (packed as Navigation squares) from start to end inclusive;
+	// returns false if there's no abstract route or the route does not need one
+	bool FindWaypoints(int sx, int sy, int ex, int ey, std::vector<int> &waypoints)
+	{
+		return FindWaypoints(sx, sy, ex, ey, waypoints, state);
+	}
+	// same as above, but uses the given search buffers, so that several
+	// routes may be planned concurrently as long as the graph is not rebuilt
+	bool FindWaypoints(int sx, int sy, int ex, int ey, std::vector<int> &waypoints,
+		SearchState &ss) const;
+
+private:
+	struct IntraEdge
+	{
+		int from; // cell index
+		int to;
+		float cost;
+	};
+
+	struct Cluster
+	{
+		// entrance cells (cell indexes), sorted
+		std::vector<int> nodeCells;
+		// shortest distances between the entrance cells inside the cluster
+		std::vector<IntraEdge> edges;
+	};
+
+	struct Edge
+	{
+		int to; // node index
+		float cost;
+	};
+
+	struct Node
+	{
+		int cell;
+		std::vector<Edge> edges;
+	};
+
+	int mapWidth;
+	int mapHeight;
+	int clustersX;
+	int clustersY;
+	// walkability copy of the map, used to detect changed clusters
+	std::vector<unsigned char> walk;
+	std::vector<Cluster> clusters;
+	std::vector<Node> nodes;
+	std::unordered_map<int, int> cellToNode;
+	// entrance pairs, as cell indexes
+	std::vector<std::pair<int, int> > transitions;
+
+	// buffers for the build and the routes planned on the owning thread
+	SearchState state;
+
+	inline bool Walk(int x, int y) const
+	{
+		return (unsigned)x < (unsigned)mapWidth && (unsigned)y < (unsigned)mapHeight &&
+			walk[y*mapWidth+x] != 0;
+	}
+
+	inline int ClusterAt(int x, int y) const
+	{
+		return (y / CLUSTER_SIZE) * clustersX + (x / CLUSTER_SIZE);
+	}
+
+	void AddTransitions(int x0, int y0, int dx, int dy, int len, int nx, int ny);
+	void FindTransitions();
+	// Runs Dijkstra inside the cluster from the given cell, fills localDist;
+	// stops early when all the target cells are reached, if these are given
+	void ClusterDistances(SearchState &ss, int cluster, int cell,
+		const int *targets = nullptr, size_t numTargets = 0) const;
+	void CalcClusterEdges(int cluster);
+};
+
+const int NavHierarchy::CLUSTER_SIZE;
+const int NavHierarchy::MAX_SINGLE_ENTRANCE;
+const int NavHierarchy::COST_STRAIGHT;
+const int NavHierarchy::COST_DIAG;
+const int NavHierarchy::NUM_BUCKETS;
+const int NavHierarchy::NO_DIST;
+
+NavHierarchy::NavHierarchy()
+	: mapWidth(0)
+	, mapHeight(0)
+	, clustersX(0)
+	, clustersY(0)
+{
+}
+
+void NavHierarchy::Clear()
+{
+	mapWidth = mapHeight = 0;
+	clustersX = clustersY = 0;
+	walk.clear();
+	clusters.clear();
+	nodes.clear();
+	cellToNode.clear();
+	transitions.clear();
+}
+
+void NavHierarchy::Build(int width, int height, const unsigned char * const *rows)
+{
+	const bool resized = width != mapWidth || height != mapHeight;
+	if (resized)
+	{
+		Clear();
+		mapWidth = width;
+		mapHeight = height;
+		clustersX = (width + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+		clustersY = (height + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+		walk.resize(width * height);
+		clusters.resize(clustersX * clustersY);
+	}
+
+	// copy the map, and note which clusters have changed
+	std::vector<bool> changed(clusters.size(), resized);
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char *dst = &walk[y*width];
+		const unsigned char *src = rows[y];
+		for (int x = 0; x < width; x++)
+		{
+			unsigned char w = src[x] != 0;
+			if (dst[x] != w)
+			{
+				dst[x] = w;
+				changed[ClusterAt(x, y)] = true;
+			}
+		}
+	}
+
+	// entrances are cheap to find, so always redo them all
+	std::vector<std::vector<int> > oldCells(clusters.size());
+	for (size_t i = 0; i < clusters.size(); i++)
+	{
+		oldCells[i].swap(clusters[i].nodeCells);
+		clusters[i].nodeCells.clear();
+	}
+	FindTransitions();
+
+	for (size_t i = 0; i < clusters.size(); i++)
+	{
+		Cluster &c = clusters[i];
+		std::sort(c.nodeCells.begin(), c.nodeCells.end());
+		c.nodeCells.erase(std::unique(c.nodeCells.begin(), c.nodeCells.end()), c.nodeCells.end());
+		if (changed[i] || c.nodeCells != oldCells[i])
+			CalcClusterEdges((int)i);
+	}
+
+	// assemble the abstract graph
+	nodes.clear();
+	cellToNode.clear();
+	for (size_t i = 0; i < clusters.size(); i++)
+	{
+		for (int cell : clusters[i].nodeCells)
+		{
+			cellToNode[cell] = (int)nodes.size();
+			Node n;
+			n.cell = cell;
+			nodes.push_back(n);
+		}
+	}
+	for (size_t i = 0; i < clusters.size(); i++)
+	{
+		for (const IntraEdge &e : clusters[i].edges)
+		{
+			Edge edge;
+			edge.to = cellToNode[e.to];
+			edge.cost = e.cost;
+			nodes[cellToNode[e.from]].edges.push_back(edge);
+		}
+	}
+	for (const auto &t : transitions)
+	{
+		const int a = cellToNode[t.first];
+		const int b = cellToNode[t.second];
+		Edge edge;
+		edge.cost = 1.f;
+		edge.to = b;
+		nodes[a].edges.push_back(edge);
+		edge.to = a;
+		nodes[b].edges.push_back(edge);
+	}
+}
+
+// x0,y0 - first cell of the border on this side, dx,dy - border direction,
+// nx,ny - offset to the neighbour cell on the other side
+void NavHierarchy::AddTransitions(int x0, int y0, int dx, int dy, int len, int nx, int ny)
+{
+	int runStart = -1;
+	for (int i = 0; i <= len; i++)
+	{
+		const int x = x0 + dx*i;
+		const int y = y0 + dy*i;
+		const bool open = i < len && Walk(x, y) && Walk(x + nx, y + ny);
+		if (open && runStart < 0)
+			runStart = i;
+		if (open || runStart < 0)
+			continue;
+
+		// end of the run
+		const int runLen = i - runStart;
+		int at[2];
+		int count = 0;
+		if (runLen > MAX_SINGLE_ENTRANCE)
+		{
+			at[count++] = runStart;
+			at[count++] = i - 1;
+		}
+		else
+		{
+			at[count++] = runStart + runLen / 2;
+		}
+		for (int k = 0; k < count; k++)
+		{
+			const int ax = x0 + dx*at[k];
+			const int ay = y0 + dy*at[k];
+			const int a = ay*mapWidth + ax;
+			const int b = (ay + ny)*mapWidth + (ax + nx);
+			clusters[ClusterAt(ax, ay)].nodeCells.push_back(a);
+			clusters[ClusterAt(ax + nx, ay + ny)].nodeCells.push_back(b);
+			transitions.push_back(std::make_pair(a, b));
+		}
+		runStart = -1;
+	}
+}
+
+void NavHierarchy::FindTransitions()
+{
+	transitions.clear();
+	for (int cy = 0; cy < clustersY; cy++)
+	{
+		for (int cx = 0; cx < clustersX; cx++)
+		{
+			const int left = cx * CLUSTER_SIZE;
+			const int top = cy * CLUSTER_SIZE;
+			const int w = std::min(CLUSTER_SIZE, mapWidth - left);
+			const int h = std::min(CLUSTER_SIZE, mapHeight - top);
+			// right border
+			if (cx + 1 < clustersX)
+				AddTransitions(left + w - 1, top, 0, 1, h, 1, 0);
+			// bottom border
+			if (cy + 1 < clustersY)
+				AddTransitions(left, top + h - 1, 1, 0, w, 0, 1);
+		}
+	}
+}
+
+void NavHierarchy::ClusterDistances(SearchState &ss, int cluster, int cell,
+	const int *targets, size_t numTargets) const
+{
+	std::vector<int> &localDist = ss.localDist;
+	std::vector<unsigned char> &localTarget = ss.localTarget;
+	std::vector<int> *buckets = ss.buckets;
+	const int left = (cluster % clustersX) * CLUSTER_SIZE;
+	const int top = (cluster / clustersX) * CLUSTER_SIZE;
+	const int right = std::min(left + CLUSTER_SIZE, mapWidth);
+	const int bottom = std::min(top + CLUSTER_SIZE, mapHeight);
+	const int w = right - left;
+
+	localDist.assign(CLUSTER_SIZE * CLUSTER_SIZE, NO_DIST);
+	localTarget.assign(CLUSTER_SIZE * CLUSTER_SIZE, 0);
+	size_t targetsLeft = numTargets;
+	for (size_t i = 0; i < numTargets; i++)
+	{
+		const int li = (targets[i] / mapWidth - top)*w + (targets[i] % mapWidth - left);
+		if (localTarget[li])
+			targetsLeft--;
+		localTarget[li] = 1;
+	}
+
+	// integer step costs let us use a circular bucket queue instead of a heap
+	for (int i = 0; i < NUM_BUCKETS; i++)
+		buckets[i].clear();
+	size_t pending = 0;
+
+	const int sx = cell % mapWidth;
+	const int sy = cell / mapWidth;
+	localDist[(sy - top)*w + (sx - left)] = 0;
+	buckets[0].push_back((sy - top)*w + (sx - left));
+	pending++;
+
+	for (int cur = 0; pending > 0; cur++)
+	{
+		std::vector<int> &bucket = buckets[cur % NUM_BUCKETS];
+		pending -= bucket.size();
+		for (size_t bi = 0; bi < bucket.size(); bi++)
+		{
+			const int li = bucket[bi];
+			if (localDist[li] != cur)
+				continue; // already settled with a shorter distance
+			if (targets && localTarget[li])
+			{
+				localTarget[li] = 0;
+				if (--targetsLeft == 0)
+					return;
+			}
+
+			const int x = left + li % w;
+			const int y = top + li / w;
+			for (int ny = y-1; ny <= y+1; ny++)
+			{
+				if (ny < top || ny >= bottom)
+					continue;
+				for (int nx = x-1; nx <= x+1; nx++)
+				{
+					if (nx < left || nx >= right || (nx == x && ny == y))
+						continue;
+					if (!walk[ny*mapWidth+nx])
+						continue;
+					const bool diag = nx != x && ny != y;
+					// same rule as Navigation::Reachable
+					if (diag && !walk[y*mapWidth+nx] && !walk[ny*mapWidth+x])
+						continue;
+					const int ndist = cur + (diag ? COST_DIAG : COST_STRAIGHT);
+					const int nli = (ny - top)*w + (nx - left);
+					if (ndist < localDist[nli])
+					{
+						localDist[nli] = ndist;
+						buckets[ndist % NUM_BUCKETS].push_back(nli);
+						pending++;
+					}
+				}
+			}
+		}
+		bucket.clear();
+	}
+}
+
+void NavHierarchy::CalcClusterEdges(int cluster)
+{
+	Cluster &c = clusters[cluster];
+	c.edges.clear();
+	if (c.nodeCells.size() < 2)
+		return;
+
+	const int left = (cluster % clustersX) * CLUSTER_SIZE;
+	const int top = (cluster / clustersX) * CLUSTER_SIZE;
+	const int w = std::min(left + CLUSTER_SIZE, mapWidth) - left;
+	// distances are symmetric, so search from each node only to the ones after it
+	for (size_t i = 0; i + 1 < c.nodeCells.size(); i++)
+	{
+		ClusterDistances(state, cluster, c.nodeCells[i], &c.nodeCells[i + 1], c.nodeCells.size() - i - 1);
+		for (size_t j = i + 1; j < c.nodeCells.size(); j++)
+		{
+			const int cell = c.nodeCells[j];
+			const int d = state.localDist[(cell / mapWidth - top)*w + (cell % mapWidth - left)];
+			if (d == NO_DIST)
+				continue;
+			IntraEdge e;
+			e.from = c.nodeCells[i];
+			e.to = cell;
+			e.cost = (float)d / COST_STRAIGHT;
+			c.edges.push_back(e);
+			std::swap(e.from, e.to);
+			c.edges.push_back(e);
+		}
+	}
+}
+
+bool NavHierarchy::FindWaypoints(int sx, int sy, int ex, int ey, std::vector<int> &waypoints,
+	SearchState &ss) const
+{
+	waypoints.clear();
+	if (!Walk(sx, sy) || !Walk(ex, ey))
+		return false;
+	const int startCluster = ClusterAt(sx, sy);
+	const int endCluster = ClusterAt(ex, ey);
+	if (startCluster == endCluster)
+		return false;
+
+	std::vector<float> &nodeDist = ss.nodeDist;
+	std::vector<int> &nodePrev = ss.nodePrev;
+	std::vector<int> &frameIds = ss.frameIds;
+	int &frameId = ss.frameId;
+	const int numNodes = (int)nodes.size();
+	// virtual goal node
+	const int goal = numNodes;
+	nodeDist.resize(numNodes + 1);
+	nodePrev.resize(numNodes + 1);
+	if (frameIds.size() != nodeDist.size())
+	{
+		frameIds.assign(nodeDist.size(), 0);
+		frameId = 0;
+	}
+	if (++frameId == 0)
+	{
+		std::fill(frameIds.begin(), frameIds.end(), 0);
+		frameId = 1;
+	}
+
+	// distances from the goal to the nodes of its cluster
+	std::vector<std::pair<int, float> > goalEdges;
+	{
+		const Cluster &c = clusters[endCluster];
+		const int left = (endCluster % clustersX) * CLUSTER_SIZE;
+		const int top = (endCluster / clustersX) * CLUSTER_SIZE;
+		const int w = std::min(left + CLUSTER_SIZE, mapWidth) - left;
+		ClusterDistances(ss, endCluster, ey*mapWidth + ex);
+		for (int cell : c.nodeCells)
+		{
+			const int d = ss.localDist[(cell / mapWidth - top)*w + (cell % mapWidth - left)];
+			if (d != NO_DIST)
+				goalEdges.push_back(std::make_pair(cellToNode.find(cell)->second, (float)d / COST_STRAIGHT));
+		}
+	}
+	if (goalEdges.empty())
+		return false;
+
+	typedef std::pair<float, int> QEntry;
+	std::priority_queue<QEntry, std::vector<QEntry>, std::greater<QEntry> > q;
+
+	auto heuristic = [&](int node) -> float
+	{
+		if (node == goal)
+			return 0.f;
+		const float dx = (float)(nodes[node].cell % mapWidth - ex);
+		const float dy = (float)(nodes[node].cell / mapWidth - ey);
+		return sqrtf(dx*dx + dy*dy);
+	};
+
+	// seed with the nodes of the start cluster
+	{
+		const Cluster &c = clusters[startCluster];
+		const int left = (startCluster % clustersX) * CLUSTER_SIZE;
+		const int top = (startCluster / clustersX) * CLUSTER_SIZE;
+		const int w = std::min(left + CLUSTER_SIZE, mapWidth) - left;
+		ClusterDistances(ss, startCluster, sy*mapWidth + sx);
+		for (int cell : c.nodeCells)
+		{
+			const int d = ss.localDist[(cell / mapWidth - top)*w + (cell % mapWidth - left)];
+			if (d == NO_DIST)
+				continue;
+			const int n = cellToNode.find(cell)->second;
+			frameIds[n] = frameId;
+			nodeDist[n] = (float)d / COST_STRAIGHT;
+			nodePrev[n] = -1;
+			q.push(QEntry(nodeDist[n] + heuristic(n), n));
+		}
+	}
+
+	bool found = false;
+	while (!q.empty())
+	{
+		QEntry e = q.top();
+		q.pop();
+		const int n = e.second;
+		if (e.first > nodeDist[n] + heuristic(n) + 0.001f)
+			continue; // stale entry
+		if (n == goal)
+		{
+			found = true;
+			break;
+		}
+
+		auto relax = [&](int to, float cost)
+		{
+			const float nd = nodeDist[n] + cost;
+			if (frameIds[to] != frameId || nd < nodeDist[to])
+			{
+				frameIds[to] = frameId;
+				nodeDist[to] = nd;
+				nodePrev[to] = n;
+				q.push(QEntry(nd + heuristic(to), to));
+			}
+		};
+
+		for (const Edge &edge : nodes[n].edges)
+			relax(edge.to, edge.cost);
+		if (ClusterAt(nodes[n].cell % mapWidth, nodes[n].cell / mapWidth) == endCluster)
+		{
+			for (const auto &ge : goalEdges)
+			{
+				if (ge.first == n)
+					relax(goal, ge.second);
+			}
+		}
+	}
+
+	if (!found)
+		return false;
+
+	waypoints.push_back(Navigation::PackSquare(ex, ey));
+	for (int n = nodePrev[goal]; n >= 0; n = nodePrev[n])
+	{
+		const int cell = nodes[n].cell;
+		waypoints.push_back(Navigation::PackSquare(cell % mapWidth, cell / mapWidth));
+	}
+	waypoints.push_back(Navigation::PackSquare(sx, sy));
+	std::reverse(waypoints.begin(), waypoints.end());
+	// start or end may themselves be the entrance cells
+	waypoints.erase(std::unique(waypoints.begin(), waypoints.end()), waypoints.end());
+	return true;
+}
@@ -20,6 +20,13 @@
 
 #include <string.h>
 #include <math.h>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 
 #include "ac/common.h"   // quit()
 #include "ac/movelist.h"     // MoveList
@@ -28,6 +35,7 @@
 #include "debug/out.h"
 
 #include "route_finder_jps.inl"
+#include "route_finder_hpa.inl"
 
 extern MoveList *mls;
 
@@ -42,12 +50,106 @@ namespace RouteFinder {
 #define MAKE_INTCOORD(x,y) (((unsigned short)x << 16) | ((unsigned short)y))
 
 static const int MAXNAVPOINTS = MAXNEEDSTAGES;
-static int navpoints[MAXNAVPOINTS];
-static int num_navpoints;
+
+// Route search state; the main thread and each of the route request workers
+// have their own one
+struct RouteSearch
+{
+  Navigation nav;
+  NavHierarchy::SearchState hierarchy_state;
+  std::vector<int> path, cpath, waypoints;
+  int navpoints[MAXNAVPOINTS];
+  int num_navpoints = 0;
+};
+
+static RouteSearch main_search;
 static fixed move_speed_x, move_speed_y;
-static Navigation nav;
 static Bitmap *wallscreen;
 static int lastcx, lastcy;
+// Abstract graph over the static walkable mask; only used for large maps,
+// where full-grid search may expand too many nodes
+static const int HIERARCHY_MIN_CELLS = 1024 * 1024;
+static NavHierarchy nav_hierarchy;
+static Bitmap *walkmask;
+static bool walkmask_changed;
+
+// Cache of the recently found routes, including failed ones; only used
+// for the wallscreen which has a version
+static const size_t ROUTE_CACHE_SIZE = 256;
+
+struct RouteKey
+{
+  uint32_t version;
+  short srcx, srcy, destx, desty;
+  int nocross;
+
+  bool operator==(const RouteKey &other) const
+  {
+    return version == other.version && srcx == other.srcx && srcy == other.srcy &&
+      destx == other.destx && desty == other.desty && nocross == other.nocross;
+  }
+};
+
+struct RouteKeyHash
+{
+  size_t operator()(const RouteKey &key) const
+  {
+    size_t h = key.version;
+    h = h * 31 + (unsigned short)key.srcx;
+    h = h * 31 + (unsigned short)key.srcy;
+    h = h * 31 + (unsigned short)key.destx;
+    h = h * 31 + (unsigned short)key.desty;
+    return h * 31 + key.nocross;
+  }
+};
+
+// navpoints by key, most recently used first
+typedef std::list<std::pair<RouteKey, std::vector<int> > > RouteCacheList;
+static RouteCacheList route_cache;
+static std::unordered_map<RouteKey, RouteCacheList::iterator, RouteKeyHash> route_cache_index;
+static Bitmap *versioned_wallscreen;
+static uint32_t wallscreen_version;
+static uint32_t route_cache_hits, route_cache_misses;
+
+// Route request, solved on the worker thread over the copy of the map
+struct RouteRequest
+{
+  uint32_t ticket;
+  int movlst;
+  short srcx, srcy, destx, desty;
+  int nocross, ignore_walls;
+  fixed move_speed_x, move_speed_y;
+  int width, height;
+  std::vector<unsigned char> map;
+  bool use_hierarchy;
+  bool dest_is_wall;
+  bool cached;
+  RouteKey key;
+  // result
+  int num_navpoints;
+  int navpoints[MAXNAVPOINTS];
+};
+
+static std::vector<std::thread> route_workers;
+static std::mutex route_mutex;
+static std::condition_variable route_work_cv; // new requests or exit
+static std::condition_variable route_done_cv; // all requests finished
+static std::deque<RouteRequest*> route_queue;
+static std::vector<RouteRequest*> route_done;
+static std::vector<RouteRequest*> route_free; // reused, to keep map buffers
+static int route_active;
+static bool route_exit;
+static uint32_t route_ticket;
+static bool route_requested; // since the last completion
+// last ticket issued for each movelist; results of the older requests are dropped
+static std::unordered_map<int, uint32_t> route_latest;
+
+uint32_t take_expanded_nodes()
+{
+  return main_search.nav.TakeExpandedNodes();
+}
+
+static void route_worker();
 
 void init_pathfinder()
 {
@@ -55,6 +157,60 @@ void init_pathfinder()
 
 void shutdown_pathfinder()
 {
+  if (route_cache_hits || route_cache_misses)
+    AGS::Common::Debug::Printf("Path finder: route cache had %u hits, %u misses", route_cache_hits, route_cache_misses);
+  route_cache.clear();
+  route_cache_index.clear();
+  versioned_wallscreen = nullptr;
+  start_route_requests(0);
+  for (RouteRequest *req : route_free)
+    delete req;
+  for (RouteRequest *req : route_done)
+    delete req;
+  route_free.clear();
+  route_done.clear();
+  nav_hierarchy.Clear();
+  walkmask = nullptr;
+}
+
+void start_route_requests(int num_threads)
+{
+  if (!route_workers.empty())
+  {
+    {
+      std::lock_guard<std::mutex> lk(route_mutex);
+      route_exit = true;
+    }
+    route_work_cv.notify_all();
+    for (std::thread &t : route_workers)
+      t.join();
+    route_workers.clear();
+    cancel_route_requests();
+  }
+
+  route_exit = false;
+  for (int i = 0; i < num_threads; i++)
+  {
+    try {
+      route_workers.push_back(std::thread(route_worker));
+    } catch (std::system_error) {
+      break;
+    }
+  }
+  if (num_threads > 0)
+    AGS::Common::Debug::Printf(AGS::Common::MessageType::kDbgMsg_Init, "Path finder: started %d route request thread(s)", (int)route_workers.size());
+}
+
+bool can_request_routes()
+{
+  return !route_workers.empty();
+}
+
+// Waits until the workers have nothing to do
+static void wait_route_workers()
+{
+  std::unique_lock<std::mutex> lk(route_mutex);
+  route_done_cv.wait(lk, [] { return route_queue.empty() && route_active == 0; });
 }
 
 void set_wallscreen(Bitmap *wallscreen_) 
@@ -62,13 +218,96 @@ void set_wallscreen(Bitmap *wallscreen_)
   wallscreen = wallscreen_;
 }
 
+void set_walkmask(Bitmap *walkmask_)
+{
+  walkmask = walkmask_;
+  walkmask_changed = true;
+  // grids on the old mask will get new versions anyway
+  route_cache.clear();
+  route_cache_index.clear();
+}
+
+void set_wallscreen_version(Bitmap *wallscreen_, uint32_t version)
+{
+  versioned_wallscreen = wallscreen_;
+  wallscreen_version = version;
+}
+
+// Makes the cache key for the route; returns false if the route should not
+// be cached
+static bool get_route_key(Bitmap *onscreen, short srcx, short srcy, short xx, short yy,
+  int nocross, int ignore_walls, RouteKey &key)
+{
+  // routes ignoring walls are not worth it
+  if (ignore_walls || onscreen != versioned_wallscreen)
+    return false;
+  key.version = wallscreen_version;
+  key.srcx = srcx;
+  key.srcy = srcy;
+  key.destx = xx;
+  key.desty = yy;
+  key.nocross = nocross;
+  return true;
+}
+
+static const std::vector<int> *find_cached_route(const RouteKey &key)
+{
+  auto it = route_cache_index.find(key);
+  if (it == route_cache_index.end())
+    return nullptr;
+  route_cache.splice(route_cache.begin(), route_cache, it->second);
+  return &it->second->second;
+}
+
+static void cache_route(const RouteKey &key, const int *navpoints, int num_navpoints)
+{
+  if (route_cache_index.count(key))
+    return;
+  if (route_cache.size() >= ROUTE_CACHE_SIZE)
+  {
+    route_cache_index.erase(route_cache.back().first);
+    route_cache.pop_back();
+  }
+  route_cache.push_front(std::make_pair(key, std::vector<int>(navpoints, navpoints + num_navpoints)));
+  route_cache_index[key] = route_cache.begin();
+}
+
+// Makes sure that the abstract graph matches current walkable mask;
+// returns false if it should not be used for the map of the given size
+static bool sync_nav_hierarchy(int map_width, int map_height)
+{
+  if (!walkmask || walkmask->GetWidth() != map_width ||
+      walkmask->GetHeight() != map_height ||
+      walkmask->GetWidth() * walkmask->GetHeight() < HIERARCHY_MIN_CELLS)
+  {
+    if (!nav_hierarchy.IsEmpty())
+    {
+      wait_route_workers();
+      nav_hierarchy.Clear();
+    }
+    return false;
+  }
+
+  if (walkmask_changed || nav_hierarchy.IsEmpty())
+  {
+    // workers may be planning on the current graph
+    wait_route_workers();
+    std::vector<const unsigned char*> rows(walkmask->GetHeight());
+    for (int y = 0; y < walkmask->GetHeight(); y++)
+      rows[y] = walkmask->GetScanLine(y);
+    nav_hierarchy.Build(walkmask->GetWidth(), walkmask->GetHeight(), &rows[0]);
+    walkmask_changed = false;
+  }
+  return true;
+}
+
 static void sync_nav_wallscreen()
 {
   // FIXME: this is dumb, but...
-  nav.Resize(wallscreen->GetWidth(), wallscreen->GetHeight());
+  main_search.nav.Resize(wallscreen->GetWidth(), wallscreen->GetHeight());
 
   for (int y=0; y<wallscreen->GetHeight(); y++)
-    nav.SetMapRow(y, wallscreen->GetScanLine(y));
+    main_search.nav.SetMapRow(y, wallscreen->GetScanLine(y));
 }
 
 int can_see_from(int x1, int y1, int x2, int y2)
@@ -81,7 +320,7 @@ int can_see_from(int x1, int y1, int x2, int y2)
 
   sync_nav_wallscreen();
 
-  return !nav.TraceLine(x1, y1, x2, y2, lastcx, lastcy);
+  return !main_search.nav.TraceLine(x1, y1, x2, y2, lastcx, lastcy);
 }
 
 void get_lastcpos(int &lastcx_, int &lastcy_) 
@@ -90,34 +329,90 @@ void get_lastcpos(int &lastcx_, int &lastcy_)
   lastcy_ = lastcy;
 }
 
-// new routing using JPS
-static int find_route_jps(int fromx, int fromy, int destx, int desty)
+// new routing using JPS; the search's map must be already set
+static int find_route_jps(RouteSearch &s, bool use_hierarchy, int fromx, int fromy, int destx, int desty)
 {
-  sync_nav_wallscreen();
+  s.path.clear();
+  s.cpath.clear();
 
-  static std::vector<int> path, cpath;
-  path.clear();
-  cpath.clear();
+  // on large maps try planning through the abstract graph first, and fall
+  // back to full search if that fails (e.g. dynamic obstacles are in the way)
+  bool found = false;
+  if (use_hierarchy && nav_hierarchy.FindWaypoints(fromx, fromy, destx, desty, s.waypoints, s.hierarchy_state))
+    found = s.nav.NavigateWaypoints(s.waypoints, s.path, s.cpath) != Navigation::NAV_UNREACHABLE;
 
-  if (nav.NavigateRefined(fromx, fromy, destx, desty, path, cpath) == Navigation::NAV_UNREACHABLE)
+  if (!found && s.nav.NavigateRefined(fromx, fromy, destx, desty, s.path, s.cpath) == Navigation::NAV_UNREACHABLE)
     return 0;
 
-  num_navpoints = 0;
+  s.num_navpoints = 0;
 
   // new behavior: cut path if too complex rather than abort with error message
-  int count = std::min<int>((int)cpath.size(), MAXNAVPOINTS);
+  int count = std::min<int>((int)s.cpath.size(), MAXNAVPOINTS);
 
   for (int i = 0; i<count; i++)
   {
     int x, y;
-    nav.UnpackSquare(cpath[i], x, y);
+    s.nav.UnpackSquare(s.cpath[i], x, y);
 
-    navpoints[num_navpoints++] = MAKE_INTCOORD(x, y);
+    s.navpoints[s.num_navpoints++] = MAKE_INTCOORD(x, y);
   }
 
   return 1;
 }
 
+// Finds navpoints of the route; the search's map must be already set
+static void find_route_navpoints(RouteSearch &s, bool use_hierarchy, bool dest_is_wall,
+  short srcx, short srcy, short xx, short yy, int nocross, int ignore_walls, int &lastcx_, int &lastcy_)
+{
+  s.num_navpoints = 0;
+
+  lastcx_ = srcx;
+  lastcy_ = srcy;
+  if (ignore_walls || (srcx == xx && srcy == yy) || !s.nav.TraceLine(srcx, srcy, xx, yy, lastcx_, lastcy_))
+  {
+    s.num_navpoints = 2;
+    s.navpoints[0] = MAKE_INTCOORD(srcx, srcy);
+    s.navpoints[1] = MAKE_INTCOORD(xx, yy);
+  } else {
+    if ((nocross == 0) && dest_is_wall)
+      return; // clicked on a wall
+
+    find_route_jps(s, use_hierarchy, srcx, srcy, xx, yy);
+  }
+}
+
+// Writes the found route into the movelist; returns movelist index, or 0
+static int write_move_list(int mlist, short srcx, short srcy, int *navpoints, int num_navpoints)
+{
+  if (!num_navpoints)
+    return 0;
+
+  // FIXME: really necessary?
+  if (num_navpoints == 1)
+    navpoints[num_navpoints++] = navpoints[0];
+
+  assert(num_navpoints <= MAXNAVPOINTS);
+
+#ifdef DEBUG_PATHFINDER
+  AGS::Common::Debug::Printf("Route from %d,%d - %d stages", srcx,srcy,num_navpoints);
+#endif
+
+  mls[mlist].numstage = num_navpoints;
+  memcpy(&mls[mlist].pos[0], &navpoints[0], sizeof(int) * num_navpoints);
+
+  for (int i=0; i<num_navpoints-1; i++)
+    RouteFinder::calculate_move_stage(&mls[mlist], i);
+
+  mls[mlist].fromx = srcx;
+  mls[mlist].fromy = srcy;
+  mls[mlist].onstage = 0;
+  mls[mlist].onpart = 0;
+  mls[mlist].doneflag = 0;
+  mls[mlist].lastx = -1;
+  mls[mlist].lasty = -1;
+  return mlist;
+}
+
 void set_route_move_speed(int speed_x, int speed_y)
 {
   // negative move speeds like -2 get converted to 1/2
@@ -216,55 +511,212 @@ void calculate_move_stage(MoveList * mlsp, int aaa)
 
 int find_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int movlst, int nocross, int ignore_walls)
 {
-  int i;
+  // this route supersedes any queued request for the same movelist
+  cancel_route_request(movlst);
 
-  wallscreen = onscreen;
+  RouteKey key = RouteKey();
+  const bool cached = get_route_key(onscreen, srcx, srcy, xx, yy, nocross, ignore_walls, key);
+  if (cached)
+  {
+    if (const std::vector<int> *navpoints = find_cached_route(key))
+    {
+      route_cache_hits++;
+      main_search.num_navpoints = (int)navpoints->size();
+      std::copy(navpoints->begin(), navpoints->end(), main_search.navpoints);
+      return write_move_list(movlst, srcx, srcy, main_search.navpoints, main_search.num_navpoints);
+    }
+    route_cache_misses++;
+  }
 
-  num_navpoints = 0;
+  wallscreen = onscreen;
+  sync_nav_wallscreen();
+  const bool use_hierarchy = !ignore_walls &&
+    sync_nav_hierarchy(wallscreen->GetWidth(), wallscreen->GetHeight());
+  find_route_navpoints(main_search, use_hierarchy, wallscreen->GetPixel(xx, yy) == 0,
+    srcx, srcy, xx, yy, nocross, ignore_walls, lastcx, lastcy);
+  if (cached)
+    cache_route(key, main_search.navpoints, main_search.num_navpoints);
+  return write_move_list(movlst, srcx, srcy, main_search.navpoints, main_search.num_navpoints);
+}
 
-  if (ignore_walls || can_see_from(srcx, srcy, xx, yy))
+static void route_worker()
+{
+  RouteSearch s;
+  std::unique_lock<std::mutex> lk(route_mutex);
+  for (;;)
   {
-    num_navpoints = 2;
-    navpoints[0] = MAKE_INTCOORD(srcx, srcy);
-    navpoints[1] = MAKE_INTCOORD(xx, yy);
-  } else {
-    if ((nocross == 0) && (wallscreen->GetPixel(xx, yy) == 0))
-      return 0; // clicked on a wall
+    route_work_cv.wait(lk, [] { return route_exit || !route_queue.empty(); });
+    if (route_exit)
+      return;
+    RouteRequest *req = route_queue.front();
+    route_queue.pop_front();
+    route_active++;
+    lk.unlock();
+
+    s.nav.Resize(req->width, req->height);
+    for (int y = 0; y < req->height; y++)
+      s.nav.SetMapRow(y, &req->map[y * req->width]);
+    int lastx, lasty;
+    find_route_navpoints(s, req->use_hierarchy, req->dest_is_wall,
+      req->srcx, req->srcy, req->destx, req->desty, req->nocross, req->ignore_walls, lastx, lasty);
+    req->num_navpoints = s.num_navpoints;
+    memcpy(req->navpoints, s.navpoints, sizeof(int) * s.num_navpoints);
+
+    lk.lock();
+    route_done.push_back(req);
+    route_active--;
+    if (route_queue.empty() && route_active == 0)
+      route_done_cv.notify_all();
+  }
+}
 
-    find_route_jps(srcx, srcy, xx, yy);
+bool request_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int movlst, int nocross, int ignore_walls)
+{
+  if (route_workers.empty())
+    return false;
+
+  // cached routes are cheaper to get right away; find_route counts the
+  // hits, and the misses of the requests which it gets instead
+  RouteKey key = RouteKey();
+  const bool cached = get_route_key(onscreen, srcx, srcy, xx, yy, nocross, ignore_walls, key);
+  if (cached && find_cached_route(key))
+    return false;
+
+  // straight line is found as quickly as the map would be copied;
+  // the map rows are only referenced here, not copied
+  wallscreen = onscreen;
+  sync_nav_wallscreen();
+  int lastx, lasty;
+  if (ignore_walls || (srcx == xx && srcy == yy) || !main_search.nav.TraceLine(srcx, srcy, xx, yy, lastx, lasty))
+    return false;
+
+  if (cached)
+    route_cache_misses++;
+
+  const int width = onscreen->GetWidth();
+  const int height = onscreen->GetHeight();
+  // the graph may only be rebuilt here, while no worker is using it
+  const bool use_hierarchy = !ignore_walls && sync_nav_hierarchy(width, height);
+
+  RouteRequest *req;
+  {
+    std::lock_guard<std::mutex> lk(route_mutex);
+    if (route_free.empty())
+    {
+      req = new RouteRequest();
+    }
+    else
+    {
+      req = route_free.back();
+      route_free.pop_back();
+    }
   }
+  req->ticket = ++route_ticket;
+  req->movlst = movlst;
+  req->srcx = srcx;
+  req->srcy = srcy;
+  req->destx = xx;
+  req->desty = yy;
+  req->nocross = nocross;
+  req->ignore_walls = ignore_walls;
+  req->move_speed_x = move_speed_x;
+  req->move_speed_y = move_speed_y;
+  req->width = width;
+  req->height = height;
+  req->use_hierarchy = use_hierarchy;
+  req->dest_is_wall = onscreen->GetPixel(xx, yy) == 0;
+  req->cached = cached;
+  req->key = key;
+  req->num_navpoints = 0;
+  // the map is copied, because the caller keeps modifying the bitmap
+  req->map.resize(width * height);
+  for (int y = 0; y < height; y++)
+    memcpy(&req->map[y * width], onscreen->GetScanLine(y), width);
+  route_latest[movlst] = req->ticket;
+  route_requested = true;
+
+  // until the route is ready the movelist just keeps them standing
+  MoveList &ml = mls[movlst];
+  ml.numstage = 2;
+  ml.pos[0] = ml.pos[1] = MAKE_INTCOORD(srcx, srcy);
+  ml.xpermove[0] = ml.ypermove[0] = 0;
+  ml.fromx = srcx;
+  ml.fromy = srcy;
+  ml.onstage = 0;
+  ml.onpart = 0;
+  ml.doneflag = 0;
+  ml.lastx = -1;
+  ml.lasty = -1;
 
-  if (!num_navpoints)
-    return 0;
+  {
+    std::lock_guard<std::mutex> lk(route_mutex);
+    route_queue.push_back(req);
+  }
+  route_work_cv.notify_one();
+  return true;
+}
 
-  // FIXME: really necessary?
-  if (num_navpoints == 1)
-    navpoints[num_navpoints++] = navpoints[0];
+bool is_route_requested(int movlst)
+{
+  return route_latest.count(movlst) > 0;
+}
 
-  assert(num_navpoints <= MAXNAVPOINTS);
+void complete_route_requests(std::vector<RouteResult> &results)
+{
+  results.clear();
+  if (!route_requested)
+    return;
+  wait_route_workers();
+  route_requested = false;
 
-#ifdef DEBUG_PATHFINDER
-  AGS::Common::Debug::Printf("Route from %d,%d to %d,%d - %d stages", srcx,srcy,xx,yy,num_navpoints);
-#endif
+  std::vector<RouteRequest*> done;
+  {
+    std::lock_guard<std::mutex> lk(route_mutex);
+    done.swap(route_done);
+  }
+  // deliver in the order of requests, so that the result does not depend
+  // on the thread timing
+  std::sort(done.begin(), done.end(),
+    [](const RouteRequest *a, const RouteRequest *b) { return a->ticket < b->ticket; });
+  const fixed speed_x = move_speed_x, speed_y = move_speed_y;
+  for (RouteRequest *req : done)
+  {
+    auto it = route_latest.find(req->movlst);
+    if (it != route_latest.end() && it->second == req->ticket)
+    {
+      route_latest.erase(it);
+      move_speed_x = req->move_speed_x;
+      move_speed_y = req->move_speed_y;
+      if (req->cached)
+        cache_route(req->key, req->navpoints, req->num_navpoints);
+      RouteResult r;
+      r.MoveList = req->movlst;
+      r.Found = write_move_list(req->movlst, req->srcx, req->srcy, req->navpoints, req->num_navpoints) > 0;
+      results.push_back(r);
+    }
+  }
+  move_speed_x = speed_x;
+  move_speed_y = speed_y;
 
-  int mlist = movlst;
-  mls[mlist].numstage = num_navpoints;
-  memcpy(&mls[mlist].pos[0], &navpoints[0], sizeof(int) * num_navpoints);
-#ifdef DEBUG_PATHFINDER
-  AGS::Common::Debug::Printf("stages: %d\n",num_navpoints);
-#endif
+  std::lock_guard<std::mutex> lk(route_mutex);
+  route_free.insert(route_free.end(), done.begin(), done.end());
+}
 
-  for (i=0; i<num_navpoints-1; i++)
-    calculate_move_stage(&mls[mlist], i);
+void cancel_route_request(int movlst)
+{
+  // the worker will still finish it, but the result is dropped
+  route_latest.erase(movlst);
+}
 
-  mls[mlist].fromx = srcx;
-  mls[mlist].fromy = srcy;
-  mls[mlist].onstage = 0;
-  mls[mlist].onpart = 0;
-  mls[mlist].doneflag = 0;
-  mls[mlist].lastx = -1;
-  mls[mlist].lasty = -1;
-  return mlist;
+void cancel_route_requests()
+{
+  route_latest.clear();
+  if (route_workers.empty())
+    return;
+  std::lock_guard<std::mutex> lk(route_mutex);
+  for (RouteRequest *req : route_queue)
+    route_free.push_back(req);
+  route_queue.clear();
 }
 
 
@@ -16,6 +16,7 @@
 #define __AC_ROUTE_FINDER_IMPL
 
 #include "ac/game_version.h"
+#include "ac/route_finder.h"
 
 // Forward declaration
 namespace AGS { namespace Common { class Bitmap; }}
@@ -29,6 +30,9 @@ void init_pathfinder();
 void shutdown_pathfinder();
 
 void set_wallscreen(AGS::Common::Bitmap *wallscreen);
+// Assigns the room's walkable mask, for which path finder may precalculate data
+void set_walkmask(AGS::Common::Bitmap *walkmask);
+void set_wallscreen_version(AGS::Common::Bitmap *wallscreen, uint32_t version);
 
 int can_see_from(int x1, int y1, int x2, int y2);
 void get_lastcpos(int &lastcx, int &lastcy);
@@ -37,6 +41,17 @@ void set_route_move_speed(int speed_x, int speed_y);
 
 int find_route(short srcx, short srcy, short xx, short yy, AGS::Common::Bitmap *onscreen, int movlst, int nocross = 0, int ignore_walls = 0);
 void calculate_move_stage(MoveList * mlsp, int aaa);
+// Returns number of nodes expanded by the synchronous path searches since
+// the last call; meant for benchmarking
+uint32_t take_expanded_nodes();
+
+void start_route_requests(int num_threads);
+bool can_request_routes();
+bool request_route(short srcx, short srcy, short xx, short yy, AGS::Common::Bitmap *onscreen, int movlst, int nocross = 0, int ignore_walls = 0);
+bool is_route_requested(int movlst);
+void complete_route_requests(std::vector<RouteResult> &results);
+void cancel_route_request(int movlst);
+void cancel_route_requests();
 
 } // namespace RouteFinder
 } // namespace Engine
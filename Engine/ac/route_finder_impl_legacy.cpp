@@ -28,6 +28,7 @@
 #include "ac/movelist.h"     // MoveList
 #include "gfx/bitmap.h"
 #include "debug/out.h"
+#include "util/geometry.h"
 
 extern void update_polled_stuff_if_runtime();
 
@@ -52,6 +53,7 @@ namespace RouteFinderLegacy {
 static int *pathbackx = nullptr;
 static int *pathbacky = nullptr;
 static int waspossible = 1;
+static uint32_t expanded_nodes = 0;
 static int suggestx;
 static int suggesty;
 static fixed move_speed_x;
@@ -116,30 +118,14 @@ int find_nearest_walkable_area(Bitmap *tempw, int fromX, int fromY, int toX, int
 {
   assert(tempw != nullptr);
 
-  int ex, ey, nearest = 99999, thisis, nearx, neary;
+  int nearx, neary;
   if (fromX < 0) fromX = 0;
   if (fromY < 0) fromY = 0;
   if (toX >= tempw->GetWidth()) toX = tempw->GetWidth() - 1;
   if (toY >= tempw->GetHeight()) toY = tempw->GetHeight() - 1;
 
-  for (ex = fromX; ex < toX; ex += granularity) 
-  {
-    for (ey = fromY; ey < toY; ey += granularity) 
-    {
-      if (tempw->GetScanLine(ey)[ex] != 232)
-        continue;
-
-      thisis = (int)::sqrt((double)((ex - destX) * (ex - destX) + (ey - destY) * (ey - destY)));
-      if (thisis < nearest)
-      {
-        nearest = thisis;
-        nearx = ex;
-        neary = ey;
-      }
-    }
-  }
-
-  if (nearest < 90000) {
+  auto is_reachable = [tempw](int ex, int ey) { return tempw->GetScanLine(ey)[ex] == 232; };
+  if (FindNearestGridPoint(fromX, fromY, toX, toY, granularity, destX, destY, is_reachable, nearx, neary)) {
     suggestx = nearx;
     suggesty = neary;
     return 1;
@@ -276,6 +262,7 @@ static int try_this_square(int srcx, int srcy, int tox, int toy)
   assert(pathbackx != nullptr);
   assert(pathbacky != nullptr);
   assert(beenhere != nullptr);
+  expanded_nodes++;
 
   if (beenhere[srcy][srcx] & 0x80)
     return 0;
@@ -468,6 +455,7 @@ static int find_route_dijkstra(int fromx, int fromy, int destx, int desty)
     for (int n = 0; n < iteration; n++) {
       if (visited[n] == -1)
         continue;
+      expanded_nodes++;
 
       i = visited[n] % wallscreen->GetWidth();
       j = visited[n] / wallscreen->GetWidth();
@@ -903,6 +891,13 @@ stage_again:
 #endif
 }
 
+uint32_t take_expanded_nodes()
+{
+  uint32_t n = expanded_nodes;
+  expanded_nodes = 0;
+  return n;
+}
+
 void shutdown_pathfinder()
 {
   if (pathbackx != nullptr) 
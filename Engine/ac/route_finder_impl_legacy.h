@@ -15,6 +15,8 @@
 #ifndef __AC_ROUTE_FINDER_IMPL_LEGACY
 #define __AC_ROUTE_FINDER_IMPL_LEGACY
 
+#include "core/types.h"
+
 // Forward declaration
 namespace AGS { namespace Common { class Bitmap; }}
 struct MoveList;
@@ -35,6 +37,9 @@ void set_route_move_speed(int speed_x, int speed_y);
 
 int find_route(short srcx, short srcy, short xx, short yy, AGS::Common::Bitmap *onscreen, int movlst, int nocross = 0, int ignore_walls = 0);
 void calculate_move_stage(MoveList * mlsp, int aaa);
+// Returns number of nodes expanded by the path searches since the last call;
+// meant for benchmarking
+uint32_t take_expanded_nodes();
 
 } // namespace RouteFinderLegacy
 } // namespace Engine
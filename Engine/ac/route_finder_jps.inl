@@ -23,6 +23,8 @@
 #include <functional>
 #include <assert.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include <math.h>
 
 // TODO: this could be cleaned up/simplified ...
@@ -54,11 +56,20 @@ public:
 
 	NavResult Navigate(int sx, int sy, int ex, int ey, std::vector<int> &opath);
 
+	// same as NavigateRefined, but goes through the given waypoints (which
+	// include start and end), navigating between each pair of them;
+	// returns NAV_UNREACHABLE if any of the waypoints can't be reached exactly
+	NavResult NavigateWaypoints(const std::vector<int> &waypoints, std::vector<int> &opath,
+		std::vector<int> &ncpath);
+
 	bool TraceLine(int srcx, int srcy, int targx, int targy, int &lastValidX, int &lastValidY) const;
 	bool TraceLine(int srcx, int srcy, int targx, int targy, std::vector<int> *rpath = nullptr) const;
 
 	inline void SetMapRow(int y, const unsigned char *row) {map[y] = row;}
 
+	// returns number of nodes expanded since the last call
+	inline unsigned TakeExpandedNodes() {unsigned n = expandedNodes; expandedNodes = 0; return n;}
+
 	inline static int PackSquare(int x, int y);
 	inline static void UnpackSquare(int sq, int &x, int &y);
 
@@ -124,6 +135,7 @@ private:
 	mutable std::vector<int> fpath;
 	std::vector<int> ncpathIndex;
 	std::vector<int> rayPath, orayPath;
+	std::vector<int> segPath;
 
 	// temps for routing towards unreachable areas
 	int cnode;
@@ -134,6 +146,8 @@ private:
 
 	bool navLock;
 
+	unsigned expandedNodes;
+
 	void IncFrameId();
 
 	// outside map test
@@ -151,6 +165,31 @@ private:
 	// neighbor reachable (nodiag only)
 	bool Reachable(int x0, int y0, int x1, int y1) const;
 
+	// horizontal runs are scanned 8 cells at a time
+	static inline uint64_t LoadCells(const unsigned char *p)
+	{
+		uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	// returns nonzero if any of the 8 cells is not walkable; exact, so that
+	// it may be combined with other masks
+	static inline uint64_t ZeroCells(uint64_t v)
+	{
+		const uint64_t lo7 = 0x7f7f7f7f7f7f7f7fULL;
+		return ~(((v & lo7) + lo7) | v | lo7);
+	}
+
+	// tests if the row's cells x0..x1 inclusive are all walkable, unchecked
+	bool RowWalkable(int y, int x0, int x1) const;
+	// advances horizontal jump over the cells which are walkable, have
+	// no forced neighbors and are not the target; returns the last one
+	int SkipRowJump(int x, int y, int dx, int ex, int ey);
+
+	// compresses found path into navpoints, and straightens it
+	void RefinePath(std::vector<int> &opath, std::vector<int> &ncpath);
+
 	static inline int sign(int n)
 	{
 		return n < 0 ? -1 : (n > 0 ? 1 : 0);
@@ -190,6 +229,7 @@ Navigation::Navigation()
 	// no diagonal route - this should correspond to what AGS does
 	, nodiag(true)
 	, navLock(false)
+	, expandedNodes(0)
 {
 }
 
@@ -281,12 +321,86 @@ bool Navigation::HasForcedNeighbor(int x, int y, int dx, int dy) const
 		(!Passable(x, y - dy) && Passable(x + dx, y - dy));
 }
 
+bool Navigation::RowWalkable(int y, int x0, int x1) const
+{
+	const unsigned char *row = map[y];
+	int x = x0;
+
+	for (; x + 8 <= x1 + 1; x += 8)
+	{
+		if (ZeroCells(LoadCells(row + x)))
+			return false;
+	}
+
+	for (; x <= x1; x++)
+	{
+		if (!row[x])
+			return false;
+	}
+
+	return true;
+}
+
+int Navigation::SkipRowJump(int x, int y, int dx, int ex, int ey)
+{
+	const unsigned char *row = map[y];
+	const unsigned char *above = y > 0 ? map[y-1] : nullptr;
+	const unsigned char *below = y+1 < mapHeight ? map[y+1] : nullptr;
+
+	// a block holds cells nx..nx+7, forced neighbor test also reads
+	// one cell further in the jump direction
+	int nx = dx > 0 ? x + 1 : x - 8;
+	int first = nx;
+
+	for (;;)
+	{
+		if (dx > 0 ? nx + 8 >= mapWidth : nx - 1 < 0)
+			break;
+
+		if (y == ey && ex >= nx && ex < nx + 8)
+			break;
+
+		uint64_t stop = ZeroCells(LoadCells(row + nx));
+
+		// forced neighbor: blocked above/below, but open one step further
+		if (above)
+			stop |= ZeroCells(LoadCells(above + nx)) & ~ZeroCells(LoadCells(above + nx + dx));
+
+		if (below)
+			stop |= ZeroCells(LoadCells(below + nx)) & ~ZeroCells(LoadCells(below + nx + dx));
+
+		if (stop)
+			break;
+
+		nx += dx * 8;
+	}
+
+	if (nx == first)
+		return x;
+
+	// last skipped cell, and the skipped cell closest to target
+	int last = dx > 0 ? nx - 1 : nx + 8;
+	int cx = iclamp(ex, std::min(x + dx, last), std::max(x + dx, last));
+	int edist = ClosestDist(cx - ex, y - ey);
+
+	if (edist < closest)
+	{
+		closest = edist;
+		cnode = PackSquare(cx, y);
+	}
+
+	return last;
+}
+
 int Navigation::FindOrthoJump(int x, int y, int dx, int dy, int ex, int ey)
 {
 	assert((!dx || !dy) && (dx || dy));
 
 	for (;;)
 	{
+		if (!dy && !Outside(x, y))
+			x = SkipRowJump(x, y, dx, ex, ey);
+
 		x += dx;
 		y += dy;
 
@@ -379,6 +493,7 @@ Navigation::NavResult Navigation::Navigate(int sx, int sy, int ex, int ey, std::
 	{
 		Entry e = pq.top();
 		pq.pop();
+		expandedNodes++;
 
 		int x, y;
 		UnpackSquare(e.index, x, y);
@@ -675,8 +790,53 @@ Navigation::NavResult Navigation::NavigateRefined(int sx, int sy, int ex, int ey
 		return res;
 	}
 
-	int fx = sx;
-	int fy = sy;
+	RefinePath(opath, ncpath);
+	return NAV_PATH;
+}
+
+Navigation::NavResult Navigation::NavigateWaypoints(const std::vector<int> &waypoints,
+	std::vector<int> &opath, std::vector<int> &ncpath)
+{
+	ncpath.clear();
+	opath.clear();
+
+	if (waypoints.size() < 2)
+		return NAV_UNREACHABLE;
+
+	for (int i = 0; i < (int)waypoints.size(); i++)
+	{
+		int x, y;
+		UnpackSquare(waypoints[i], x, y);
+		// waypoints come from the static map, dynamic obstacles may cover them
+		if (!Passable(x, y))
+			return NAV_UNREACHABLE;
+	}
+
+	for (int i = 1; i < (int)waypoints.size(); i++)
+	{
+		int sx, sy, ex, ey;
+		UnpackSquare(waypoints[i-1], sx, sy);
+		UnpackSquare(waypoints[i], ex, ey);
+
+		NavResult res = Navigate(sx, sy, ex, ey, segPath);
+
+		if (res == NAV_UNREACHABLE || segPath.empty() || segPath.back() != waypoints[i])
+			return NAV_UNREACHABLE;
+
+		for (int j = opath.empty() ? 0 : 1; j < (int)segPath.size(); j++)
+			opath.push_back(segPath[j]);
+	}
+
+	RefinePath(opath, ncpath);
+	return NAV_PATH;
+}
+
+void Navigation::RefinePath(std::vector<int> &opath, std::vector<int> &ncpath)
+{
+	ncpath.clear();
+
+	int fx, fy;
+	UnpackSquare(opath[0], fx, fy);
 
 	fpath.clear();
 	ncpathIndex.clear();
@@ -801,7 +961,7 @@ Navigation::NavResult Navigation::NavigateRefined(int sx, int sy, int ex, int ey
 	}
 
 	if (!adjusted)
-		return NAV_PATH;
+		return;
 
 	// final step (if necessary) is to reconstruct path from compressed path
 
@@ -821,8 +981,6 @@ Navigation::NavResult Navigation::NavigateRefined(int sx, int sy, int ex, int ey
 		for (int j=1; j<(int)rayPath.size(); j++)
 			opath.push_back(rayPath[j]);
 	}
-
-	return NAV_PATH;
 }
 
 bool Navigation::TraceLine(int srcx, int srcy, int targx, int targy, int &lastValidX, int &lastValidY) const
@@ -864,8 +1022,9 @@ bool Navigation::TraceLine(int srcx, int srcy, int targx, int targy, std::vector
 	}
 
 	int xinc, yinc;
+	const bool xmajor = iabs(dx) >= iabs(dy);
 
-	if (iabs(dx) >= iabs(dy))
+	if (xmajor)
 	{
 		// step along x
 		xinc = sign(dx) * 65536;
@@ -887,6 +1046,34 @@ bool Navigation::TraceLine(int srcx, int srcy, int targx, int targy, std::vector
 
 	while (x != ex || y != ey)
 	{
+		// skip the steps which stay on this row, if all of their cells
+		// are walkable; steps within a row are always reachable
+		if (xmajor && !Outside(x, y))
+		{
+			const int xs = sign(xinc);
+			int run = iabs(ex - x) - 1;
+
+			if (yinc > 0)
+				run = std::min(run, (((y + 1) << 16) - 1 - fy) / yinc);
+			else if (yinc < 0)
+				run = std::min(run, (fy - (y << 16)) / -yinc);
+
+			run = std::min(run, xs > 0 ? mapWidth - 1 - x : x);
+
+			if (run >= 8 && RowWalkable(y, std::min(x, x + run*xs), std::max(x, x + run*xs)))
+			{
+				if (rpath)
+				{
+					for (int i = 0; i < run; i++)
+						rpath->push_back(PackSquare(x + i*xs, y));
+				}
+
+				x += run*xs;
+				fx += run*xinc;
+				fy += run*yinc;
+			}
+		}
+
 		if (!Passable(x, y))
 			return true;
 
@@ -21,6 +21,7 @@
 #include <unistd.h>
 #endif
 #include <thread>
+#include "media/audio/audio_system.h"
 #include "platform/base/agsplatformdriver.h"
 
 namespace {
@@ -70,7 +71,11 @@ void WaitForNextFrame()
 
     auto frame_time_remaining = next_frame_timestamp - now;
     if (frame_time_remaining > std::chrono::milliseconds::zero()) {
-        std::this_thread::sleep_for(frame_time_remaining);
+        // without the audio thread, keep the sounds filled over the wait
+        update_polled_mp3();
+        frame_time_remaining = next_frame_timestamp - AGS_Clock::now();
+        if (frame_time_remaining > std::chrono::milliseconds::zero())
+            std::this_thread::sleep_for(frame_time_remaining);
     }
     
     next_frame_timestamp += frameDuration;
@@ -12,6 +12,8 @@
 //
 //=============================================================================
 
+#include <algorithm>
+#include <vector>
 #include "ac/common.h"
 #include "ac/object.h"
 #include "ac/character.h"
@@ -21,6 +23,7 @@
 #include "ac/room.h"
 #include "ac/roomobject.h"
 #include "ac/roomstatus.h"
+#include "ac/route_finder.h"
 #include "ac/walkablearea.h"
 #include "game/roomstruct.h"
 #include "gfx/bitmap.h"
@@ -35,6 +38,31 @@ extern RoomStatus*croom;
 extern RoomObject*objs;
 
 Bitmap *walkareabackup=nullptr, *walkable_areas_temp = nullptr;
+// Blocking rectangles of characters and objects stamped onto the
+// walkable_areas_temp by the last prepare_walkable_areas, in mask coords;
+// outside of these walkable_areas_temp matches the room's walkable mask
+static std::vector<Rect> walkable_temp_stamps;
+static bool walkable_temp_valid = false;
+// Recently prepared sets of blocking rectangles, most recent first, and
+// the versions given to the walkable grids they produced; this lets the
+// path finder recognize a grid it has already searched on
+struct WalkableTempVersion
+{
+    std::vector<Rect> Stamps;
+    uint32_t Version;
+};
+static const size_t MAX_WALKABLE_TEMP_VERSIONS = 8;
+static std::vector<WalkableTempVersion> walkable_temp_versions;
+static uint32_t walkable_temp_last_version = 0;
+
+void invalidate_walkable_areas_temp() {
+    walkable_temp_valid = false;
+    walkable_temp_stamps.clear();
+    // previous grids can't be produced anymore
+    walkable_temp_versions.clear();
+    // path finder may have precalculated data for the mask too
+    set_walkmask(thisroom.WalkAreaMask.get());
+}
 
 void redo_walkable_areas() {
 
@@ -55,44 +83,82 @@ void redo_walkable_areas() {
         }
     }
 
+    invalidate_walkable_areas_temp();
 }
 
 int get_walkable_area_pixel(int x, int y)
 {
-    return thisroom.WalkAreaMask->GetPixel(room_to_mask_coord(x), room_to_mask_coord(y));
+    return get_room_mask_pixel(thisroom.WalkAreaMask.get(), room_to_mask_coord(x), room_to_mask_coord(y));
+}
+
+// Vector scaling of the walkable area, precalculated for each mask row
+// between area's Top and Bottom; remembers the scaling range it was made
+// for, so that it gets recalculated after SetAreaScaling
+struct AreaScalingRows
+{
+    int Far = 0;
+    int Near = NOT_VECTOR_SCALED;
+    std::vector<int> Zoom;
+};
+static AreaScalingRows area_scaling[MAX_WALK_AREAS + 1];
+
+static void calc_area_scaling_rows(int onarea)
+{
+    const WalkArea &area = thisroom.WalkAreas[onarea];
+    AreaScalingRows &rows = area_scaling[onarea];
+    rows.Far = area.ScalingFar;
+    rows.Near = area.ScalingNear;
+    rows.Zoom.clear();
+    if (area.ScalingNear == NOT_VECTOR_SCALED)
+        return;
+    // an area without pixels still gets its top line
+    rows.Zoom.resize(std::max(area.Bottom - area.Top + 1, 1));
+    for (int yy = area.Top; yy < area.Top + (int)rows.Zoom.size(); ++yy)
+    {
+        int zoom_level;
+        // Work it all out without having to use floats
+        // Percent = ((y - top) * 100) / (areabottom - areatop)
+        // Zoom level = ((max - min) * Percent) / 100
+        if (area.Bottom != area.Top)
+        {
+            int percent = ((yy - area.Top) * 100) / (area.Bottom - area.Top);
+            zoom_level = ((area.ScalingNear - area.ScalingFar) * (percent)) / 100 + area.ScalingFar;
+        }
+        else
+        {
+            // Special case for 1px tall walkable area: take bottom line scaling
+            zoom_level = area.ScalingNear;
+        }
+        rows.Zoom[yy - area.Top] = zoom_level + 100;
+    }
+}
+
+void init_area_scaling()
+{
+    for (int i = 0; i <= MAX_WALK_AREAS; ++i)
+        calc_area_scaling_rows(i);
 }
 
 int get_area_scaling (int onarea, int xx, int yy) {
 
     int zoom_level = 100;
-    xx = room_to_mask_coord(xx);
     yy = room_to_mask_coord(yy);
 
     if ((onarea >= 0) && (onarea <= MAX_WALK_AREAS) &&
         (thisroom.WalkAreas[onarea].ScalingNear != NOT_VECTOR_SCALED)) {
             // We have vector scaling!
+            const WalkArea &area = thisroom.WalkAreas[onarea];
+            AreaScalingRows &rows = area_scaling[onarea];
+            if ((rows.Far != area.ScalingFar) || (rows.Near != area.ScalingNear) || rows.Zoom.empty())
+                calc_area_scaling_rows(onarea);
             // In case the character is off the screen, limit the Y co-ordinate
             // to within the area range (otherwise we get silly zoom levels
             // that cause Out Of Memory crashes)
-            if (yy > thisroom.WalkAreas[onarea].Bottom)
-                yy = thisroom.WalkAreas[onarea].Bottom;
-            if (yy < thisroom.WalkAreas[onarea].Top)
-                yy = thisroom.WalkAreas[onarea].Top;
-            // Work it all out without having to use floats
-            // Percent = ((y - top) * 100) / (areabottom - areatop)
-            // Zoom level = ((max - min) * Percent) / 100
-            if (thisroom.WalkAreas[onarea].Bottom != thisroom.WalkAreas[onarea].Top)
-            {
-                int percent = ((yy - thisroom.WalkAreas[onarea].Top) * 100)
-                    / (thisroom.WalkAreas[onarea].Bottom - thisroom.WalkAreas[onarea].Top);
-                zoom_level = ((thisroom.WalkAreas[onarea].ScalingNear - thisroom.WalkAreas[onarea].ScalingFar) * (percent)) / 100 + thisroom.WalkAreas[onarea].ScalingFar;
-            }
-            else
-            {
-                // Special case for 1px tall walkable area: take bottom line scaling
-                zoom_level = thisroom.WalkAreas[onarea].ScalingNear;
-            }
-            zoom_level += 100;
+            if (yy > area.Bottom)
+                yy = area.Bottom;
+            if (yy < area.Top)
+                yy = area.Top;
+            zoom_level = rows.Zoom[std::min<int>(yy - area.Top, rows.Zoom.size() - 1)];
     }
     else if ((onarea >= 0) & (onarea <= MAX_WALK_AREAS))
         zoom_level = thisroom.WalkAreas[onarea].ScalingFar + 100;
@@ -119,18 +185,51 @@ void remove_walkable_areas_from_temp(int fromx, int cwidth, int starty, int endy
     starty = room_to_mask_coord(starty);
     endy = room_to_mask_coord(endy);
 
-    int yyy;
-    if (endy >= walkable_areas_temp->GetHeight())
-        endy = walkable_areas_temp->GetHeight() - 1;
-    if (starty < 0)
-        starty = 0;
+    if (cwidth <= 0 || endy < starty)
+        return;
+    Rect rc = IntersectRects(Rect(fromx, starty, fromx + cwidth - 1, endy),
+        RectWH(0, 0, walkable_areas_temp->GetWidth(), walkable_areas_temp->GetHeight()));
+    if (rc.IsEmpty())
+        return;
+    walkable_areas_temp->FillRect(rc, 0);
+    walkable_temp_stamps.push_back(rc);
+}
+
+static bool are_stamps_equal(const std::vector<Rect> &a, const std::vector<Rect> &b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].Left != b[i].Left || a[i].Top != b[i].Top ||
+            a[i].Right != b[i].Right || a[i].Bottom != b[i].Bottom)
+            return false;
+    }
+    return true;
+}
+
+// Assigns the version to the grid in walkable_areas_temp and passes it
+// to the path finder; identical grids get the same version
+static Bitmap *version_walkable_areas_temp() {
+    size_t found = walkable_temp_versions.size();
+    for (size_t i = 0; i < walkable_temp_versions.size(); ++i) {
+        if (are_stamps_equal(walkable_temp_versions[i].Stamps, walkable_temp_stamps)) {
+            found = i;
+            break;
+        }
+    }
 
-    for (; cwidth > 0; cwidth --) {
-        for (yyy = starty; yyy <= endy; yyy++)
-            walkable_areas_temp->PutPixel (fromx, yyy, 0);
-        fromx ++;
+    if (found == walkable_temp_versions.size()) {
+        if (walkable_temp_versions.size() < MAX_WALKABLE_TEMP_VERSIONS)
+            walkable_temp_versions.push_back(WalkableTempVersion());
+        found = walkable_temp_versions.size() - 1;
+        walkable_temp_versions[found].Stamps = walkable_temp_stamps;
+        walkable_temp_versions[found].Version = ++walkable_temp_last_version;
     }
+    // keep the most recent first
+    std::rotate(walkable_temp_versions.begin(), walkable_temp_versions.begin() + found,
+        walkable_temp_versions.begin() + found + 1);
 
+    set_wallscreen_version(walkable_areas_temp, walkable_temp_versions[0].Version);
+    return walkable_areas_temp;
 }
 
 int is_point_in_rect(int x, int y, int left, int top, int right, int bottom) {
@@ -140,12 +239,23 @@ int is_point_in_rect(int x, int y, int left, int top, int right, int bottom) {
 }
 
 Bitmap *prepare_walkable_areas (int sourceChar) {
-    // copy the walkable areas to the temp bitmap
-    walkable_areas_temp->Blit(thisroom.WalkAreaMask.get(), 0,0,0,0,thisroom.WalkAreaMask->GetWidth(),thisroom.WalkAreaMask->GetHeight());
+    // copy the walkable areas to the temp bitmap; if it is already a copy,
+    // then only restore the parts covered by the last blocking rectangles
+    if (!walkable_temp_valid)
+    {
+        walkable_areas_temp->Blit(thisroom.WalkAreaMask.get(), 0,0,0,0,thisroom.WalkAreaMask->GetWidth(),thisroom.WalkAreaMask->GetHeight());
+        walkable_temp_valid = true;
+    }
+    else
+    {
+        for (const auto &rc : walkable_temp_stamps)
+            walkable_areas_temp->Blit(thisroom.WalkAreaMask.get(), rc.Left, rc.Top, rc.Left, rc.Top, rc.GetWidth(), rc.GetHeight());
+    }
+    walkable_temp_stamps.clear();
     // if the character who's moving doesn't Bitmap *, don't bother checking
     if (sourceChar < 0) ;
     else if (game.chars[sourceChar].flags & CHF_NOBLOCKING)
-        return walkable_areas_temp;
+        return version_walkable_areas_temp();
 
     int ww;
     // for each character in the current room, make the area under
@@ -193,7 +303,7 @@ Bitmap *prepare_walkable_areas (int sourceChar) {
         remove_walkable_areas_from_temp(x1, width, y1, y2);
     }
 
-    return walkable_areas_temp;
+    return version_walkable_areas_temp();
 }
 
 // return the walkable area at the character's feet, taking into account
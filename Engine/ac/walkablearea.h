@@ -19,7 +19,12 @@
 #define __AGS_EE_AC__WALKABLEAREA_H
 
 void  redo_walkable_areas();
+// Tells that the walkable mask was changed: next prepare_walkable_areas
+// must copy it whole, and path finder has to update its data
+void  invalidate_walkable_areas_temp();
 int   get_walkable_area_pixel(int x, int y);
+// Precalculates vector scaling of the walkable areas for each mask row
+void  init_area_scaling();
 int   get_area_scaling (int onarea, int xx, int yy);
 void  scale_sprite_size(int sppic, int zoom_level, int *newwidth, int *newheight);
 void  remove_walkable_areas_from_temp(int fromx, int cwidth, int starty, int endy);
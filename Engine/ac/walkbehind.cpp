@@ -37,48 +37,69 @@ int walkBehindsCachedForBgNum = 0;
 WalkBehindMethodEnum walkBehindMethod = DrawOverCharSprite;
 int walk_behind_baselines_changed = 0;
 
-void update_walk_behind_images()
+static void update_walk_behind_image(int ee)
 {
-  int ee, rr;
+  int rr;
   int bpp = (thisroom.BgFrames[play.bg_frame].Graphic->GetColorDepth() + 7) / 8;
-  Bitmap *wbbmp;
-  for (ee = 1; ee < MAX_WALK_BEHINDS; ee++)
+  Bitmap *wbbmp = BitmapHelper::CreateTransparentBitmap( 
+                           (walkBehindRight[ee] - walkBehindLeft[ee]) + 1,
+                           (walkBehindBottom[ee] - walkBehindTop[ee]) + 1,
+						   thisroom.BgFrames[play.bg_frame].Graphic->GetColorDepth());
+  int yy, startX = walkBehindLeft[ee], startY = walkBehindTop[ee];
+  for (rr = startX; rr <= walkBehindRight[ee]; rr++)
   {
-    update_polled_stuff_if_runtime();
-    
-    if (walkBehindRight[ee] > 0)
+    for (yy = startY; yy <= walkBehindBottom[ee]; yy++)
     {
-      wbbmp = BitmapHelper::CreateTransparentBitmap( 
-                               (walkBehindRight[ee] - walkBehindLeft[ee]) + 1,
-                               (walkBehindBottom[ee] - walkBehindTop[ee]) + 1,
-							   thisroom.BgFrames[play.bg_frame].Graphic->GetColorDepth());
-      int yy, startX = walkBehindLeft[ee], startY = walkBehindTop[ee];
-      for (rr = startX; rr <= walkBehindRight[ee]; rr++)
+      if (thisroom.WalkBehindMask->GetScanLine(yy)[rr] == ee)
       {
-        for (yy = startY; yy <= walkBehindBottom[ee]; yy++)
-        {
-          if (thisroom.WalkBehindMask->GetScanLine(yy)[rr] == ee)
-          {
-            for (int ii = 0; ii < bpp; ii++)
-              wbbmp->GetScanLineForWriting(yy - startY)[(rr - startX) * bpp + ii] = thisroom.BgFrames[play.bg_frame].Graphic->GetScanLine(yy)[rr * bpp + ii];
-          }
-        }
+        for (int ii = 0; ii < bpp; ii++)
+          wbbmp->GetScanLineForWriting(yy - startY)[(rr - startX) * bpp + ii] = thisroom.BgFrames[play.bg_frame].Graphic->GetScanLine(yy)[rr * bpp + ii];
       }
+    }
+  }
 
-      update_polled_stuff_if_runtime();
+  update_polled_stuff_if_runtime();
 
-      if (walkBehindBitmap[ee] != nullptr)
-      {
-        gfxDriver->DestroyDDB(walkBehindBitmap[ee]);
-      }
-      walkBehindBitmap[ee] = gfxDriver->CreateDDBFromBitmap(wbbmp, false);
-      delete wbbmp;
-    }
+  if (walkBehindBitmap[ee] != nullptr)
+  {
+    gfxDriver->DestroyDDB(walkBehindBitmap[ee]);
+  }
+  walkBehindBitmap[ee] = gfxDriver->CreateDDBFromBitmap(wbbmp, false);
+  delete wbbmp;
+}
+
+void update_walk_behind_images()
+{
+  for (int ee = 1; ee < MAX_WALK_BEHINDS; ee++)
+  {
+    update_polled_stuff_if_runtime();
+
+    if (walkBehindRight[ee] > 0)
+      update_walk_behind_image(ee);
   }
 
   walkBehindsCachedForBgNum = play.bg_frame;
 }
 
+void update_walk_behind_images(const Rect &area)
+{
+  // images cached for another background have to be remade whole
+  if (walkBehindsCachedForBgNum != play.bg_frame)
+  {
+    update_walk_behind_images();
+    return;
+  }
+
+  for (int ee = 1; ee < MAX_WALK_BEHINDS; ee++)
+  {
+    if ((walkBehindRight[ee] > 0) && AreRectsIntersecting(area,
+        Rect(walkBehindLeft[ee], walkBehindTop[ee], walkBehindRight[ee], walkBehindBottom[ee])))
+    {
+      update_polled_stuff_if_runtime();
+      update_walk_behind_image(ee);
+    }
+  }
+}
 
 void recache_walk_behinds () {
   if (walkBehindExists) {
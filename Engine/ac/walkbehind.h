@@ -18,6 +18,8 @@
 #ifndef __AGS_EE_AC__WALKBEHIND_H
 #define __AGS_EE_AC__WALKBEHIND_H
 
+#include "util/geometry.h"
+
 enum WalkBehindMethodEnum
 {
     DrawOverCharSprite,
@@ -26,6 +28,8 @@ enum WalkBehindMethodEnum
 };
 
 void update_walk_behind_images();
+// Remakes only the walk-behind images which intersect the changed background area
+void update_walk_behind_images(const Rect &area);
 void recache_walk_behinds ();
 
 #endif // __AGS_EE_AC__WALKBEHIND_H
@@ -21,6 +21,8 @@
 #include "debug/debug_log.h"
 #include "debug/debugger.h"
 #include "debug/debugmanager.h"
+#include "debug/assettrace.h"
+#include "debug/frametiming.h"
 #include "debug/out.h"
 #include "debug/consoleoutputtarget.h"
 #include "debug/logfile.h"
@@ -164,10 +166,34 @@ void apply_debug_config(const ConfigTree &cfg)
     }
     DbgMgr.UnregisterOutput(OutputMsgBufID);
     DebugMsgBuff.reset();
+
+    if (INIreadint(cfg, "misc", "frame_timing", 0) != 0)
+        FrameTiming::Enable();
+    if (INIreadint(cfg, "misc", "asset_trace", 0) != 0)
+        AssetTrace::Enable();
 }
 
 void shutdown_debug()
 {
+    if (FrameTiming::IsEnabled())
+    {
+        String trace_path = platform->GetAppOutputDirectory();
+        trace_path.Append("/ags_frametiming.json");
+        if (FrameTiming::ExportChromeTrace(trace_path))
+            platform->WriteStdOut("Frame timing written to %s", trace_path.GetCStr());
+        FrameTiming::Disable();
+    }
+    if (AssetTrace::IsEnabled())
+    {
+        String report_path = platform->GetAppOutputDirectory();
+        report_path.Append("/ags_assetio.txt");
+        String csv_path = platform->GetAppOutputDirectory();
+        csv_path.Append("/ags_assetio.csv");
+        if (AssetTrace::WriteReport(report_path) && AssetTrace::WriteCSV(csv_path))
+            platform->WriteStdOut("Asset I/O report written to %s", report_path.GetCStr());
+        AssetTrace::Disable();
+    }
+
     // Shutdown output subsystem
     DbgMgr.UnregisterAll();
 
@@ -432,10 +458,7 @@ bool send_exception_to_editor(const char *qmsg)
         return false;
 
     while ((check_for_messages_from_editor() == 0) && (want_exit == 0))
-    {
-        update_polled_mp3();
         platform->Delay(10);
-    }
 #endif
     return true;
 }
@@ -1703,6 +1703,76 @@ void OGLGraphicsDriver::UpdateDDBFromBitmap(IDriverDependantBitmap* bitmapToUpda
       unselect_palette();
 }
 
+void OGLGraphicsDriver::UpdateTextureSubRegion(OGLTextureTile *tile, Bitmap *bitmap, OGLBitmap *target, const Rect &region, bool hasAlpha)
+{
+  int textureWidth = tile->width;
+  int textureHeight = tile->height;
+  AdjustSizeToNearestSupportedByCard(&textureWidth, &textureHeight);
+  // Texture may have extra column and row on each side, which mimic edge clamping
+  // when linear filtering is on; if these have to be changed then update whole tile
+  const int tilex = textureWidth > tile->width ? Math::Min(textureWidth - tile->width - 1, 1) : 0;
+  const int tiley = textureHeight > tile->height ? Math::Min(textureHeight - tile->height - 1, 1) : 0;
+  if (_filter->UseLinearFiltering() &&
+      (region.Left == tile->x || region.Top == tile->y ||
+       region.Right == tile->x + tile->width - 1 || region.Bottom == tile->y + tile->height - 1))
+  {
+    UpdateTextureRegion(tile, bitmap, target, hasAlpha);
+    return;
+  }
+
+  const int width = region.GetWidth();
+  const int height = region.GetHeight();
+  const int pitch = width * sizeof(int);
+  char *memPtr = (char*)malloc(pitch * height);
+  TextureTile subTile;
+  subTile.x = region.Left;
+  subTile.y = region.Top;
+  subTile.width = width;
+  subTile.height = height;
+  BitmapToVideoMemOpaque(bitmap, hasAlpha, &subTile, target, memPtr, pitch);
+
+  glBindTexture(GL_TEXTURE_2D, tile->texture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, tilex + region.Left - tile->x, tiley + region.Top - tile->y,
+      width, height, GL_RGBA, GL_UNSIGNED_BYTE, memPtr);
+
+  free(memPtr);
+}
+
+void OGLGraphicsDriver::UpdateDDBRegionFromBitmap(IDriverDependantBitmap* bitmapToUpdate, Bitmap *bitmap, const Rect &region, bool hasAlpha)
+{
+  OGLBitmap *target = (OGLBitmap*)bitmapToUpdate;
+  // Only opaque textures may be updated partially, because for the translucent ones
+  // the pixel conversion depends on the neighbouring pixels
+  if (!target->_opaque || target->_hasAlpha != hasAlpha)
+  {
+    UpdateDDBFromBitmap(bitmapToUpdate, bitmap, hasAlpha);
+    return;
+  }
+  if (target->_width != bitmap->GetWidth() || target->_height != bitmap->GetHeight())
+    throw Ali3DException("UpdateDDBRegionFromBitmap: mismatched bitmap size");
+  const int color_depth = bitmap->GetColorDepth();
+  if (color_depth != target->_colDepth)
+    throw Ali3DException("UpdateDDBRegionFromBitmap: mismatched colour depths");
+
+  const Rect rc = IntersectRects(region, RectWH(0, 0, target->_width, target->_height));
+  if (rc.IsEmpty())
+    return;
+
+  if (color_depth == 8)
+      select_palette(palette);
+
+  for (int i = 0; i < target->_numTiles; i++)
+  {
+    OGLTextureTile *tile = &target->_tiles[i];
+    const Rect tile_rc = IntersectRects(rc, RectWH(tile->x, tile->y, tile->width, tile->height));
+    if (!tile_rc.IsEmpty())
+      UpdateTextureSubRegion(tile, bitmap, target, tile_rc, hasAlpha);
+  }
+
+  if (color_depth == 8)
+      unselect_palette();
+}
+
 int OGLGraphicsDriver::GetCompatibleBitmapFormat(int color_depth)
 {
   if (color_depth == 8)
@@ -187,6 +187,7 @@ public:
     int  GetCompatibleBitmapFormat(int color_depth) override;
     IDriverDependantBitmap* CreateDDBFromBitmap(Bitmap *bitmap, bool hasAlpha, bool opaque) override;
     void UpdateDDBFromBitmap(IDriverDependantBitmap* bitmapToUpdate, Bitmap *bitmap, bool hasAlpha) override;
+    void UpdateDDBRegionFromBitmap(IDriverDependantBitmap* bitmapToUpdate, Bitmap *bitmap, const Rect &region, bool hasAlpha) override;
     void DestroyDDB(IDriverDependantBitmap* bitmap) override;
     void DrawSprite(int x, int y, IDriverDependantBitmap* bitmap) override;
     void RenderToBackBuffer() override;
@@ -317,6 +318,8 @@ private:
     void ReleaseDisplayMode();
     void AdjustSizeToNearestSupportedByCard(int *width, int *height);
     void UpdateTextureRegion(OGLTextureTile *tile, Bitmap *bitmap, OGLBitmap *target, bool hasAlpha);
+    // Updates a part of the tile's texture; region is in bitmap coordinates and must lie inside the tile
+    void UpdateTextureSubRegion(OGLTextureTile *tile, Bitmap *bitmap, OGLBitmap *target, const Rect &region, bool hasAlpha);
     void CreateVirtualScreen();
     void do_fade(bool fadingOut, int speed, int targetColourRed, int targetColourGreen, int targetColourBlue);
     void _renderSprite(const OGLDrawListEntry *entry, const GLMATRIX &matGlobal);
@@ -86,6 +86,12 @@ ALSoftwareGraphicsDriver::ALSoftwareGraphicsDriver()
   _origVirtualScreen = nullptr;
   virtualScreen = nullptr;
   _stageVirtualScreen = nullptr;
+  _threadedPresent = false;
+  _presentPending = false;
+  _presentExit = false;
+  _presentVsync = false;
+  _presentX = 0;
+  _presentY = 0;
 
   // Initialize default sprite batch, it will be used when no other batch was activated
   ALSoftwareGraphicsDriver::InitSpriteBatch(0, _spriteBatchDesc[0]);
@@ -180,6 +186,7 @@ int ALSoftwareGraphicsDriver::GetAllegroGfxDriverID(bool windowed)
 
 void ALSoftwareGraphicsDriver::SetGraphicsFilter(PALSWFilter filter)
 {
+  WaitForPresent();
   _filter = filter;
   OnSetFilter();
 
@@ -194,6 +201,7 @@ void ALSoftwareGraphicsDriver::SetTintMethod(TintMethod method)
 
 bool ALSoftwareGraphicsDriver::SetDisplayMode(const DisplayMode &mode, volatile int *loopTimer)
 {
+  WaitForPresent();
   ReleaseDisplayMode();
 
   const int driver = GetAllegroGfxDriverID(mode.Windowed);
@@ -239,6 +247,7 @@ void ALSoftwareGraphicsDriver::CreateVirtualScreen()
 {
   if (!IsModeSet() || !IsRenderFrameValid() || !IsNativeSizeValid() || !_filter)
     return;
+  WaitForPresent();
   DestroyVirtualScreen();
   // Adjust clipping so nothing gets drawn outside the game frame
   _allegroScreenWrapper->SetClip(_dstRect);
@@ -259,6 +268,8 @@ void ALSoftwareGraphicsDriver::CreateVirtualScreen()
 
 void ALSoftwareGraphicsDriver::DestroyVirtualScreen()
 {
+  WaitForPresent();
+  _presentBuffer.reset();
   if (_filter && _origVirtualScreen)
   {
     screen = (BITMAP*)_filter->ShutdownAndReturnRealScreen()->GetAllegroBitmap();
@@ -307,6 +318,7 @@ bool ALSoftwareGraphicsDriver::SetRenderFrame(const Rect &dst_rect)
 void ALSoftwareGraphicsDriver::ClearRectangle(int x1, int y1, int x2, int y2, RGB *colorToUse)
 {
   if (!_filter) return;
+  WaitForPresent();
   int color = 0;
   if (colorToUse != nullptr) 
     color = makecol_depth(_mode.ColorDepth, colorToUse->r, colorToUse->g, colorToUse->b);
@@ -321,6 +333,7 @@ ALSoftwareGraphicsDriver::~ALSoftwareGraphicsDriver()
 
 void ALSoftwareGraphicsDriver::UnInit()
 {
+  StopPresentThread();
   OnUnInit();
   ReleaseDisplayMode();
 
@@ -566,6 +579,12 @@ void ALSoftwareGraphicsDriver::Render(int xoff, int yoff, GlobalFlipType flip)
 {
   RenderToBackBuffer();
 
+  if (_threadedPresent)
+  {
+    QueuePresent(xoff, yoff, flip);
+    return;
+  }
+
   if (_autoVsync)
     this->Vsync();
 
@@ -585,6 +604,103 @@ void ALSoftwareGraphicsDriver::Vsync()
   vsync();
 }
 
+bool ALSoftwareGraphicsDriver::EnableThreadedPresent(bool enabled)
+{
+  if (_threadedPresent == enabled)
+    return true;
+  if (enabled)
+  {
+    _presentExit = false;
+    _presentThread = std::thread(&ALSoftwareGraphicsDriver::PresentThreadLoop, this);
+  }
+  else
+  {
+    StopPresentThread();
+  }
+  _threadedPresent = enabled;
+  return true;
+}
+
+void ALSoftwareGraphicsDriver::QueuePresent(int xoff, int yoff, GlobalFlipType flip)
+{
+  // Previous frame must be fully displayed before we may reuse the buffer
+  WaitForPresent();
+  if (!_presentBuffer || _presentBuffer->GetSize() != virtualScreen->GetSize() ||
+      _presentBuffer->GetColorDepth() != virtualScreen->GetColorDepth())
+  {
+    _presentBuffer.reset(new Bitmap(virtualScreen->GetWidth(), virtualScreen->GetHeight(), virtualScreen->GetColorDepth()));
+  }
+  // Flip is applied here rather than by the filter, because filter would use
+  // the game's virtual screen as an intermediate buffer
+  switch (flip)
+  {
+  case kFlip_Horizontal:
+    _presentBuffer->FlipBlt(virtualScreen, 0, 0, Common::kBitmap_HFlip);
+    break;
+  case kFlip_Vertical:
+    _presentBuffer->FlipBlt(virtualScreen, 0, 0, Common::kBitmap_VFlip);
+    break;
+  case kFlip_Both:
+    _presentBuffer->FlipBlt(virtualScreen, 0, 0, Common::kBitmap_HVFlip);
+    break;
+  default:
+    _presentBuffer->Blit(virtualScreen, 0, 0);
+    break;
+  }
+
+  std::lock_guard<std::mutex> lk(_presentMutex);
+  _presentX = xoff;
+  _presentY = yoff;
+  _presentVsync = _autoVsync;
+  _presentPending = true;
+  _presentCond.notify_all();
+}
+
+void ALSoftwareGraphicsDriver::WaitForPresent()
+{
+  if (!_threadedPresent)
+    return;
+  std::unique_lock<std::mutex> lk(_presentMutex);
+  _presentCond.wait(lk, [this]() { return !_presentPending; });
+}
+
+void ALSoftwareGraphicsDriver::StopPresentThread()
+{
+  if (!_presentThread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lk(_presentMutex);
+    _presentExit = true;
+    _presentCond.notify_all();
+  }
+  _presentThread.join();
+  _threadedPresent = false;
+  _presentPending = false;
+}
+
+void ALSoftwareGraphicsDriver::PresentThreadLoop()
+{
+  std::unique_lock<std::mutex> lk(_presentMutex);
+  for (;;)
+  {
+    _presentCond.wait(lk, [this]() { return _presentPending || _presentExit; });
+    if (_presentPending)
+    {
+      // Frame data is owned by this thread until pending flag is reset,
+      // so the lock may be released for the duration of the blit
+      lk.unlock();
+      if (_presentVsync)
+        this->Vsync();
+      _filter->RenderScreen(_presentBuffer.get(), _presentX, _presentY);
+      lk.lock();
+      _presentPending = false;
+      _presentCond.notify_all();
+    }
+    if (_presentExit)
+      break;
+  }
+}
+
 Bitmap *ALSoftwareGraphicsDriver::GetMemoryBackBuffer()
 {
   return virtualScreen;
@@ -618,6 +734,7 @@ Bitmap *ALSoftwareGraphicsDriver::GetStageBackBuffer()
 bool ALSoftwareGraphicsDriver::GetCopyOfScreenIntoBitmap(Bitmap *destination, bool at_native_res, GraphicResolution *want_fmt)
 {
   (void)at_native_res; // software driver always renders at native resolution at the moment
+  WaitForPresent();
   // software filter is taught to copy to any size
   if (destination->GetColorDepth() != _mode.ColorDepth)
   {
@@ -749,6 +866,7 @@ void ALSoftwareGraphicsDriver::__fade_out_range(int speed, int from, int to, int
 }
 
 void ALSoftwareGraphicsDriver::FadeOut(int speed, int targetColourRed, int targetColourGreen, int targetColourBlue) {
+  WaitForPresent();
   if (_mode.ColorDepth > 8) 
   {
     highcolor_fade_out(virtualScreen, _drawPostScreenCallback, 0, 0, speed * 4, targetColourRed, targetColourGreen, targetColourBlue);
@@ -760,6 +878,7 @@ void ALSoftwareGraphicsDriver::FadeOut(int speed, int targetColourRed, int targe
 }
 
 void ALSoftwareGraphicsDriver::FadeIn(int speed, PALETTE p, int targetColourRed, int targetColourGreen, int targetColourBlue) {
+  WaitForPresent();
   if (_drawScreenCallback)
   {
     _drawScreenCallback();
@@ -778,6 +897,7 @@ void ALSoftwareGraphicsDriver::FadeIn(int speed, PALETTE p, int targetColourRed,
 
 void ALSoftwareGraphicsDriver::BoxOutEffect(bool blackingOut, int speed, int delay)
 {
+  WaitForPresent();
   if (blackingOut)
   {
     int yspeed = _srcRect.GetHeight() / (_srcRect.GetWidth() / speed);
@@ -821,6 +941,7 @@ void ALSoftwareGraphicsDriver::BoxOutEffect(bool blackingOut, int speed, int del
 
 bool ALSoftwareGraphicsDriver::PlayVideo(const char *filename, bool useAVISound, VideoSkipType skipType, bool stretchToFullScreen)
 {
+  WaitForPresent();
 #if AGS_PLATFORM_OS_WINDOWS
   int result = dxmedia_play_video(filename, useAVISound, skipType, stretchToFullScreen ? 1 : 0);
   return (result == 0);
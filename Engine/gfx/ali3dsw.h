@@ -19,7 +19,10 @@
 #ifndef __AGS_EE_GFX__ALI3DSW_H
 #define __AGS_EE_GFX__ALI3DSW_H
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include "core/platform.h"
 #define AGS_DDRAW_GAMMA_CONTROL (AGS_PLATFORM_OS_WINDOWS)
@@ -180,6 +183,7 @@ public:
     void SetGamma(int newGamma) override;
     void UseSmoothScaling(bool enabled) override { }
     void EnableVsyncBeforeRender(bool enabled) override { _autoVsync = enabled; }
+    bool EnableThreadedPresent(bool enabled) override;
     void Vsync() override;
     void RenderSpritesAtScreenResolution(bool enabled, int supersampling) override { }
     bool RequiresFullRedrawEachFrame() override { return false; }
@@ -216,6 +220,19 @@ private:
     ALSpriteBatches _spriteBatches;
     GFX_MODE_LIST *_gfxModeList;
 
+    // Threaded presentation: the finished virtual screen is copied into the
+    // present buffer, and the dedicated thread scales it onto the real screen
+    // while the game thread proceeds with the next update.
+    bool _threadedPresent;
+    std::thread _presentThread;
+    std::mutex _presentMutex;
+    std::condition_variable _presentCond;
+    std::unique_ptr<Bitmap> _presentBuffer;
+    bool _presentPending;
+    bool _presentExit;
+    bool _presentVsync;
+    int  _presentX, _presentY;
+
 #if AGS_DDRAW_GAMMA_CONTROL
     IDirectDrawGammaControl* dxGammaControl;
     // The gamma ramp is a lookup table for each possible R, G and B value
@@ -236,6 +253,13 @@ private:
     void ReleaseDisplayMode();
     // Renders single sprite batch on the precreated surface
     void RenderSpriteBatch(const ALSpriteBatch &batch, Common::Bitmap *surface, int surf_offx, int surf_offy);
+    // Copies current virtual screen into the present buffer and schedules it for display
+    void QueuePresent(int xoff, int yoff, GlobalFlipType flip);
+    // Blocks until the previously queued frame is displayed;
+    // must be called before anything else touches the real screen
+    void WaitForPresent();
+    void StopPresentThread();
+    void PresentThreadLoop();
 
     void highcolor_fade_in(Bitmap *vs, void(*draw_callback)(), int offx, int offy, int speed, int targetColourRed, int targetColourGreen, int targetColourBlue);
     void highcolor_fade_out(Bitmap *vs, void(*draw_callback)(), int offx, int offy, int speed, int targetColourRed, int targetColourGreen, int targetColourBlue);
@@ -120,6 +120,11 @@ public:
   virtual int  GetCompatibleBitmapFormat(int color_depth) = 0;
   virtual IDriverDependantBitmap* CreateDDBFromBitmap(Common::Bitmap *bitmap, bool hasAlpha, bool opaque = false) = 0;
   virtual void UpdateDDBFromBitmap(IDriverDependantBitmap* bitmapToUpdate, Common::Bitmap *bitmap, bool hasAlpha) = 0;
+  // Updates only the given region of the DDB from the bitmap; this is meant for the cases when
+  // small part of a large image was changed. Renderers which cannot update textures partially
+  // reupload whole bitmap.
+  virtual void UpdateDDBRegionFromBitmap(IDriverDependantBitmap* bitmapToUpdate, Common::Bitmap *bitmap, const Rect &region, bool hasAlpha)
+  { UpdateDDBFromBitmap(bitmapToUpdate, bitmap, hasAlpha); }
   virtual void DestroyDDB(IDriverDependantBitmap* bitmap) = 0;
 
   // Prepares next sprite batch, a list of sprites with defined viewport and optional
@@ -147,6 +152,10 @@ public:
   // fail and optionally write wanted destination format into 'want_fmt' pointer.
   virtual bool GetCopyOfScreenIntoBitmap(Common::Bitmap *destination, bool at_native_res, GraphicResolution *want_fmt = nullptr) = 0;
   virtual void EnableVsyncBeforeRender(bool enabled) = 0;
+  // Enables or disables displaying finished frames on a separate thread, which lets
+  // the game update the next frame while previous one is being presented.
+  // Returns whether the mode is supported by this renderer.
+  virtual bool EnableThreadedPresent(bool enabled) { return false; }
   virtual void Vsync() = 0;
   // Enables or disables rendering mode that draws sprite list directly into
   // the final resolution, as opposed to drawing to native-resolution buffer
@@ -32,6 +32,7 @@
 #include "platform/base/agsplatformdriver.h"
 #include "util/directory.h"
 #include "util/ini_util.h"
+#include "util/math.h"
 #include "util/textstreamreader.h"
 #include "util/path.h"
 #include "util/string_utils.h"
@@ -501,6 +502,9 @@ void apply_config(const ConfigTree &cfg)
         }
 
         psp_audio_multithreaded = INIreadint(cfg, "sound", "threaded", psp_audio_multithreaded);
+        int sound_cache_size_kb = INIreadint(cfg, "sound", "cachemax");
+        if (sound_cache_size_kb > 0)
+            set_sound_cache_max_size((size_t)sound_cache_size_kb * 1024);
 
         // Legacy graphics settings has to be translated into new options;
         // they must be read first, to let newer options override them, if ones are present
@@ -538,14 +542,21 @@ void apply_config(const ConfigTree &cfg)
         usetup.Screen.DisplayMode.VSync = INIreadint(cfg, "graphics", "vsync") > 0;
         usetup.RenderAtScreenRes = INIreadint(cfg, "graphics", "render_at_screenres") > 0;
         usetup.Supersampling = INIreadint(cfg, "graphics", "supersampling", 1);
+        usetup.RenderThreaded = INIreadint(cfg, "graphics", "render_thread") > 0;
 
         usetup.enable_antialiasing = INIreadint(cfg, "misc", "antialias") > 0;
+        usetup.PathfinderThreads = Math::Clamp(INIreadint(cfg, "misc", "pathfinder_threads"), 0, 16);
+        usetup.FileReadAhead = INIreadint(cfg, "misc", "file_readahead") > 0;
+        usetup.RoomPreloadCount = Math::Clamp(INIreadint(cfg, "misc", "room_preload"), 0, 8);
+        usetup.RoomPreloadMemKb = Math::Max(0, INIreadint(cfg, "misc", "room_preload_mem", usetup.RoomPreloadMemKb));
 
         // This option is backwards (usevox is 0 if no_speech_pack)
         usetup.no_speech_pack = INIreadint(cfg, "sound", "usespeech", 1) == 0;
 
         usetup.user_data_dir = INIreadstring(cfg, "misc", "user_data_dir");
         usetup.shared_data_dir = INIreadstring(cfg, "misc", "shared_data_dir");
+        usetup.DecodedCacheDir = INIreadstring(cfg, "misc", "decoded_cache_dir");
+        usetup.DecodedCacheMaxKb = Math::Max(0, INIreadint(cfg, "misc", "decoded_cache_max", usetup.DecodedCacheMaxKb));
 
         usetup.translation = INIreadstring(cfg, "language", "translation");
 
@@ -40,7 +40,9 @@
 #include "ac/objectcache.h"
 #include "ac/path_helper.h"
 #include "ac/sys_events.h"
+#include "ac/roompreload.h"
 #include "ac/roomstatus.h"
+#include "ac/route_finder.h"
 #include "ac/speech.h"
 #include "ac/spritecache.h"
 #include "ac/translation.h"
@@ -66,6 +68,7 @@
 #include "main/main_allegro.h"
 #include "media/audio/audio_system.h"
 #include "platform/util/pe.h"
+#include "util/decodedcache.h"
 #include "util/directory.h"
 #include "util/error.h"
 #include "util/misc.h"
@@ -623,6 +626,8 @@ void engine_init_rand()
 void engine_init_pathfinder()
 {
     init_pathfinder(loaded_game_file_version);
+    start_route_requests(usetup.PathfinderThreads);
+    start_room_preload(usetup.RoomPreloadCount, (size_t)usetup.RoomPreloadMemKb * 1024);
 }
 
 void engine_pre_init_gfx()
@@ -687,6 +692,15 @@ void engine_init_directories()
     if (!usetup.shared_data_dir.IsEmpty())
         Debug::Printf(kDbgMsg_Init, "Shared data directory: %s", usetup.shared_data_dir.GetCStr());
 
+    File::SetReadAhead(usetup.FileReadAhead);
+    if (!usetup.DecodedCacheDir.IsEmpty())
+    {
+        if (DecodedCache::SetDirectory(usetup.DecodedCacheDir, (uint64_t)usetup.DecodedCacheMaxKb * 1024))
+            Debug::Printf(kDbgMsg_Init, "Decoded data cache: %s, up to %d KB", usetup.DecodedCacheDir.GetCStr(), usetup.DecodedCacheMaxKb);
+        else
+            Debug::Printf(kDbgMsg_Warn, "Failed to use the decoded data cache directory '%s'.", usetup.DecodedCacheDir.GetCStr());
+    }
+
     ResPaths.DataDir = usetup.data_files_dir;
     ResPaths.GamePak.Path = usetup.main_data_filepath;
     ResPaths.GamePak.Name = get_filename(usetup.main_data_filepath);
@@ -1133,21 +1147,16 @@ void engine_setup_scsystem_auxiliary()
     }
 }
 
-void engine_update_mp3_thread()
-{
-    update_mp3_thread();
-    platform->Delay(50);
-}
-
 void engine_start_multithreaded_audio()
 {
   // PSP: Initialize the sound cache.
   clear_sound_cache();
 
-  // Create sound update thread. This is a workaround for sound stuttering.
+  // Create the thread which keeps the sound streams filled, so that they
+  // do not stutter while the game thread is busy
   if (psp_audio_multithreaded)
   {
-    if (!audioThread.CreateAndStart(engine_update_mp3_thread, true))
+    if (!start_audio_thread())
     {
       Debug::Printf(kDbgMsg_Init, "Failed to start audio thread, audio will be processed on the main thread");
       psp_audio_multithreaded = 0;
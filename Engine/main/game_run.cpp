@@ -39,9 +39,12 @@
 #include "ac/sys_events.h"
 #include "ac/room.h"
 #include "ac/roomobject.h"
+#include "ac/roompreload.h"
 #include "ac/roomstatus.h"
 #include "debug/debugger.h"
 #include "debug/debug_log.h"
+#include "debug/assettrace.h"
+#include "debug/frametiming.h"
 #include "gui/guiinv.h"
 #include "gui/guimain.h"
 #include "gui/guitextbox.h"
@@ -132,6 +135,7 @@ static void game_loop_check_problems_at_start()
 
 static void game_loop_check_new_room()
 {
+    FrameStageTimer timer(kFrameStage_Script);
     if (in_new_room == 0) {
         // Run the room and game script repeatedly_execute
         run_function_on_non_blocking_thread(&repExecAlways);
@@ -145,6 +149,7 @@ static void game_loop_check_new_room()
 
 static void game_loop_do_late_update()
 {
+    FrameStageTimer timer(kFrameStage_Script);
     if (in_new_room == 0)
     {
         // Run the room and game script late_repeatedly_execute
@@ -601,6 +606,7 @@ static void check_room_edges(int numevents_was)
 
 static void game_loop_check_controls(bool checkControls)
 {
+    FrameStageTimer timer(kFrameStage_Input);
     // don't let the player do anything before the screen fades in
     if ((in_new_room == 0) && (checkControls)) {
         int inRoom = displayed_room;
@@ -615,6 +621,7 @@ static void game_loop_check_controls(bool checkControls)
 
 static void game_loop_do_update()
 {
+    FrameStageTimer timer(kFrameStage_Update);
     if (debug_flags & DBG_NOUPDATE) ;
     else if (game_paused==0) update_stuff();
 }
@@ -675,6 +682,7 @@ static void game_loop_do_render_and_check_mouse(IDriverDependantBitmap *extraBit
 
 static void game_loop_update_events()
 {
+    FrameStageTimer timer(kFrameStage_Script);
     new_room_was = in_new_room;
     if (in_new_room>0)
         setevent(EV_FADEIN,0,0,0);
@@ -755,6 +763,9 @@ void UpdateGameOnce(bool checkControls, IDriverDependantBitmap *extraBitmap, int
 
     int res;
 
+    FrameTiming::BeginFrame(loopcounter);
+    AssetTrace::SetLoop(loopcounter);
+
     update_polled_mp3();
 
     numEventsAtStartOfFunction = numevents;
@@ -803,6 +814,8 @@ void UpdateGameOnce(bool checkControls, IDriverDependantBitmap *extraBitmap, int
 
     update_audio_system_on_game_loop();
 
+    update_room_preload();
+
     game_loop_do_render_and_check_mouse(extraBitmap, extraX, extraY);
 
     our_eip=6;
@@ -828,7 +841,9 @@ void UpdateGameOnce(bool checkControls, IDriverDependantBitmap *extraBitmap, int
 
     update_polled_stuff_if_runtime();
 
+    FrameTiming::BeginStage(kFrameStage_Wait);
     WaitForNextFrame();
+    FrameTiming::EndStage(kFrameStage_Wait);
 }
 
 static void UpdateMouseOverLocation()
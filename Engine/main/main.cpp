@@ -95,7 +95,7 @@ int psp_ignore_acsetup_cfg_file = 0;
 int psp_clear_cache_on_room_change = 0;
 
 int psp_midi_preload_patches = 0;
-int psp_audio_cachesize = 10;
+int psp_audio_cachesize = 0; // no limit to the number of cached sounds
 char psp_game_file_name[] = "";
 char psp_translation[] = "default";
 
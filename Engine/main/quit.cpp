@@ -20,6 +20,7 @@
 #include "ac/cdaudio.h"
 #include "ac/gamesetup.h"
 #include "ac/gamesetupstruct.h"
+#include "ac/roompreload.h"
 #include "ac/roomstatus.h"
 #include "ac/translation.h"
 #include "debug/agseditordebugger.h"
@@ -115,6 +116,10 @@ void quit_shutdown_platform(QuitReason qreason)
 void quit_shutdown_audio()
 {
     our_eip = 9917;
+    // Quit the sound thread first, so that the clips are destroyed here,
+    // before the sound system is shut down
+    stop_audio_thread();
+
     game.options[OPT_CROSSFADEMUSIC] = 0;
     stopmusic();
 #ifndef PSP_NO_MOD_PLAYBACK
@@ -122,8 +127,9 @@ void quit_shutdown_audio()
         remove_mod_player();
 #endif
 
-    // Quit the sound thread.
-    audioThread.Stop();
+    SoundCacheStats sc_stats = get_sound_cache_stats();
+    Debug::Printf(kDbgMsg_Init, "Sound cache: %u hits, %u misses, %u removed, %u too big to cache; %u sounds, %u KB",
+        sc_stats.Hits, sc_stats.Misses, sc_stats.Evictions, sc_stats.Uncached, sc_stats.Entries, (unsigned)(sc_stats.MemSize / 1024));
 
     remove_sound();
 }
@@ -284,6 +290,7 @@ void quit(const char *quitmsg)
 
     our_eip = 9908;
 
+    stop_room_preload();
     shutdown_pathfinder();
 
     engine_shutdown_gfxmode();
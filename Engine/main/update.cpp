@@ -214,6 +214,7 @@ void update_shadow_areas()
 void update_character_move_and_anim(int &numSheep, int *followingAsSheep)
 {
 	// move & animate characters
+  begin_character_blockers();
   for (int aa=0;aa<game.numcharacters;aa++) {
     if (game.chars[aa].on != 1) continue;
 
@@ -221,7 +222,9 @@ void update_character_move_and_anim(int &numSheep, int *followingAsSheep)
 	CharacterExtras*chex = &charextra[aa];
 
 	chi->UpdateMoveAndAnim(aa, chex, numSheep, followingAsSheep);
+	update_character_blocker(aa);
   }
+  end_character_blockers();
 }
 
 void update_following_exactly_characters(int &numSheep, int *followingAsSheep)
@@ -477,6 +480,10 @@ void update_stuff() {
   int numSheep = 0;
   int followingAsSheep[MAX_SHEEP];
 
+  // routes requested during the last tick are applied before anyone moves,
+  // so that the walks begin on the same tick however fast the workers are
+  complete_character_walks();
+
   update_character_move_and_anim(numSheep, followingAsSheep);
 
   update_following_exactly_characters(numSheep, followingAsSheep);
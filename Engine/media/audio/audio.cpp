@@ -13,6 +13,12 @@
 //=============================================================================
 
 #include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "core/platform.h"
 #include "util/wgt2allg.h"
@@ -30,6 +36,7 @@
 #include "media/audio/sound.h"
 #include "debug/debug_log.h"
 #include "debug/debugger.h"
+#include "debug/frametiming.h"
 #include "ac/common.h"
 #include "ac/file.h"
 #include "ac/global_audio.h"
@@ -38,6 +45,8 @@
 #include "core/assetmanager.h"
 #include "ac/timer.h"
 #include "main/game_run.h"
+#include "media/audio/audiointernaldefs.h"
+#include "util/spsc_queue.h"
 
 using namespace AGS::Common;
 using namespace AGS::Engine;
@@ -48,6 +57,18 @@ using namespace AGS::Engine;
 static std::array<SOUNDCLIP *,MAX_SOUND_CHANNELS+1> _channels;
 AGS::Engine::Mutex AudioChannelsLock::s_mutex;
 
+// Tells if the clips assigned to channels are played by the audio thread
+static bool audioThreadRunning = false;
+
+// Passes the clip to the audio thread, if it is running
+static void attach_to_audio_thread(SOUNDCLIP *ch)
+{
+    if (!audioThreadRunning || ch->is_played_by_audio_thread()) { return; }
+    ch->publish_state();
+    ch->set_played_by_audio_thread(true);
+    send_audio_command(ch, kSoundClipCmd_Attach);
+}
+
 SOUNDCLIP *AudioChannelsLock::GetChannel(int index)
 {
     return _channels[index];
@@ -67,6 +88,8 @@ SOUNDCLIP *AudioChannelsLock::SetChannel(int index, SOUNDCLIP* ch)
     else if (_channels[index] != nullptr && ch != nullptr)
         Debug::Printf(kDbgMsg_Warn, "WARNING: channel %d - clip overwritten", index);
     _channels[index] = ch;
+    if (ch != nullptr)
+        attach_to_audio_thread(ch);
     return ch;
 }
 
@@ -110,14 +133,37 @@ extern CharacterInfo*playerchar;
 extern volatile int switching_away_from_game;
 
 #if ! AGS_PLATFORM_OS_IOS && ! AGS_PLATFORM_OS_ANDROID
-volatile int psp_audio_multithreaded = 0;
+volatile int psp_audio_multithreaded = 1;
 #endif
 
 ScriptAudioChannel scrAudioChannel[MAX_SOUND_CHANNELS + 1];
 char acaudio_buffer[256];
 int reserved_channel_count = 0;
 
-AGS::Engine::Thread audioThread;
+static AGS::Engine::Thread audioThread;
+// Audio thread sleeps until any clip has to be polled, or until woken up
+static std::mutex audioThreadMutex;
+static std::condition_variable audioThreadCV;
+static bool audioThreadWakeUp = false;
+static bool audioThreadExit = false;
+// Audio thread polls the clips earlier than they need it, leaving the time
+// for decoding; these are the limits of its wait, in ms
+#define AUDIO_THREAD_MIN_WAIT_MS 2
+#define AUDIO_THREAD_MAX_WAIT_MS SOUNDCLIP_MAX_SNAPSHOT_AGE_MS
+
+// Operations on the clips, sent from the game thread to the audio thread
+struct AudioThreadCommand
+{
+    SOUNDCLIP *Clip;
+    SoundClipCommand Cmd;
+    int Value;
+};
+#define AUDIO_THREAD_COMMAND_QUEUE 256
+static SpscQueue<AudioThreadCommand> audioThreadCommands(AUDIO_THREAD_COMMAND_QUEUE);
+// Clips played by the audio thread; only accessed by that thread, except
+// when it is not running
+static std::vector<SOUNDCLIP*> audioThreadClips;
+static thread_local bool isAudioThread = false;
 
 void calculate_reserved_channel_count()
 {
@@ -394,8 +440,6 @@ static void queue_audio_clip_to_play(ScriptAudioClip *clip, int priority, int re
         play.new_music_queue[play.new_music_queue_size].cachedClip = cachedClip;
         play.new_music_queue_size++;
     }
-    
-    update_polled_mp3();
 }
 
 ScriptAudioChannel* play_audio_clip_on_channel(int channel, ScriptAudioClip *clip, int priority, int repeat, int fromOffset, SOUNDCLIP *soundfx)
@@ -529,9 +573,11 @@ void stop_and_destroy_channel_ex(int chid, bool resetLegacyMusicSettings)
     SOUNDCLIP* ch = lock.GetChannel(chid);
 
     if (ch != nullptr) {
-        ch->destroy();
-        delete ch;
         lock.SetChannel(chid, nullptr);
+        if (!ch->defer_command(kSoundClipCmd_Delete)) {
+            ch->destroy();
+            delete ch;
+        }
         ch = nullptr;
     }
 
@@ -726,6 +772,10 @@ void stop_all_sound_and_music()
 
 void shutdown_sound() 
 {
+    // the clips must be destroyed before the sound system is removed, so
+    // they are taken back from the audio thread; restart_sound_thread()
+    // starts it again when the sound is reinstalled
+    stop_audio_thread();
     stop_all_sound_and_music();
 
 #ifndef PSP_NO_MOD_PLAYBACK
@@ -919,27 +969,169 @@ void update_volume_drop_if_voiceover()
 
 extern volatile char want_exit;
 
-void update_mp3_thread()
+bool is_audio_thread()
+{
+    return isAudioThread;
+}
+
+void send_audio_command(SOUNDCLIP *clip, SoundClipCommand cmd, int value)
+{
+    const AudioThreadCommand command = { clip, cmd, value };
+    while (!audioThreadCommands.Push(command))
+    {
+        // the queue is full: let the audio thread catch up
+        wake_audio_thread();
+        std::this_thread::yield();
+    }
+    wake_audio_thread();
+}
+
+// Runs the commands sent to the audio thread; if the thread has stopped,
+// detaches the clips instead of attaching them, and runs the rest of the
+// commands directly
+static void run_audio_commands(bool detach)
+{
+    AudioThreadCommand command;
+    while (audioThreadCommands.Pop(command))
+    {
+        SOUNDCLIP *clip = command.Clip;
+        switch (command.Cmd)
+        {
+        case kSoundClipCmd_Attach:
+            if (detach)
+                clip->set_played_by_audio_thread(false);
+            else
+                audioThreadClips.push_back(clip);
+            break;
+        case kSoundClipCmd_Delete:
+            audioThreadClips.erase(std::remove(audioThreadClips.begin(), audioThreadClips.end(), clip),
+                audioThreadClips.end());
+            clip->destroy();
+            delete clip;
+            break;
+        default:
+            clip->run_command(command.Cmd, command.Value);
+            clip->publish_state();
+            break;
+        }
+    }
+}
+
+// Polls the clips played by the audio thread, and returns how long the
+// earliest one of them may play before it has to be polled again, in ms
+static int poll_audio_thread_clips()
+{
+    if (switching_away_from_game) { return AUDIO_THREAD_MAX_WAIT_MS; }
+
+    int time_to_poll = AUDIO_THREAD_MAX_WAIT_MS;
+    for (auto *ch : audioThreadClips)
+    {
+        ch->poll();
+        ch->publish_state();
+        time_to_poll = std::min(time_to_poll, ch->get_time_to_poll_ms());
+    }
+    return time_to_poll;
+}
+
+// Polls all the clips, and returns how long the earliest one of them may
+// play before it has to be polled again, in ms
+static int poll_audio_clips()
 {
-	if (switching_away_from_game) { return; }
+    if (switching_away_from_game) { return AUDIO_THREAD_MAX_WAIT_MS; }
 
     AudioChannelsLock lock;
 
+    int time_to_poll = AUDIO_THREAD_MAX_WAIT_MS;
     for(int i = 0; i <= MAX_SOUND_CHANNELS; ++i)
     {
         auto* ch = lock.GetChannel(i);
         if (ch)
+        {
             ch->poll();
+            time_to_poll = std::min(time_to_poll, ch->get_time_to_poll_ms());
+        }
+    }
+    return time_to_poll;
+}
+
+static void update_audio_thread()
+{
+    isAudioThread = true;
+    run_audio_commands(false);
+    // wait for a half of the time left, so that the decoding is done before
+    // the buffer runs out even if the thread is woken up late
+    int wait_ms = std::max(poll_audio_thread_clips() / 2, AUDIO_THREAD_MIN_WAIT_MS);
+
+    std::unique_lock<std::mutex> lk(audioThreadMutex);
+    audioThreadCV.wait_for(lk, std::chrono::milliseconds(wait_ms),
+        [] { return audioThreadWakeUp || audioThreadExit || !audioThreadCommands.IsEmpty(); });
+    audioThreadWakeUp = false;
+}
+
+bool start_audio_thread()
+{
+    {
+        std::lock_guard<std::mutex> lk(audioThreadMutex);
+        audioThreadExit = false;
+    }
+    if (!audioThread.CreateAndStart(update_audio_thread, true))
+        return false;
+
+    // the audio thread takes over the clips which are already playing
+    AudioChannelsLock lock;
+    audioThreadRunning = true;
+    for (int i = 0; i <= MAX_SOUND_CHANNELS; ++i)
+    {
+        auto *ch = lock.GetChannel(i);
+        if (ch)
+            attach_to_audio_thread(ch);
+    }
+    return true;
+}
+
+void stop_audio_thread()
+{
+    if (!audioThreadRunning) { return; }
+    {
+        AudioChannelsLock lock;
+        audioThreadRunning = false;
+    }
+    {
+        std::lock_guard<std::mutex> lk(audioThreadMutex);
+        audioThreadExit = true;
+    }
+    audioThreadCV.notify_one();
+    audioThread.Stop();
+
+    // the game thread takes over the clips
+    for (auto *ch : audioThreadClips)
+        ch->set_played_by_audio_thread(false);
+    audioThreadClips.clear();
+    run_audio_commands(true);
+}
+
+void wake_audio_thread()
+{
+    if (!psp_audio_multithreaded) { return; }
+    {
+        std::lock_guard<std::mutex> lk(audioThreadMutex);
+        audioThreadWakeUp = true;
     }
+    audioThreadCV.notify_one();
 }
 
-//this is called at various points to give streaming logic a chance to update
-//it seems those calls have been littered around and points where it ameliorated skipping
-//a better solution would be to forcibly thread the streaming logic
+void restart_sound_thread()
+{
+    if (psp_audio_multithreaded && !start_audio_thread())
+        psp_audio_multithreaded = 0;
+}
+
+// Polls the clips on the game thread, when the audio thread is not used
 void update_polled_mp3()
 {
 	if (psp_audio_multithreaded) { return; }
-    update_mp3_thread();
+    FrameStageTimer timer(kFrameStage_Audio);
+    poll_audio_clips();
 }
 
 // Update the music, and advance the crossfade on a step
@@ -1205,18 +1397,18 @@ static void play_new_music(int mnum, SOUNDCLIP *music)
     else
         new_clip = load_music_from_disk(mnum, (play.music_repeat > 0));
 
+    // the clip is started before it is assigned to the channel, as the
+    // audio thread takes the clips over from there
+    if (new_clip != nullptr && !new_clip->play()) {
+        // previous behavior was to set channel[] to null on error, so continue to do that here.
+        new_clip->destroy();
+        delete new_clip;
+        new_clip = nullptr;
+    }
     AudioChannelsLock lock;
     auto* ch = lock.SetChannel(useChannel, new_clip);
-    if (ch != nullptr) {
-        if (!ch->play()) {
-            // previous behavior was to set channel[] to null on error, so continue to do that here.
-            ch->destroy();
-            delete ch;
-            ch = nullptr;
-            lock.SetChannel(useChannel, nullptr);
-        } else
-            current_music_type = ch->get_sound_type();
-    }
+    if (ch != nullptr)
+        current_music_type = ch->get_sound_type();
 
     post_new_music_check(useChannel);
     update_music_volume();
@@ -20,6 +20,7 @@
 #include "ac/dynobj/scriptaudioclip.h"
 #include "ac/dynobj/scriptaudiochannel.h"
 #include "media/audio/ambientsound.h"
+#include "media/audio/soundclip.h"
 #include "util/mutex.h"
 #include "util/mutex_lock.h"
 #include "util/thread.h"
@@ -129,12 +130,24 @@ ScriptAudioClip *get_audio_clip_for_music(int mnum);
 SOUNDCLIP * load_music_from_disk(int mnum, bool doRepeat);
 void        newmusic(int mnum);
 
-extern AGS::Engine::Thread audioThread;
 extern volatile bool _audio_doing_crossfade;
 extern volatile int psp_audio_multithreaded;
 
+// Starts the thread which polls the clips whenever their buffers need to be
+// refilled; returns false if the thread could not be created
+bool start_audio_thread();
+void stop_audio_thread();
+// Starts the audio thread again after shutdown_sound(), if it is used
+void restart_sound_thread();
+// Makes the audio thread poll the clips now
+void wake_audio_thread();
+// Tells if this is called on the audio thread
+bool is_audio_thread();
+// Sends the command to the audio thread; the commands are run in the order
+// they were sent in. Must be called on the game thread.
+void send_audio_command(SOUNDCLIP *clip, SoundClipCommand cmd, int value = 0);
+// Polls the clips on the game thread, if the audio thread is not running
 void update_polled_mp3();
-void update_mp3_thread();
 
 extern void cancel_scheduled_music_update();
 extern void schedule_music_update_at(AGS_Clock::time_point);
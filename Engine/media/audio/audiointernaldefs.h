@@ -17,5 +17,9 @@
 
 //#define MP3CHUNKSIZE 100000
 #define MP3CHUNKSIZE 32768
+// How often the clips which do not tell when they need it are polled, in ms
+#define SOUNDCLIP_DEFAULT_POLL_MS 50
+// The longest time the audio thread waits before publishing the clips' state again
+#define SOUNDCLIP_MAX_SNAPSHOT_AGE_MS 500
 
 #endif // __AC_SOUNDINTERNALDEFS_H
\ No newline at end of file
@@ -43,6 +43,7 @@ void MYMOD::poll()
 void MYMOD::adjust_volume()
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_AdjustVolume)) { return; }
     al_duh_set_volume(duhPlayer, VOLUME_TO_DUMB_VOL(get_final_volume()));
 }
 
@@ -70,14 +71,17 @@ void MYMOD::destroy()
 void MYMOD::seek(int patnum)
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_Seek, patnum)) { return; }
 
+    // the clip stays in the playing state while restarted, as other threads
+    // may check it
     al_stop_duh(duhPlayer);
-    state_ = SoundClipInitial;
 
     DUH_SIGRENDERER *sr = dumb_it_start_at_order(tune, 2, patnum);
     duhPlayer = al_duh_encapsulate_sigrenderer(sr, VOLUME_TO_DUMB_VOL(vol), 8192, 22050);
     if (!duhPlayer) {
         duh_end_sigrenderer(sr);
+        state_ = SoundClipStopped;
         return;
     }
 
@@ -85,7 +89,7 @@ void MYMOD::seek(int patnum)
     state_ = SoundClipPlaying;
 }
 
-int MYMOD::get_pos()
+int MYMOD::get_pos_impl()
 {
     if (!is_playing()) { return -1; }
 
@@ -104,13 +108,13 @@ int MYMOD::get_real_mod_pos()
     return al_duh_get_position(duhPlayer);
 }
 
-int MYMOD::get_pos_ms()
+int MYMOD::get_pos_ms_impl()
 {
     if (!is_playing()) { return -1; }
     return (get_real_mod_pos() * 10) / 655;
 }
 
-int MYMOD::get_length_ms()
+int MYMOD::get_length_ms_impl()
 {
     if (tune == nullptr)
         return 0;
@@ -126,12 +130,14 @@ int MYMOD::get_voice()
 }
 
 void MYMOD::pause() {
+    if (defer_command(kSoundClipCmd_Pause)) { return; }
     if (state_ != SoundClipPlaying) { return; }
     al_pause_duh(duhPlayer);
     state_ = SoundClipPaused;
 }
 
 void MYMOD::resume() {
+    if (defer_command(kSoundClipCmd_Resume)) { return; }
     if (state_ != SoundClipPaused) { return; }
     al_resume_duh(duhPlayer);
     state_ = SoundClipPlaying;
@@ -43,12 +43,6 @@ struct MYMOD : public SOUNDCLIP
     // deprecated "GetMODPattern" script function.
     // (see Game_GetMODPattern(), and documentation for AudioChannel.Position property)
     // TODO: find a way to redesign this behavior
-    int get_pos() override;
-
-    int get_pos_ms() override;
-
-    int get_length_ms() override;
-
     void pause() override;
 
     void resume() override;
@@ -60,6 +54,9 @@ struct MYMOD : public SOUNDCLIP
     MYMOD();
 
 protected:
+    int get_pos_impl() override;
+    int get_pos_ms_impl() override;
+    int get_length_ms_impl() override;
     int get_voice() override;
     void adjust_volume() override;
     // Returns real MOD/XM playing position
@@ -50,19 +50,19 @@ void MYMOD::seek(int patnum)
         goto_mod_track(patnum);
 }
 
-int MYMOD::get_pos()
+int MYMOD::get_pos_impl()
 {
     if (!is_mod_playing())
         return -1;
     return mi.trk;
 }
 
-int MYMOD::get_pos_ms()
+int MYMOD::get_pos_ms_impl()
 {
     return 0;                   // we don't know ms offset
 }
 
-int MYMOD::get_length_ms()
+int MYMOD::get_length_ms_impl()
 {  // we don't know ms
     return 0;
 }
@@ -31,11 +31,11 @@ struct MYMOD:public SOUNDCLIP
 
     void seek(int patnum);
 
-    int get_pos();
+    int get_pos_impl();
 
-    int get_pos_ms();
+    int get_pos_ms_impl();
 
-    int get_length_ms();
+    int get_length_ms_impl();
 
     int get_voice();
 
@@ -28,6 +28,7 @@ void MYMIDI::poll()
 void MYMIDI::adjust_volume()
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_AdjustVolume)) { return; }
     ::set_volume(-1, get_final_volume());
 }
 
@@ -52,21 +53,22 @@ void MYMIDI::destroy()
 void MYMIDI::seek(int pos)
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_Seek, pos)) { return; }
     midi_seek(pos);
 }
 
-int MYMIDI::get_pos()
+int MYMIDI::get_pos_impl()
 {
     if (!is_playing()) { return -1; }
     return midi_pos;
 }
 
-int MYMIDI::get_pos_ms()
+int MYMIDI::get_pos_ms_impl()
 {
     return 0;                   // we don't know ms with midi
 }
 
-int MYMIDI::get_length_ms()
+int MYMIDI::get_length_ms_impl()
 {
     return lengthInSeconds * 1000;
 }
@@ -78,12 +80,14 @@ int MYMIDI::get_voice()
 }
 
 void MYMIDI::pause() {
+    if (defer_command(kSoundClipCmd_Pause)) { return; }
     if (state_ != SoundClipPlaying) { return; }
     midi_pause();
     state_ = SoundClipPaused;
 }
 
 void MYMIDI::resume() {
+    if (defer_command(kSoundClipCmd_Resume)) { return; }
     if (state_ != SoundClipPaused) { return; }
     midi_resume();
     state_ = SoundClipPlaying;
@@ -31,12 +31,6 @@ struct MYMIDI:public SOUNDCLIP
 
     void seek(int pos) override;
 
-    int get_pos() override;
-
-    int get_pos_ms() override;
-
-    int get_length_ms() override;
-
     void pause() override;
 
     void resume() override;
@@ -48,6 +42,9 @@ struct MYMIDI:public SOUNDCLIP
     MYMIDI();
 
 protected:
+    int get_pos_impl() override;
+    int get_pos_ms_impl() override;
+    int get_length_ms_impl() override;
     int get_voice() override;
     void adjust_volume() override;
 };
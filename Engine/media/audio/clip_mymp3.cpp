@@ -60,6 +60,7 @@ void MYMP3::poll()
 void MYMP3::adjust_stream()
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_AdjustVolume)) { return; }
     AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
     almp3_adjust_mp3stream(stream, get_final_volume(), panning, speed);
 }
@@ -110,20 +111,20 @@ void MYMP3::seek(int pos)
     quit("Tried to seek an mp3stream");
 }
 
-int MYMP3::get_pos()
+int MYMP3::get_pos_impl()
 {
     return 0; // Return 0 to signify that Seek is not supported
     // return almp3_get_pos_msecs_mp3stream (stream);
 }
 
-int MYMP3::get_pos_ms()
+int MYMP3::get_pos_ms_impl()
 {
     if (!is_playing()) { return -1; }
 	AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
     return almp3_get_pos_msecs_mp3stream(stream);
 }
 
-int MYMP3::get_length_ms()
+int MYMP3::get_length_ms_impl()
 {
     if (!is_playing()) { return -1; }
 	AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
@@ -138,6 +139,13 @@ int MYMP3::get_voice()
     return (ast != nullptr ? ast->voice : -1);
 }
 
+int MYMP3::get_time_to_poll_ms()
+{
+    if (state_ != SoundClipPlaying) { return SOUNDCLIP_DEFAULT_POLL_MS; }
+    AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
+    return get_stream_time_to_poll_ms(almp3_get_audiostream_mp3stream(stream));
+}
+
 int MYMP3::get_sound_type() {
     return MUS_MP3;
 }
@@ -147,7 +155,7 @@ int MYMP3::play() {
 
     {
 	    AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
-        if (almp3_play_mp3stream(stream, chunksize, (vol > 230) ? vol : vol + 20, panning) != ALMP3_OK) {
+        if (almp3_play_mp3stream(stream, chunksize, (vol > 230) ? vol.load() : vol + 20, panning) != ALMP3_OK) {
             return 0;
         }
     }
@@ -50,7 +50,7 @@ void MYOGG::poll()
 
     int ret = alogg_poll_oggstream(stream);
     if (ret == ALOGG_OK || ret == ALOGG_POLL_BUFFERUNDERRUN)
-        get_pos_ms();  // call this to keep the last_but_one stuff up to date
+        get_pos_ms_impl();  // call this to keep the last_but_one stuff up to date
     else {
         // finished playing or error
         state_ = SoundClipStopped;
@@ -60,6 +60,7 @@ void MYOGG::poll()
 void MYOGG::adjust_stream()
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_AdjustVolume)) { return; }
     alogg_adjust_oggstream(stream, get_final_volume(), panning, speed);
 }
 
@@ -107,12 +108,12 @@ void MYOGG::seek(int pos)
     quit("Attempted to seek an oggstream; operation not permitted");
 }
 
-int MYOGG::get_pos()
+int MYOGG::get_pos_impl()
 {
     return 0;
 }
 
-int MYOGG::get_pos_ms()
+int MYOGG::get_pos_ms_impl()
 {
     // Unfortunately the alogg_get_pos_msecs_oggstream function
     // returns the ms offset that was last decoded, so it's always
@@ -156,7 +157,7 @@ case 1:
     return offs + last_but_one_but_one;
 }
 
-int MYOGG::get_length_ms()
+int MYOGG::get_length_ms_impl()
 {  // streamed OGG is variable bitrate so we don't know
     return 0;
 }
@@ -171,6 +172,12 @@ int MYOGG::get_voice()
     return -1;
 }
 
+int MYOGG::get_time_to_poll_ms()
+{
+    if (state_ != SoundClipPlaying) { return SOUNDCLIP_DEFAULT_POLL_MS; }
+    return get_stream_time_to_poll_ms(alogg_get_audiostream_oggstream(stream));
+}
+
 int MYOGG::get_sound_type() {
     return MUS_OGG;
 }
@@ -178,7 +185,7 @@ int MYOGG::get_sound_type() {
 int MYOGG::play() {
     if (in == nullptr) { return 0; }
     
-    if (alogg_play_oggstream(stream, MP3CHUNKSIZE, (vol > 230) ? vol : vol + 20, panning) != ALOGG_OK) {
+    if (alogg_play_oggstream(stream, MP3CHUNKSIZE, (vol > 230) ? vol.load() : vol + 20, panning) != ALOGG_OK) {
         return 0;
     }
 
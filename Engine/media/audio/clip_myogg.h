@@ -31,6 +31,8 @@ struct MYOGG:public SOUNDCLIP
 
     void poll() override;
 
+    int get_time_to_poll_ms() override;
+
     void set_volume(int newvol) override;
     void set_speed(int new_speed) override;
 
@@ -38,12 +40,6 @@ struct MYOGG:public SOUNDCLIP
 
     void seek(int pos) override;
 
-    int get_pos() override;    
-
-    int get_pos_ms() override;
-
-    int get_length_ms() override;
-
     int get_sound_type() override;
 
     int play() override;
@@ -51,6 +47,9 @@ struct MYOGG:public SOUNDCLIP
     MYOGG();
 
 protected:
+    int get_pos_impl() override;
+    int get_pos_ms_impl() override;
+    int get_length_ms_impl() override;
     int get_voice() override;
     void adjust_volume() override;
 private:
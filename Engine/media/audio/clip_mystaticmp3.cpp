@@ -52,6 +52,7 @@ void MYSTATICMP3::poll()
 void MYSTATICMP3::adjust_stream()
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_AdjustVolume)) { return; }
     AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
     almp3_adjust_mp3(tune, get_final_volume(), panning, speed, repeat);
 }
@@ -93,24 +94,25 @@ void MYSTATICMP3::destroy()
 void MYSTATICMP3::seek(int pos)
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_Seek, pos)) { return; }
     AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
     almp3_seek_abs_msecs_mp3(tune, pos);
 }
 
-int MYSTATICMP3::get_pos()
+int MYSTATICMP3::get_pos_impl()
 {
     if (!is_playing()) { return -1; }
     AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
     return almp3_get_pos_msecs_mp3(tune);
 }
 
-int MYSTATICMP3::get_pos_ms()
+int MYSTATICMP3::get_pos_ms_impl()
 {
-    int result = get_pos();
+    int result = get_pos_impl();
     return result;
 }
 
-int MYSTATICMP3::get_length_ms()
+int MYSTATICMP3::get_length_ms_impl()
 {
     if (tune == nullptr) { return -1; }
     AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
@@ -125,6 +127,13 @@ int MYSTATICMP3::get_voice()
 	return (ast != nullptr ? ast->voice : -1);
 }
 
+int MYSTATICMP3::get_time_to_poll_ms()
+{
+    if (state_ != SoundClipPlaying) { return SOUNDCLIP_DEFAULT_POLL_MS; }
+    AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
+    return get_stream_time_to_poll_ms(almp3_get_audiostream_mp3(tune));
+}
+
 int MYSTATICMP3::get_sound_type() {
     return MUS_MP3;
 }
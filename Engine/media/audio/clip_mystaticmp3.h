@@ -28,6 +28,8 @@ struct MYSTATICMP3:public SOUNDCLIP
 
     void poll() override;
 
+    int get_time_to_poll_ms() override;
+
     void set_volume(int newvol) override;
     void set_speed(int new_speed) override;
 
@@ -35,12 +37,6 @@ struct MYSTATICMP3:public SOUNDCLIP
 
     void seek(int pos) override;
 
-    int get_pos() override;
-
-    int get_pos_ms() override;
-
-    int get_length_ms() override;
-
     int get_sound_type() override;
 
     int play() override;
@@ -48,6 +44,10 @@ struct MYSTATICMP3:public SOUNDCLIP
     MYSTATICMP3();
 
 protected:
+    int get_pos_impl() override;
+    int get_pos_ms_impl() override;
+    int get_length_ms_impl() override;
+    bool is_pos_in_ms() const override { return true; }
     int get_voice() override;
     void adjust_volume() override;
 private:
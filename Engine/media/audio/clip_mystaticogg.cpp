@@ -39,12 +39,13 @@ void MYSTATICOGG::poll()
             state_ = SoundClipStopped;
         }
     }
-    else get_pos();  // call this to keep the last_but_one stuff up to date
+    else get_pos_impl();  // call this to keep the last_but_one stuff up to date
 }
 
 void MYSTATICOGG::adjust_stream()
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_AdjustVolume)) { return; }
     alogg_adjust_ogg(tune, get_final_volume(), panning, speed, repeat);
 }
 
@@ -84,21 +85,23 @@ void MYSTATICOGG::destroy()
 void MYSTATICOGG::seek(int pos)
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_Seek, pos)) { return; }
 
     // we stop and restart it because otherwise the buffer finishes
-    // playing first and the seek isn't quite accurate
+    // playing first and the seek isn't quite accurate; the clip stays in
+    // the playing state meanwhile, as other threads may check it
     alogg_stop_ogg(tune);
-    state_ = SoundClipInitial;
-    play_from(pos);
+    if (!play_from(pos))
+        state_ = SoundClipStopped;
 }
 
-int MYSTATICOGG::get_pos()
+int MYSTATICOGG::get_pos_impl()
 {
     if (!is_playing()) { return -1; }
-    return get_pos_ms();
+    return get_pos_ms_impl();
 }
 
-int MYSTATICOGG::get_pos_ms()
+int MYSTATICOGG::get_pos_ms_impl()
 {
     if (!is_playing()) { return -1; }
 
@@ -143,7 +146,7 @@ case 1:
     return offs + last_but_one_but_one + extraOffset;
 }
 
-int MYSTATICOGG::get_length_ms()
+int MYSTATICOGG::get_length_ms_impl()
 {
     if (tune == nullptr) { return -1; }
     return alogg_get_length_msecs_ogg(tune);
@@ -158,6 +161,12 @@ int MYSTATICOGG::get_voice()
     return -1;
 }
 
+int MYSTATICOGG::get_time_to_poll_ms()
+{
+    if (state_ != SoundClipPlaying) { return SOUNDCLIP_DEFAULT_POLL_MS; }
+    return get_stream_time_to_poll_ms(alogg_get_audiostream_ogg(tune));
+}
+
 int MYSTATICOGG::get_sound_type() {
     return MUS_OGG;
 }
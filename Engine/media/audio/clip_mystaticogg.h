@@ -32,6 +32,8 @@ struct MYSTATICOGG:public SOUNDCLIP
 
     void poll() override;
 
+    int get_time_to_poll_ms() override;
+
     void set_volume(int newvol) override;
     void set_speed(int new_speed) override;
 
@@ -39,12 +41,6 @@ struct MYSTATICOGG:public SOUNDCLIP
 
     void seek(int pos) override;
 
-    int get_pos() override;    
-
-    int get_pos_ms() override;
-
-    int get_length_ms() override;
-
     int get_sound_type() override;
 
     int play_from(int position) override;
@@ -54,6 +50,10 @@ struct MYSTATICOGG:public SOUNDCLIP
     MYSTATICOGG();
 
 protected:
+    int get_pos_impl() override;
+    int get_pos_ms_impl() override;
+    int get_length_ms_impl() override;
+    bool is_pos_in_ms() const override { return true; }
     int get_voice() override;
     void adjust_volume() override;
 private:
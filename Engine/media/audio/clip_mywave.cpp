@@ -31,10 +31,21 @@ void MYWAVE::poll()
     }
 }
 
+int MYWAVE::get_time_to_poll_ms()
+{
+    if (state_ != SoundClipPlaying || repeat) { return SOUNDCLIP_DEFAULT_POLL_MS; }
+    // poll when the sample ends, to let the game know it has stopped
+    int pos = voice_get_position(voice);
+    int freq = voice_get_frequency(voice);
+    if (pos < 0 || freq <= 0) { return 0; }
+    return (int)((int64_t)(wave->len - pos) * 1000 / freq);
+}
+
 void MYWAVE::adjust_volume()
 {
     if (!is_playing()) { return; }
     if (voice < 0) { return; }
+    if (defer_command(kSoundClipCmd_AdjustVolume)) { return; }
     voice_set_volume(voice, get_final_volume());
 }
 
@@ -59,16 +70,17 @@ void MYWAVE::destroy()
 void MYWAVE::seek(int pos)
 {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_Seek, pos)) { return; }
     voice_set_position(voice, pos);
 }
 
-int MYWAVE::get_pos()
+int MYWAVE::get_pos_impl()
 {
     if (!is_playing()) { return -1; }
     return voice_get_position(voice);
 }
 
-int MYWAVE::get_pos_ms()
+int MYWAVE::get_pos_ms_impl()
 {
     // convert the offset in samples into the offset in ms
     //return ((1000000 / voice_get_frequency(voice)) * voice_get_position(voice)) / 1000;
@@ -79,7 +91,7 @@ int MYWAVE::get_pos_ms()
     return (voice_get_position(voice) / (voice_get_frequency(voice) / 100)) * 10;
 }
 
-int MYWAVE::get_length_ms()
+int MYWAVE::get_length_ms_impl()
 {
     if (wave == nullptr) { return -1; }
     if (wave->freq < 100)
@@ -25,17 +25,14 @@ struct MYWAVE:public SOUNDCLIP
 
     void poll() override;
 
+    int get_time_to_poll_ms() override;
+
     void set_volume(int new_speed) override;
 
     void destroy() override;
 
     void seek(int pos) override;
 
-    int get_pos() override;
-    int get_pos_ms() override;
-
-    int get_length_ms() override;
-
     int get_sound_type() override;
 
     int play() override;
@@ -43,6 +40,9 @@ struct MYWAVE:public SOUNDCLIP
     MYWAVE();
 
 protected:
+    int get_pos_impl() override;
+    int get_pos_ms_impl() override;
+    int get_length_ms_impl() override;
     int get_voice() override;
     void adjust_volume() override;
 };
@@ -136,7 +136,7 @@ SOUNDCLIP *my_load_static_mp3(const AssetPath &asset_name, int voll, bool loop)
     // now, create an MP3 structure for it
     thismp3 = new MYSTATICMP3();
     if (thismp3 == nullptr) {
-        free(mp3buffer);
+        sound_cache_free(mp3buffer, false);
         return nullptr;
     }
     thismp3->vol = voll;
@@ -149,7 +149,7 @@ SOUNDCLIP *my_load_static_mp3(const AssetPath &asset_name, int voll, bool loop)
     }
 
     if (thismp3->tune == nullptr) {
-        free(mp3buffer);
+        sound_cache_free(mp3buffer, false);
         delete thismp3;
         return nullptr;
     }
@@ -14,6 +14,8 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <list>
+#include <unordered_map>
 #include "ac/file.h"
 #include "util/wgt2allg.h"
 #include "media/audio/soundcache.h"
@@ -21,42 +23,91 @@
 #include "util/mutex.h"
 #include "util/mutex_lock.h"
 #include "util/string.h"
+#include "util/string_types.h"
 #include "debug/out.h"
 
 using namespace Common;
 
-sound_cache_entry_t* sound_cache_entries = nullptr;
-unsigned int sound_cache_counter = 0;
+struct SoundCacheEntry
+{
+    String  FileName;
+    char   *Data = nullptr;
+    long    DataSize = 0;   // size returned to the caller, 0 for waves
+    size_t  MemSize = 0;    // memory taken by the data
+    bool    IsWave = false;
+    int     Reference = 0;
+    // position in the list of unused sounds, valid when not referenced
+    std::list<SoundCacheEntry*>::iterator Unused;
+};
+
+// sounds by their file names
+static std::unordered_map<String, SoundCacheEntry> sound_cache_entries;
+// sounds by their data, for releasing them
+static std::unordered_map<const char*, SoundCacheEntry*> sound_cache_by_data;
+// sounds which are not played now, most recently used first
+static std::list<SoundCacheEntry*> sound_cache_unused;
+static size_t sound_cache_max_size = 32 * 1024 * 1024;
+static SoundCacheStats sound_cache_stats;
 
 AGS::Engine::Mutex _sound_cache_mutex;
 
 
-void clear_sound_cache()
+static size_t get_sound_mem_size(const char *data, bool is_wave, long size)
 {
-    AGS::Engine::MutexLock _lock(_sound_cache_mutex);
+    if (!is_wave)
+        return size;
+    const SAMPLE *wave = (const SAMPLE*)data;
+    return sizeof(SAMPLE) + wave->len * (wave->stereo ? 2 : 1) * (wave->bits / 8);
+}
 
-    if (sound_cache_entries)
-    {
-        int i;
-        for (i = 0; i < psp_audio_cachesize; i++)
-        {
-            if (sound_cache_entries[i].data)
-            {
-                free(sound_cache_entries[i].data);
-                sound_cache_entries[i].data = nullptr;
-                free(sound_cache_entries[i].file_name);
-                sound_cache_entries[i].file_name = nullptr;
-                sound_cache_entries[i].reference = 0;
-            }
-        }
-    }
+static void free_sound_data(char *data, bool is_wave)
+{
+    if (is_wave)
+        destroy_sample((SAMPLE*)data);
     else
+        free(data);
+}
+
+// Removes the least recently used sounds which are not played now, until
+// the cache fits into its limits
+static void trim_sound_cache()
+{
+    while (!sound_cache_unused.empty() &&
+        (sound_cache_stats.MemSize > sound_cache_max_size ||
+         (psp_audio_cachesize > 0 && sound_cache_entries.size() > (size_t)psp_audio_cachesize)))
     {
-        sound_cache_entries = (sound_cache_entry_t*)malloc(psp_audio_cachesize * sizeof(sound_cache_entry_t));
-        memset(sound_cache_entries, 0, psp_audio_cachesize * sizeof(sound_cache_entry_t));
+        SoundCacheEntry *entry = sound_cache_unused.back();
+        sound_cache_unused.pop_back();
+#ifdef SOUND_CACHE_DEBUG
+        Debug::Printf("..removing %s from cache\n", entry->FileName.GetCStr());
+#endif
+        free_sound_data(entry->Data, entry->IsWave);
+        sound_cache_stats.MemSize -= entry->MemSize;
+        sound_cache_stats.Evictions++;
+        sound_cache_by_data.erase(entry->Data);
+        sound_cache_entries.erase(entry->FileName);
     }
 }
 
+void set_sound_cache_max_size(size_t size)
+{
+    AGS::Engine::MutexLock _lock(_sound_cache_mutex);
+    sound_cache_max_size = size;
+    trim_sound_cache();
+}
+
+void clear_sound_cache()
+{
+    AGS::Engine::MutexLock _lock(_sound_cache_mutex);
+
+    for (auto &entry : sound_cache_entries)
+        free_sound_data(entry.second.Data, entry.second.IsWave);
+    sound_cache_entries.clear();
+    sound_cache_by_data.clear();
+    sound_cache_unused.clear();
+    sound_cache_stats = SoundCacheStats();
+}
+
 void sound_cache_free(char* buffer, bool is_wave)
 {
     AGS::Engine::MutexLock _lock(_sound_cache_mutex);
@@ -64,39 +115,43 @@ void sound_cache_free(char* buffer, bool is_wave)
 #ifdef SOUND_CACHE_DEBUG
     Debug::Printf("sound_cache_free(%p %d)\n", buffer, (unsigned int)is_wave);
 #endif
-    int i;
-    for (i = 0; i < psp_audio_cachesize; i++)
+    auto it = sound_cache_by_data.find(buffer);
+    if (it != sound_cache_by_data.end())
     {
-        if (sound_cache_entries[i].data == buffer)
+        SoundCacheEntry *entry = it->second;
+        if (entry->Reference > 0 && --entry->Reference == 0)
         {
-            if (sound_cache_entries[i].reference > 0)
-                sound_cache_entries[i].reference--;
-
+            sound_cache_unused.push_front(entry);
+            entry->Unused = sound_cache_unused.begin();
+            trim_sound_cache();
+        }
 #ifdef SOUND_CACHE_DEBUG
-            Debug::Printf("..decreased reference count of slot %d to %d\n", i, sound_cache_entries[i].reference);
+        Debug::Printf("..decreased reference count of %s to %d\n", entry->FileName.GetCStr(), entry->Reference);
 #endif
-            return;
-        }
+        return;
     }
+    _lock.Release();
 
 #ifdef SOUND_CACHE_DEBUG
     Debug::Printf("..freeing uncached sound\n");
 #endif
 
     // Sound is uncached
-    if (i == psp_audio_cachesize)
-    {
-        if (is_wave)
-            destroy_sample((SAMPLE*)buffer);
-        else
-            free(buffer);
-    }
+    free_sound_data(buffer, is_wave);
 }
 
+// Takes the cached sound, adding a reference to it
+static char *use_cached_sound(SoundCacheEntry &entry, long *size)
+{
+    if (entry.Reference++ == 0)
+        sound_cache_unused.erase(entry.Unused);
+    *size = entry.DataSize;
+    return entry.Data;
+}
 
 char* get_cached_sound(const AssetPath &asset_name, bool is_wave, long* size)
 {
-	AGS::Engine::MutexLock _lock(_sound_cache_mutex);
+    AGS::Engine::MutexLock _lock(_sound_cache_mutex);
 
 #ifdef SOUND_CACHE_DEBUG
     Debug::Printf("get_cached_sound(%s %d)\n", asset_name.first.GetCStr(), (unsigned int)is_wave);
@@ -104,132 +159,90 @@ char* get_cached_sound(const AssetPath &asset_name, bool is_wave, long* size)
 
     *size = 0;
 
-    int i;
-    for (i = 0; i < psp_audio_cachesize; i++)
+    auto it = sound_cache_entries.find(asset_name.second);
+    if (it != sound_cache_entries.end())
     {
-        if (sound_cache_entries[i].data == nullptr)
-            continue;
-
-        if (strcmp(asset_name.second, sound_cache_entries[i].file_name) == 0)
-        {
 #ifdef SOUND_CACHE_DEBUG
-            Debug::Printf("..found in slot %d\n", i);
+        Debug::Printf("..found in cache\n");
 #endif
-            sound_cache_entries[i].reference++;
-            sound_cache_entries[i].last_used = sound_cache_counter++;
-            *size = sound_cache_entries[i].size;
-
-            return sound_cache_entries[i].data;
-        }
+        sound_cache_stats.Hits++;
+        return use_cached_sound(it->second, size);
     }
+    sound_cache_stats.Misses++;
+    // the file is read without holding the lock, so that the sounds
+    // which are playing may be released meanwhile
+    _lock.Release();
 
     // Not found
-    PACKFILE *mp3in = nullptr;
-    SAMPLE* wave = nullptr;
-
+    char* newdata;
     if (is_wave)
     {
         PACKFILE *wavin = PackfileFromAsset(asset_name);
-        if (wavin != nullptr)
-        {
-            wave = load_wav_pf(wavin);
-            pack_fclose(wavin);
-        }
-    }  
-    else
-    {
-        mp3in = PackfileFromAsset(asset_name);
-        if (mp3in == nullptr)
-        {
+        if (wavin == nullptr)
+            return nullptr;
+        SAMPLE* wave = load_wav_pf(wavin);
+        pack_fclose(wavin);
+        if (wave == nullptr)
             return nullptr;
-        }
-    }
-
-    // Find free slot
-    for (i = 0; i < psp_audio_cachesize; i++)
-    {
-        if (sound_cache_entries[i].data == nullptr)
-            break;
-    }
-
-    // No free slot?
-    if (i == psp_audio_cachesize)
-    {
-        unsigned int oldest = sound_cache_counter;
-        int index = -1;
-
-        for (i = 0; i < psp_audio_cachesize; i++)
-        {
-            if (sound_cache_entries[i].reference == 0)
-            {
-                if (sound_cache_entries[i].last_used < oldest)
-                {
-                    oldest = sound_cache_entries[i].last_used;
-                    index = i;
-                }
-            }
-        }
-
-        i = index;
-    }
-
-    // Load new file
-    char* newdata;
-
-    if (is_wave)
-    {
-        *size = 0;
         newdata = (char*)wave;
     }
     else
     {
+        PACKFILE *mp3in = PackfileFromAsset(asset_name);
+        if (mp3in == nullptr)
+            return nullptr;
         *size = mp3in->normal.todo;
         newdata = (char *)malloc(*size);
-
         if (newdata == nullptr)
         {
             pack_fclose(mp3in);
             return nullptr;
         }
-
         pack_fread(newdata, *size, mp3in);
         pack_fclose(mp3in);
     }
+    const size_t mem_size = get_sound_mem_size(newdata, is_wave, *size);
 
-    if (i == -1)
+    _lock.Acquire(_sound_cache_mutex);
+    it = sound_cache_entries.find(asset_name.second);
+    if (it != sound_cache_entries.end())
     {
-        // No cache slot empty, return uncached data
+        // another thread has loaded the same sound meanwhile
+        free_sound_data(newdata, is_wave);
+        return use_cached_sound(it->second, size);
+    }
+
+    if (mem_size > sound_cache_max_size)
+    {
+        // Too big for the cache, return uncached data
 #ifdef SOUND_CACHE_DEBUG
         Debug::Printf("..loading uncached\n");
 #endif
-        return newdata;  
+        sound_cache_stats.Uncached++;
+        return newdata;
     }
-    else
-    {
-        // Add to cache, free old sound first
+
+    // Add to cache, removing the old sounds if it's full
 #ifdef SOUND_CACHE_DEBUG
-        Debug::Printf("..loading cached in slot %d\n", i);
-#endif	
-
-        if (sound_cache_entries[i].data) {
-            if (sound_cache_entries[i].is_wave)
-                destroy_sample((SAMPLE*)sound_cache_entries[i].data);
-            else
-                free(sound_cache_entries[i].data);
-	}
-	
-        sound_cache_entries[i].size = *size;
-        sound_cache_entries[i].data = newdata;
-
-        if (sound_cache_entries[i].file_name)
-            free(sound_cache_entries[i].file_name);
-        sound_cache_entries[i].file_name = (char*)malloc(strlen(asset_name.second) + 1);
-        strcpy(sound_cache_entries[i].file_name, asset_name.second);
-        sound_cache_entries[i].reference = 1;
-        sound_cache_entries[i].last_used = sound_cache_counter++;
-        sound_cache_entries[i].is_wave = is_wave;
-
-        return sound_cache_entries[i].data;	
-    }
+    Debug::Printf("..loading cached\n");
+#endif
+    SoundCacheEntry &entry = sound_cache_entries[asset_name.second];
+    entry.FileName = asset_name.second;
+    entry.Data = newdata;
+    entry.DataSize = *size;
+    entry.MemSize = mem_size;
+    entry.IsWave = is_wave;
+    entry.Reference = 1;
+    sound_cache_by_data[newdata] = &entry;
+    sound_cache_stats.MemSize += mem_size;
+    trim_sound_cache();
+    return newdata;
+}
 
+SoundCacheStats get_sound_cache_stats()
+{
+    AGS::Engine::MutexLock _lock(_sound_cache_mutex);
+    SoundCacheStats stats = sound_cache_stats;
+    stats.Entries = sound_cache_entries.size();
+    return stats;
 }
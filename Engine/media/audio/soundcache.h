@@ -20,29 +20,32 @@
 // PSP: A simple sound cache. The size can be configured in the config file.
 // The data rate while reading from disk on the PSP is usually between 500 to 900 kiB/s,
 // caching the last used sound files therefore improves game performance.
+//
+// Sounds are found by name in a hash table. The cache is limited by the
+// memory its sounds take, and when it is full, the sounds which are not
+// played and were used the longest time ago are removed.
 
 //#define SOUND_CACHE_DEBUG
 
-typedef struct
+struct SoundCacheStats
 {
-    char* file_name;
-    int number;
-    int free;
-    unsigned int last_used;
-    unsigned int size;
-    char* data;
-    int reference;
-    bool is_wave;
-} sound_cache_entry_t;
-
-extern int psp_use_sound_cache;
-extern int psp_sound_cache_max_size;
+    unsigned int Hits = 0;
+    unsigned int Misses = 0;
+    unsigned int Evictions = 0;
+    unsigned int Uncached = 0; // sounds too big for the cache
+    unsigned int Entries = 0;
+    size_t       MemSize = 0;
+};
+
 extern int psp_audio_cachesize;
 extern int psp_midi_preload_patches;
 
+// Sets the memory limit of the cache, in bytes
+void set_sound_cache_max_size(size_t size);
 void clear_sound_cache();
 void sound_cache_free(char* buffer, bool is_wave);
 char* get_cached_sound(const AssetPath &asset_name, bool is_wave, long* size);
+SoundCacheStats get_sound_cache_stats();
 
 
 #endif // __AC_SOUNDCACHE_H
@@ -12,7 +12,9 @@
 //
 //=============================================================================
 
+#include <algorithm>
 #include "util/wgt2allg.h"
+#include "ac/timer.h"
 #include "media/audio/audio.h"
 #include "media/audio/audiodefines.h"
 #include "media/audio/soundclip.h"
@@ -30,6 +32,7 @@ int SOUNDCLIP::play_from(int position)
 
 void SOUNDCLIP::set_panning(int newPanning) {
     if (!is_playing()) { return; }
+    if (defer_command(kSoundClipCmd_Panning, newPanning)) { return; }
     
     int voice = get_voice();
     if (voice >= 0) {
@@ -38,7 +41,12 @@ void SOUNDCLIP::set_panning(int newPanning) {
     }
 }
 
+void SOUNDCLIP::set_speed(int new_speed) {
+    speed = new_speed;
+}
+
 void SOUNDCLIP::pause() {
+    if (defer_command(kSoundClipCmd_Pause)) { return; }
     if (state_ != SoundClipPlaying) { return; }
 
     int voice = get_voice();
@@ -49,6 +57,7 @@ void SOUNDCLIP::pause() {
 }
 
 void SOUNDCLIP::resume() {
+    if (defer_command(kSoundClipCmd_Resume)) { return; }
     if (state_ != SoundClipPaused) { return; }
 
     int voice = get_voice();
@@ -58,6 +67,114 @@ void SOUNDCLIP::resume() {
     }
 }
 
+int SOUNDCLIP::get_time_to_poll_ms()
+{
+    return SOUNDCLIP_DEFAULT_POLL_MS;
+}
+
+int SOUNDCLIP::get_pos()
+{
+    if (!use_published_state())
+        return get_pos_impl();
+    const SoundClipSnapshot snap = snapshot.Load();
+    // seek was not made yet, tell the position it was made to
+    if (seeksSent != snap.SeeksDone)
+        return pendingSeekPos;
+    if (!is_pos_in_ms())
+        return snap.Pos;
+    return snap.Pos + get_time_since_snapshot(snap);
+}
+
+int SOUNDCLIP::get_pos_ms()
+{
+    if (!use_published_state())
+        return get_pos_ms_impl();
+    const SoundClipSnapshot snap = snapshot.Load();
+    if (seeksSent != snap.SeeksDone && is_pos_in_ms())
+        return pendingSeekPos;
+    return snap.PosMs + get_time_since_snapshot(snap);
+}
+
+int SOUNDCLIP::get_length_ms()
+{
+    if (!use_published_state())
+        return get_length_ms_impl();
+    return snapshot.Load().LengthMs;
+}
+
+bool SOUNDCLIP::defer_command(SoundClipCommand cmd, int value)
+{
+    if (!playedByAudioThread || is_audio_thread())
+        return false;
+    if (cmd == kSoundClipCmd_Seek)
+    {
+        seeksSent++;
+        pendingSeekPos = value;
+    }
+    send_audio_command(this, cmd, value);
+    return true;
+}
+
+void SOUNDCLIP::run_command(SoundClipCommand cmd, int value)
+{
+    switch (cmd)
+    {
+    case kSoundClipCmd_AdjustVolume: adjust_volume(); break;
+    case kSoundClipCmd_Panning: set_panning(value); break;
+    case kSoundClipCmd_Seek: seek(value); seeksDone++; break;
+    case kSoundClipCmd_Pause: pause(); break;
+    case kSoundClipCmd_Resume: resume(); break;
+    default: break;
+    }
+}
+
+void SOUNDCLIP::publish_state()
+{
+    SoundClipSnapshot snap;
+    snap.Pos = get_pos_impl();
+    snap.PosMs = get_pos_ms_impl();
+    snap.LengthMs = get_length_ms_impl();
+    snap.Playing = state_ == SoundClipPlaying;
+    snap.SeeksDone = seeksDone;
+    snap.Time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        AGS_Clock::now().time_since_epoch()).count();
+    snapshot.Store(snap);
+}
+
+int SOUNDCLIP::get_time_since_snapshot(const SoundClipSnapshot &snap) const
+{
+    // the position is not known, or does not advance
+    if (!snap.Playing || snap.PosMs <= 0)
+        return 0;
+    const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        AGS_Clock::now().time_since_epoch()).count();
+    // the audio thread publishes the state at least this often, unless it is
+    // held up, in which case the playback is likely held up too
+    int64_t elapsed = std::min<int64_t>(now - snap.Time, SOUNDCLIP_MAX_SNAPSHOT_AGE_MS);
+    elapsed = elapsed * speed / 1000;
+    if (snap.LengthMs > 0)
+        elapsed = std::min<int64_t>(elapsed, std::max(0, snap.LengthMs - snap.PosMs));
+    return (int)std::max<int64_t>(elapsed, 0);
+}
+
+bool SOUNDCLIP::use_published_state() const
+{
+    return playedByAudioThread && !is_audio_thread();
+}
+
+int SOUNDCLIP::get_stream_time_to_poll_ms(AUDIOSTREAM *stream) const
+{
+    if (state_ != SoundClipPlaying || !stream)
+        return SOUNDCLIP_DEFAULT_POLL_MS;
+    int pos = voice_get_position(stream->voice);
+    int freq = voice_get_frequency(stream->voice);
+    if (pos < 0 || freq <= 0)
+        return 0;
+    const int half_len = stream->len * stream->bufcount;
+    int samples_left = (pos < half_len) ? half_len - pos : 2 * half_len - pos;
+    return (int)((int64_t)samples_left * 1000 / freq);
+}
+
 SOUNDCLIP::SOUNDCLIP() {
     state_ = SoundClipInitial;
     priority = 50;
@@ -75,6 +192,10 @@ SOUNDCLIP::SOUNDCLIP() {
     ySource = -1;
     maximumPossibleDistanceAway = 0;
     directionalVolModifier = 0;
+    playedByAudioThread = false;
+    seeksDone = 0;
+    seeksSent = 0;
+    pendingSeekPos = 0;
 }
 
 SOUNDCLIP::~SOUNDCLIP() = default;
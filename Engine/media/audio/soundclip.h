@@ -19,7 +19,11 @@
 #ifndef __AC_SOUNDCLIP_H
 #define __AC_SOUNDCLIP_H
 
+#include <atomic>
 #include "util/mutex.h"
+#include "util/seqlock.h"
+
+struct AUDIOSTREAM;
 
 // JJS: This is needed for the derieved classes
 extern volatile int psp_audio_multithreaded;
@@ -32,22 +36,49 @@ extern volatile int psp_audio_multithreaded;
 
 enum SoundClipState { SoundClipInitial, SoundClipPlaying, SoundClipPaused, SoundClipStopped };
 
+// Operations which the game thread sends to the audio thread, for the clips
+// played by it
+enum SoundClipCommand
+{
+    kSoundClipCmd_Attach,       // start playing the clip on the audio thread
+    kSoundClipCmd_AdjustVolume, // apply volume and speed to playback
+    kSoundClipCmd_Panning,      // set_panning(value)
+    kSoundClipCmd_Seek,         // seek(value)
+    kSoundClipCmd_Pause,        // pause()
+    kSoundClipCmd_Resume,       // resume()
+    kSoundClipCmd_Delete        // destroy() and delete the clip
+};
+
+// Playback state of the clip played by the audio thread, which it publishes
+// for the game thread after running the commands and polling the clip
+struct SoundClipSnapshot
+{
+    int Pos;
+    int PosMs;
+    int LengthMs;
+    bool Playing;
+    // number of seeks made by the audio thread
+    uint32_t SeeksDone;
+    // time of publishing, in ms of AGS_Clock
+    int64_t Time;
+};
+
 struct SOUNDCLIP
 {
     int priority;
     int sourceClipType;
     // absolute volume, set by implementations only!
-    int vol;
+    std::atomic<int> vol;
     // current relative volume, in percents
     int volAsPercentage;
     // volModifier is used when there's a need to temporarily change and
     // the restore the clip's absolute volume (vol)
-    int volModifier;
-    int panning;
+    std::atomic<int> volModifier;
+    std::atomic<int> panning;
     int panningAsPercentage;
     int xSource, ySource;
     int maximumPossibleDistanceAway;
-    int directionalVolModifier;
+    std::atomic<int> directionalVolModifier;
     bool repeat;
     void *sourceClip;
 
@@ -57,20 +88,40 @@ struct SOUNDCLIP
     // NOTE: this completely ignores volAsPercentage and muted property
     virtual void set_volume(int) = 0;
     virtual void seek(int) = 0;
-    virtual int get_pos() = 0;    // return 0 to indicate seek not supported
-    virtual int get_pos_ms() = 0; // this must always return valid value if poss
-    virtual int get_length_ms() = 0; // return total track length in ms (or 0)
+    int get_pos();    // return 0 to indicate seek not supported
+    int get_pos_ms(); // this must always return valid value if poss
+    int get_length_ms(); // return total track length in ms (or 0)
     virtual int get_sound_type() = 0;
     virtual int play() = 0;
 
     virtual int play_from(int position);
 
     virtual void set_panning(int newPanning);
-    virtual void set_speed(int new_speed) { speed = new_speed; }
+    virtual void set_speed(int new_speed);
 
     virtual void pause();
     virtual void resume();
 
+    // Returns how long the clip may play before it has to be polled again,
+    // in ms: until its stream runs out of the decoded data, or until it ends
+    virtual int get_time_to_poll_ms();
+
+    // While the clip is played by the audio thread, only that thread changes
+    // its playback: the methods which do that, when called on another thread,
+    // set the clip's properties and send the command to apply them to the
+    // audio thread, and the methods which read the playback state return the
+    // state from the last snapshot published by the audio thread, advanced
+    // by the time passed since then.
+    inline bool is_played_by_audio_thread() const { return playedByAudioThread; }
+    inline void set_played_by_audio_thread(bool on) { playedByAudioThread = on; }
+    // If the clip is played by the audio thread and this is called on
+    // another one, sends the command to the audio thread and returns true
+    bool defer_command(SoundClipCommand cmd, int value = 0);
+    // Runs the command on the current thread
+    void run_command(SoundClipCommand cmd, int value);
+    // Publishes the current playback state for the other threads
+    void publish_state();
+
     inline bool is_playing() const { return state_ == SoundClipPlaying || state_ == SoundClipPaused; }
 
     inline int get_speed() const
@@ -146,19 +197,44 @@ struct SOUNDCLIP
 
 protected:
 
-    SoundClipState state_;
+    std::atomic<SoundClipState> state_;
 
     // mute mode overrides the volume; if set, any volume assigned is stored
     // in properties, but not applied to playback itself
     bool muted;
 
     // speed of playback, in clip ms per real second
-    int speed; 
+    std::atomic<int> speed;
+
+    std::atomic<bool> playedByAudioThread;
+    // playback state published by the audio thread
+    AGS::Engine::SeqLockValue<SoundClipSnapshot> snapshot;
+    // seeks made by the thread which runs the commands
+    uint32_t seeksDone;
+    // seeks sent to the audio thread, and the last position sent
+    uint32_t seeksSent;
+    int pendingSeekPos;
+
+    // Tells if the playback state should be read from the snapshot
+    bool use_published_state() const;
+
+    // Read the playback state from the decoder
+    virtual int get_pos_impl() = 0;
+    virtual int get_pos_ms_impl() = 0;
+    virtual int get_length_ms_impl() = 0;
+    // Tells if get_pos() returns the position in ms
+    virtual bool is_pos_in_ms() const { return false; }
+    // Calculates how far the clip has played since the snapshot, in ms
+    int get_time_since_snapshot(const SoundClipSnapshot &snap) const;
 
     // Return the allegro voice number (or -1 if none)
     // Used by generic pause/resume functions.
     virtual int get_voice() = 0;
 
+    // Calculates the time until the part of the stream's double buffer,
+    // which is being played now, ends; the other part must be refilled by then
+    int get_stream_time_to_poll_ms(AUDIOSTREAM *stream) const;
+
     // helper function for calculating volume with applied modifiers
     inline int get_final_volume() const
     {
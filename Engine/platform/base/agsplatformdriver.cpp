@@ -223,15 +223,13 @@ void AGSPlatformDriver::Delay(int millis) {
   for (;;) {
     if (now >= delayUntil) { break; }
 
-    auto duration = std::min<std::chrono::nanoseconds>(delayUntil - now, MaximumDelayBetweenPolling);
-    std::this_thread::sleep_for(duration);
-    now = AGS_Clock::now(); // update now
-
-    if (now >= delayUntil) { break; }
-
     // don't allow it to check for debug messages, since this Delay()
     // call might be from within a debugger polling loop
     update_polled_mp3();
+
+    auto duration = std::min<std::chrono::nanoseconds>(delayUntil - AGS_Clock::now(), MaximumDelayBetweenPolling);
+    if (duration > std::chrono::nanoseconds::zero())
+      std::this_thread::sleep_for(duration);
     now = AGS_Clock::now(); // update now
   }
 }
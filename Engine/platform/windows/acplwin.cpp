@@ -938,6 +938,7 @@ void AGSWin32::PlayVideo(const char *name, int skip, int flags) {
     install_sound(usetup.digicard,usetup.midicard,NULL);
     if (usetup.mod_player)
       init_mod_player(NUM_MOD_DIGI_VOICES);
+    restart_sound_thread();
   }
 
   set_palette_range(palette, 0, 255, 0);
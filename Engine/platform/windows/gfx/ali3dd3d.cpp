@@ -1621,6 +1621,67 @@ void D3DGraphicsDriver::UpdateDDBFromBitmap(IDriverDependantBitmap* bitmapToUpda
       unselect_palette();
 }
 
+void D3DGraphicsDriver::UpdateTextureSubRegion(D3DTextureTile *tile, Bitmap *bitmap, D3DBitmap *target, const Rect &region, bool hasAlpha)
+{
+  IDirect3DTexture9* texture = tile->texture;
+
+  RECT lockRect;
+  lockRect.left = region.Left - tile->x;
+  lockRect.top = region.Top - tile->y;
+  lockRect.right = region.Right - tile->x + 1;
+  lockRect.bottom = region.Bottom - tile->y + 1;
+  D3DLOCKED_RECT lockedRegion;
+  HRESULT hr = texture->LockRect(0, &lockedRegion, &lockRect, D3DLOCK_NOSYSLOCK);
+  if (hr != D3D_OK)
+  {
+    throw Ali3DException("Unable to lock texture");
+  }
+
+  TextureTile subTile;
+  subTile.x = region.Left;
+  subTile.y = region.Top;
+  subTile.width = region.GetWidth();
+  subTile.height = region.GetHeight();
+  BitmapToVideoMemOpaque(bitmap, hasAlpha, &subTile, target, (char*)lockedRegion.pBits, lockedRegion.Pitch);
+
+  texture->UnlockRect(0);
+}
+
+void D3DGraphicsDriver::UpdateDDBRegionFromBitmap(IDriverDependantBitmap* bitmapToUpdate, Bitmap *bitmap, const Rect &region, bool hasAlpha)
+{
+  D3DBitmap *target = (D3DBitmap*)bitmapToUpdate;
+  // Only opaque textures may be updated partially, because for the translucent ones
+  // the pixel conversion depends on the neighbouring pixels
+  if (!target->_opaque || target->_hasAlpha != hasAlpha)
+  {
+    UpdateDDBFromBitmap(bitmapToUpdate, bitmap, hasAlpha);
+    return;
+  }
+  if (target->_width != bitmap->GetWidth() || target->_height != bitmap->GetHeight())
+    throw Ali3DException("UpdateDDBRegionFromBitmap: mismatched bitmap size");
+  const int color_depth = bitmap->GetColorDepth();
+  if (color_depth != target->_colDepth)
+    throw Ali3DException("UpdateDDBRegionFromBitmap: mismatched colour depths");
+
+  const Rect rc = IntersectRects(region, RectWH(0, 0, target->_width, target->_height));
+  if (rc.IsEmpty())
+    return;
+
+  if (color_depth == 8)
+      select_palette(palette);
+
+  for (int i = 0; i < target->_numTiles; i++)
+  {
+    D3DTextureTile *tile = &target->_tiles[i];
+    const Rect tile_rc = IntersectRects(rc, RectWH(tile->x, tile->y, tile->width, tile->height));
+    if (!tile_rc.IsEmpty())
+      UpdateTextureSubRegion(tile, bitmap, target, tile_rc, hasAlpha);
+  }
+
+  if (color_depth == 8)
+      unselect_palette();
+}
+
 int D3DGraphicsDriver::GetCompatibleBitmapFormat(int color_depth)
 {
   if (color_depth == 8)
@@ -37,6 +37,7 @@
 #include "ac/path_helper.h"
 #include "ac/roomstatus.h"
 #include "ac/string.h"
+#include "ac/walkablearea.h"
 #include "ac/dynobj/cc_dynamicobject_addr_and_manager.h"
 #include "font/fonts.h"
 #include "util/string_compat.h"
@@ -489,7 +490,11 @@ BITMAP *IAGSEngine::GetSpriteGraphic (int32 num) {
 }
 BITMAP *IAGSEngine::GetRoomMask (int32 index) {
     if (index == MASK_WALKABLE)
+    {
+        // plugin may modify the mask
+        invalidate_walkable_areas_temp();
         return (BITMAP*)thisroom.WalkAreaMask->GetAllegroBitmap();
+    }
     else if (index == MASK_WALKBEHIND)
         return (BITMAP*)thisroom.WalkBehindMask->GetAllegroBitmap();
     else if (index == MASK_HOTSPOT)
@@ -678,6 +683,7 @@ void IAGSEngine::DisableSound() {
     usetup.midicard = MIDI_NONE;
     reserve_voices(0, 0);
     install_sound(DIGI_NONE, MIDI_NONE, nullptr);
+    restart_sound_thread();
 }
 int IAGSEngine::CanRunScriptFunctionNow() {
     if (inside_script)
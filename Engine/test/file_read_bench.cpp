@@ -0,0 +1,235 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// File reading benchmark: loads the rooms through each kind of the file
+// stream and reports how long the room data takes to read. With -c the
+// file's pages are dropped from the system cache before every load, which
+// is the closest to the first time load; to test a network filesystem, run
+// it over the files on a mounted share (the server's own cache stays warm).
+//
+// Usage: file_read_bench [-r runs] [-c] <room file | game data file>...
+// When given a game data file, all the rooms packed inside are loaded.
+//
+//=============================================================================
+#include <allegro.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "core/assetmanager.h"
+#include "core/platform.h"
+#include "game/room_file.h"
+#include "game/roomstruct.h"
+#include "util/bufferedstream.h"
+#include "util/memorymappedstream.h"
+#if AGS_PLATFORM_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace AGS::Common;
+
+enum StreamKind
+{
+    kStream_File,       // plain FileStream
+    kStream_Buffered,   // BufferedStream
+    kStream_ReadAhead,  // BufferedStream reading ahead on a thread
+    kStream_Mapped,     // MemoryMappedStream
+    kNumStreamKinds
+};
+
+static const char *StreamKindNames[kNumStreamKinds] = { "file", "buffered", "readahead", "mapped" };
+
+struct LoadStats
+{
+    int     Loads = 0;
+    int     Failed = 0;
+    double  TotalMs = 0.0;
+    double  MaxMs = 0.0;
+};
+
+static LoadStats Stats[kNumStreamKinds];
+
+// Drops the cached pages of the file, so that the next read goes to the disk
+static bool DropFileCache(const String &filename)
+{
+#if AGS_PLATFORM_OS_LINUX
+    int fd = open(filename.GetCStr(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+#else
+    (void)filename;
+    return false;
+#endif
+}
+
+static Stream *OpenStream(StreamKind kind, const AssetLocation &loc)
+{
+    Stream *s = nullptr;
+    try
+    {
+        switch (kind)
+        {
+        case kStream_File:
+            s = new FileStream(loc.FileName, kFile_Open, kFile_Read);
+            break;
+        case kStream_Buffered:
+            s = new BufferedStream(loc.FileName, kFile_Open, kFile_Read);
+            break;
+        case kStream_ReadAhead:
+            s = new BufferedStream(loc.FileName, kFile_Open, kFile_Read, kLittleEndian, true);
+            break;
+        case kStream_Mapped:
+            {
+                // like the asset manager, map the whole library unless the address
+                // space is limited; it is mapped again for each load, so that
+                // dropping the file cache is not kept back by the mapping
+                std::shared_ptr<MappedFile> file = sizeof(void*) < 8 ?
+                    MappedFile::Map(loc.FileName, loc.Offset, loc.Size) : MappedFile::Map(loc.FileName);
+                if (file)
+                    s = new MemoryMappedStream(file, loc.Offset, loc.Size);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    catch (const std::runtime_error&)
+    {
+        s = nullptr;
+    }
+    if (s)
+        s->Seek(loc.Offset, kSeekBegin);
+    return s;
+}
+
+static void LoadRoom(StreamKind kind, const AssetLocation &loc, RoomStruct &room)
+{
+    LoadStats &st = Stats[kind];
+    room.Free();
+    room.InitDefaults();
+    const auto t0 = std::chrono::high_resolution_clock::now();
+    std::unique_ptr<Stream> in(OpenStream(kind, loc));
+    bool ok = false;
+    if (in)
+    {
+        RoomFileVersion data_ver = (RoomFileVersion)in->ReadInt16();
+        ok = (bool)ReadRoomData(&room, in.get(), data_ver);
+        in.reset();
+    }
+    const double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - t0).count();
+    st.Loads++;
+    if (!ok)
+    {
+        st.Failed++;
+        return;
+    }
+    st.TotalMs += ms;
+    if (ms > st.MaxMs)
+        st.MaxMs = ms;
+}
+
+static void PrintReport()
+{
+    printf("\n%-10s %8s %8s %10s %10s\n", "stream", "loads", "failed", "avg ms", "max ms");
+    for (int k = 0; k < kNumStreamKinds; ++k)
+    {
+        const LoadStats &st = Stats[k];
+        if (st.Loads == 0)
+            continue;
+        const int loaded = st.Loads - st.Failed;
+        printf("%-10s %8d %8d %10.3f %10.3f\n", StreamKindNames[k], st.Loads, st.Failed,
+            loaded > 0 ? st.TotalMs / loaded : 0.0, st.MaxMs);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = 5;
+    bool cold = false;
+    std::vector<String> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc))
+            runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0)
+            cold = true;
+        else
+            inputs.push_back(argv[i]);
+    }
+    if (inputs.empty())
+    {
+        printf("Usage: %s [-r runs] [-c] <room file | game data file>...\n", argv[0]);
+        return 1;
+    }
+
+    install_allegro(SYSTEM_NONE, &errno, atexit);
+    AssetManager::CreateInstance();
+
+    std::vector<AssetLocation> rooms;
+    for (const String &input : inputs)
+    {
+        if (AssetManager::IsDataFile(input))
+        {
+            AssetManager::SetDataFile(input);
+            AssetManager::SetSearchPriority(kAssetPriorityLib);
+            for (int i = 0; i < AssetManager::GetAssetCount(); ++i)
+            {
+                String name = AssetManager::GetAssetFileByIndex(i);
+                AssetLocation loc;
+                if ((name.CompareLeftNoCase("room") == 0) && (name.CompareRightNoCase(".crm") == 0) &&
+                    AssetManager::GetAssetLocation(name, loc))
+                    rooms.push_back(loc);
+            }
+        }
+        else
+        {
+            AssetLocation loc;
+            loc.FileName = input;
+            loc.Offset = 0;
+            loc.Size = File::GetFileSize(input);
+            rooms.push_back(loc);
+        }
+    }
+    printf("%d rooms, %d runs, %s cache\n", (int)rooms.size(), runs, cold ? "cold" : "warm");
+    if (cold && !DropFileCache(inputs[0]))
+        printf("Cannot drop the file cache on this system, the results are for the warm cache\n");
+
+    RoomStruct room;
+    for (int run = 0; run < runs; ++run)
+    {
+        // streams take turns, so that each gets a similar state of the system
+        for (int k = 0; k < kNumStreamKinds; ++k)
+        {
+            for (const AssetLocation &loc : rooms)
+            {
+                if (cold)
+                    DropFileCache(loc.FileName);
+                LoadRoom((StreamKind)k, loc, room);
+            }
+        }
+    }
+
+    PrintReport();
+    room.Free();
+    AssetManager::DestroyInstance();
+    return 0;
+}
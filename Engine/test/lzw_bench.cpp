@@ -0,0 +1,403 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// LZW decoding benchmark: finds the packed background blocks stored in the
+// room files, and unpacks each of them straight from the file with the
+// original decoder, which read the stream a byte at a time, and with the
+// current one, which reads the block whole and unpacks it in memory. Both
+// results must be exactly the same. Without the room files, the test
+// pictures are generated, packed and written to a temporary file first.
+//
+// Usage: lzw_bench [-r runs] [room file | game data file]...
+// When given a game data file, all the rooms packed inside are tested.
+//
+//=============================================================================
+#include <allegro.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "ac/common.h" // quit
+#include "core/assetmanager.h"
+#include "game/room_file.h"
+#include "game/roomstruct.h"
+#include "util/compress.h"
+#include "util/file.h"
+#include "util/proxystream.h"
+#include "util/stream.h"
+#include "test/lzw_pack.h"
+
+using namespace AGS::Common;
+
+// The original decoder, as it was before the in-memory one replaced it
+namespace BaselineLzw
+{
+
+#define N 4096
+#define F 16
+
+long outbytes = 0, maxsize = 0, putbytes = 0;
+
+int expand_to_mem = 0;
+unsigned char *membfptr = nullptr;
+void myputc(int ccc, Stream *out)
+{
+  if (maxsize > 0) {
+    putbytes++;
+    if (putbytes > maxsize)
+      return;
+  }
+
+  outbytes++;
+  if (expand_to_mem) {
+    membfptr[0] = ccc;
+    membfptr++;
+  } else
+    out->WriteInt8(ccc);
+}
+
+void lzwexpand(Stream *lzw_in, Stream *out)
+{
+  int bits, ch, i, j, len, mask;
+  char *lzbuffer;
+//  printf(" UnShrinking: %s ",filena);
+  putbytes = 0;
+
+  lzbuffer = (char *)malloc(N);
+  if (lzbuffer == nullptr) {
+    quit("compress.cpp: unable to decompress: insufficient memory");
+  }
+  i = N - F;
+
+  // this end condition just checks for EOF, which is no good to us
+  while ((bits = lzw_in->ReadByte()) != -1) {
+    for (mask = 0x01; mask & 0xFF; mask <<= 1) {
+      if (bits & mask) {
+        // MACPORT FIX: read to short and expand
+        short jshort = 0;
+        jshort = lzw_in->ReadInt16();
+        j = jshort;
+
+        len = ((j >> 12) & 15) + 3;
+        j = (i - j - 1) & (N - 1);
+
+        while (len--) {
+          myputc(lzbuffer[i] = lzbuffer[j], out);
+          j = (j + 1) & (N - 1);
+          i = (i + 1) & (N - 1);
+        }
+      } else {
+        ch = lzw_in->ReadByte();
+        myputc(lzbuffer[i] = ch, out);
+        i = (i + 1) & (N - 1);
+      }
+
+      if ((putbytes >= maxsize) && (maxsize > 0))
+        break;
+
+      if ((lzw_in->EOS()) && (maxsize > 0))
+        quit("Read error decompressing image - file is corrupt");
+    }                           // end for mask
+
+    if ((putbytes >= maxsize) && (maxsize > 0))
+      break;
+  }
+
+  free(lzbuffer);
+  expand_to_mem = 0;
+}
+
+unsigned char *lzwexpand_to_mem(Stream *in)
+{
+  unsigned char *membuff = (unsigned char *)malloc(maxsize + 10);
+  expand_to_mem = 1;
+  membfptr = membuff;
+  lzwexpand(in, nullptr);
+  return membuff;
+}
+
+#undef N
+#undef F
+
+} // namespace BaselineLzw
+
+// Packed block stored in the file, in the format read by read_lzw:
+// the palette, unpacked size, packed size, then the packed data
+struct LzwBlock
+{
+    String Name;
+    String FileName;
+    soff_t Offset;
+    // the original data, if known; otherwise the decoders are only
+    // compared with each other
+    std::vector<uint8_t> Data;
+};
+
+// Watches the room being read and remembers where it reads the LZW blocks,
+// by the same sequence of reads as read_lzw makes
+class LzwBlockFinder : public ProxyStream
+{
+public:
+    LzwBlockFinder(Stream *stream)
+        : ProxyStream(stream)
+    {
+    }
+
+    size_t Read(void *buffer, size_t size) override
+    {
+        const soff_t pos = GetPosition();
+        const size_t read = ProxyStream::Read(buffer, size);
+        if (size == sizeof(color) * 256)
+        {
+            _blockStart = pos;
+            _step = 1;
+        }
+        else if ((_step == 3) && (size == _packedSize))
+        {
+            Blocks.push_back(_blockStart);
+            _step = 0;
+        }
+        else
+        {
+            _step = 0;
+        }
+        return read;
+    }
+
+    int32_t ReadInt32() override
+    {
+        const int32_t val = ProxyStream::ReadInt32();
+        if (_step == 1 || _step == 2)
+        {
+            _packedSize = (uint32_t)val;
+            _step++;
+        }
+        else
+        {
+            _step = 0;
+        }
+        return val;
+    }
+
+    std::vector<soff_t> Blocks;
+
+private:
+    soff_t _blockStart = 0;
+    size_t _packedSize = 0;
+    int    _step = 0;
+};
+
+static void AddRoomBlocks(const AssetLocation &loc, std::vector<LzwBlock> &blocks)
+{
+    Stream *file = File::OpenFile(loc.FileName, kFile_Open, kFile_Read);
+    if (!file)
+        return;
+    file->Seek(loc.Offset, kSeekBegin);
+    LzwBlockFinder in(file);
+    RoomStruct room;
+    room.InitDefaults();
+    RoomFileVersion data_ver = (RoomFileVersion)in.ReadInt16();
+    HRoomFileError err = ReadRoomData(&room, &in, data_ver, false);
+    delete file;
+    if (!err)
+    {
+        printf("Cannot read %s: %s\n", loc.FileName.GetCStr(), err->FullMessage().GetCStr());
+        return;
+    }
+    for (size_t i = 0; i < in.Blocks.size(); ++i)
+    {
+        LzwBlock block;
+        block.Name.Format("%s:%d", loc.FileName.GetCStr(), (int)i);
+        block.FileName = loc.FileName;
+        block.Offset = in.Blocks[i];
+        blocks.push_back(block);
+    }
+}
+
+// Flat areas with soft gradients and some noise, like drawn backgrounds;
+// written to the file the way save_lzw does: line length, height, pixels
+static void AddTestBlocks(const String &file_name, std::vector<LzwBlock> &blocks)
+{
+    const int bpps[] = { 1, 2, 4 };
+    Stream *out = File::OpenFile(file_name, kFile_CreateAlways, kFile_Write);
+    srand(1);
+    for (int bpp : bpps)
+    {
+        const int line_len = 640 * bpp, height = 400;
+        std::vector<uint8_t> data(8 + (size_t)line_len * height);
+        memcpy(&data[0], &line_len, 4);
+        memcpy(&data[4], &height, 4);
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < line_len; ++x)
+            {
+                uint8_t c = (uint8_t)(((x / bpp) / 40 + y / 25) * (x % bpp + 1));
+                if (rand() % 16 == 0)
+                    c += (uint8_t)(rand() % 4);
+                data[8 + (size_t)y * line_len + x] = c;
+            }
+        }
+        std::vector<uint8_t> packed = PackLzw(data);
+        LzwBlock block;
+        block.Name.Format("test picture %d bpp", bpp * 8);
+        block.FileName = file_name;
+        block.Offset = out->GetPosition();
+        block.Data = data;
+        color pal[256] = {};
+        out->Write(pal, sizeof(pal));
+        out->WriteInt32((int32_t)data.size());
+        out->WriteInt32((int32_t)packed.size());
+        out->Write(packed.data(), packed.size());
+        blocks.push_back(block);
+    }
+    delete out;
+}
+
+// Reads the block header and unpacks the rest with the original decoder,
+// the way load_lzw did
+static bool UnpackBaseline(Stream *in, std::vector<uint8_t> &out)
+{
+    color pal[256];
+    in->Read(pal, sizeof(pal));
+    BaselineLzw::maxsize = in->ReadInt32();
+    in->ReadInt32();
+    BaselineLzw::outbytes = 0; BaselineLzw::putbytes = 0;
+    if (BaselineLzw::maxsize <= 0)
+        return false;
+    unsigned char *membuffer = BaselineLzw::lzwexpand_to_mem(in);
+    out.assign(membuffer, membuffer + BaselineLzw::maxsize);
+    free(membuffer);
+    return true;
+}
+
+// Reads the whole block and unpacks it with the current decoder
+static bool UnpackCurrent(Stream *in, std::vector<uint8_t> &out)
+{
+    color pal[256];
+    std::vector<uint8_t> packed;
+    size_t unpacked_size;
+    read_lzw(in, pal, packed, unpacked_size);
+    return unpack_lzw(packed, unpacked_size, out);
+}
+
+typedef bool (*UnpackFn)(Stream *in, std::vector<uint8_t> &out);
+
+// Unpacks the block the given number of times, measuring the time spent;
+// returns false if the block could not be read or unpacked
+static bool RunDecoder(UnpackFn fn, const LzwBlock &block, int runs, std::vector<uint8_t> &out, double &sec)
+{
+    Stream *in = File::OpenFile(block.FileName, kFile_Open, kFile_Read);
+    if (!in)
+        return false;
+    bool result = true;
+    const auto t0 = std::chrono::high_resolution_clock::now();
+    for (int run = 0; run < runs && result; ++run)
+    {
+        in->Seek(block.Offset, kSeekBegin);
+        result = fn(in, out);
+    }
+    sec = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+    delete in;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = 20;
+    std::vector<String> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc))
+            runs = atoi(argv[++i]);
+        else
+            inputs.push_back(argv[i]);
+    }
+    if (runs <= 0)
+    {
+        printf("Usage: %s [-r runs] [room file | game data file]...\n", argv[0]);
+        return 1;
+    }
+
+    install_allegro(SYSTEM_NONE, &errno, atexit);
+    AssetManager::CreateInstance();
+
+    const String test_file = "lzw_bench.tmp";
+    std::vector<LzwBlock> blocks;
+    for (const String &input : inputs)
+    {
+        if (AssetManager::IsDataFile(input))
+        {
+            AssetManager::SetDataFile(input);
+            AssetManager::SetSearchPriority(kAssetPriorityLib);
+            for (int i = 0; i < AssetManager::GetAssetCount(); ++i)
+            {
+                String name = AssetManager::GetAssetFileByIndex(i);
+                AssetLocation loc;
+                if ((name.CompareLeftNoCase("room") == 0) && (name.CompareRightNoCase(".crm") == 0) &&
+                    AssetManager::GetAssetLocation(name, loc))
+                    AddRoomBlocks(loc, blocks);
+            }
+        }
+        else
+        {
+            AssetLocation loc;
+            loc.FileName = input;
+            loc.Offset = 0;
+            loc.Size = File::GetFileSize(input);
+            AddRoomBlocks(loc, blocks);
+        }
+    }
+    if (inputs.empty())
+        AddTestBlocks(test_file, blocks);
+
+    printf("%d blocks, %d runs\n\n", (int)blocks.size(), runs);
+    printf("%-40s %10s %12s %12s\n", "block", "size KB", "old MB/s", "new MB/s");
+    size_t total_size = 0;
+    double old_sec = 0.0, new_sec = 0.0;
+    int mismatches = 0;
+    for (const LzwBlock &block : blocks)
+    {
+        std::vector<uint8_t> old_out, new_out;
+        double block_old_sec = 0.0, block_new_sec = 0.0;
+        if (!RunDecoder(UnpackBaseline, block, runs, old_out, block_old_sec) ||
+            !RunDecoder(UnpackCurrent, block, runs, new_out, block_new_sec) ||
+            (new_out != old_out) || (!block.Data.empty() && (new_out != block.Data)))
+        {
+            printf("%-40s MISMATCH\n", block.Name.GetCStr());
+            mismatches++;
+            continue;
+        }
+        const double mb = (double)new_out.size() * runs / (1024.0 * 1024.0);
+        printf("%-40s %10u %12.1f %12.1f\n", block.Name.GetCStr(), (unsigned)(new_out.size() / 1024),
+            mb / block_old_sec, mb / block_new_sec);
+        total_size += new_out.size();
+        old_sec += block_old_sec;
+        new_sec += block_new_sec;
+    }
+    if (total_size > 0)
+    {
+        const double total_mb = (double)total_size * runs / (1024.0 * 1024.0);
+        printf("\n%-40s %10u %12.1f %12.1f\n", "total", (unsigned)(total_size / 1024),
+            total_mb / old_sec, total_mb / new_sec);
+    }
+    if (mismatches > 0)
+        printf("\n%d block(s) unpacked differently by the two decoders\n", mismatches);
+
+    if (inputs.empty())
+        File::DeleteFile(test_file);
+    AssetManager::DestroyInstance();
+    return mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Packs the data in memory with lzwcompress, which only works on the files,
+// for the tests and benchmarks.
+//
+//=============================================================================
+#ifndef __AGS_EE_TEST__LZWPACK_H
+#define __AGS_EE_TEST__LZWPACK_H
+
+#include <vector>
+#include "util/file.h"
+#include "util/lzw.h"
+#include "util/stream.h"
+
+inline std::vector<uint8_t> PackLzw(const std::vector<uint8_t> &data)
+{
+    using namespace AGS::Common;
+    Stream *out = File::OpenFile("lzw_pack.tmp", kFile_CreateAlways, kFile_Write);
+    out->Write(data.data(), data.size());
+    delete out;
+    Stream *in = File::OpenFile("lzw_pack.tmp", kFile_Open, kFile_Read);
+    out = File::OpenFile("lzw_pack2.tmp", kFile_CreateAlways, kFile_Write);
+    lzwcompress(in, out);
+    delete in;
+    delete out;
+    in = File::OpenFile("lzw_pack2.tmp", kFile_Open, kFile_Read);
+    std::vector<uint8_t> packed((size_t)in->GetLength());
+    in->Read(packed.data(), packed.size());
+    delete in;
+    File::DeleteFile("lzw_pack.tmp");
+    File::DeleteFile("lzw_pack2.tmp");
+    return packed;
+}
+
+#endif // __AGS_EE_TEST__LZWPACK_H
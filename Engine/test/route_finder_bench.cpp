@@ -0,0 +1,397 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Path finder benchmark: loads walkable masks from the room files and runs
+// both path finders over the same set of queries, reporting time, expanded
+// nodes and path lengths, and how often the finders agree.
+//
+// Usage: route_finder_bench [-n queries] [-s seed] <room file | game data file>...
+// When given a game data file, all the rooms packed inside are tested.
+//
+//=============================================================================
+#include <allegro.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "ac/gamestructdefines.h"
+#include "ac/movelist.h"
+#include "ac/route_finder_impl.h"
+#include "ac/route_finder_impl_legacy.h"
+#include "core/assetmanager.h"
+#include "game/room_file.h"
+#include "game/roomstruct.h"
+#include "gfx/bitmap.h"
+
+using namespace AGS::Common;
+using namespace AGS::Engine;
+
+extern MoveList *mls;
+
+enum QueryKind
+{
+    kQuery_Random,  // between two random walkable points
+    kQuery_ToWall,  // to a non-walkable point, as when clicking on scenery
+    kQuery_Across,  // between the walkable points nearest to opposite corners
+    kNumQueryKinds
+};
+
+static const char *QueryKindNames[kNumQueryKinds] = { "random", "to wall", "across" };
+
+struct RouteQuery
+{
+    QueryKind Kind;
+    short SrcX, SrcY;
+    short DestX, DestY;
+};
+
+struct RouteOutcome
+{
+    bool    Found;
+    int     EndX, EndY;
+    double  Length;
+};
+
+struct FinderStats
+{
+    int      Queries = 0;
+    int      Found = 0;
+    int      Reached = 0;
+    double   TotalUs = 0.0;
+    double   MaxUs = 0.0;
+    uint64_t Nodes = 0;
+    double   Length = 0.0;
+};
+
+struct PathFinder
+{
+    const char *Name;
+    void (*Init)();
+    void (*Shutdown)();
+    void (*SetMoveSpeed)(int, int);
+    int (*FindRoute)(short, short, short, short, Bitmap*, int, int, int);
+    uint32_t (*TakeExpandedNodes)();
+    FinderStats Stats[kNumQueryKinds];
+};
+
+static PathFinder Finders[] =
+{
+    { "jps", RouteFinder::init_pathfinder, RouteFinder::shutdown_pathfinder,
+      RouteFinder::set_route_move_speed, RouteFinder::find_route, RouteFinder::take_expanded_nodes, {} },
+    { "legacy", RouteFinderLegacy::init_pathfinder, RouteFinderLegacy::shutdown_pathfinder,
+      RouteFinderLegacy::set_route_move_speed, RouteFinderLegacy::find_route, RouteFinderLegacy::take_expanded_nodes, {} },
+};
+static const int NumFinders = sizeof(Finders) / sizeof(Finders[0]);
+
+// Agreement between the finders, per query kind
+struct MatchStats
+{
+    int     Queries = 0;
+    int     SameResult = 0;   // both found or failed, and ended at the same point
+    int     BothReached = 0;
+    double  LengthRatio = 0.0; // sum of jps / legacy path lengths
+    double  WorstRatio = 0.0;
+};
+
+static MatchStats Match[kNumQueryKinds];
+
+// Simple LCG, so that query sets are the same on every platform
+static uint32_t RandState = 1;
+static int Rand(int max)
+{
+    RandState = RandState * 1103515245u + 12345u;
+    return max > 0 ? (int)((RandState >> 8) % (uint32_t)max) : 0;
+}
+
+static bool RandomPoint(Bitmap *mask, bool walkable, int &x, int &y)
+{
+    for (int tries = 0; tries < 10000; ++tries)
+    {
+        x = Rand(mask->GetWidth());
+        y = Rand(mask->GetHeight());
+        if ((mask->GetScanLine(y)[x] != 0) == walkable)
+            return true;
+    }
+    return false;
+}
+
+static bool NearestWalkable(Bitmap *mask, int cx, int cy, int &x, int &y)
+{
+    int best = -1;
+    for (int py = 0; py < mask->GetHeight(); ++py)
+    {
+        const uint8_t *line = mask->GetScanLine(py);
+        for (int px = 0; px < mask->GetWidth(); ++px)
+        {
+            if (line[px] == 0)
+                continue;
+            const int dist = (px - cx) * (px - cx) + (py - cy) * (py - cy);
+            if ((best < 0) || (dist < best))
+            {
+                best = dist;
+                x = px;
+                y = py;
+            }
+        }
+    }
+    return best >= 0;
+}
+
+static void MakeQueries(Bitmap *mask, int count, std::vector<RouteQuery> &queries)
+{
+    queries.clear();
+    const int w = mask->GetWidth(), h = mask->GetHeight();
+    int sx, sy, dx, dy;
+    for (int i = 0; i < count; ++i)
+    {
+        RouteQuery q;
+        q.Kind = (QueryKind)(i % kNumQueryKinds);
+        switch (q.Kind)
+        {
+        case kQuery_Random:
+            if (!RandomPoint(mask, true, sx, sy) || !RandomPoint(mask, true, dx, dy))
+                continue;
+            break;
+        case kQuery_ToWall:
+            if (!RandomPoint(mask, true, sx, sy) || !RandomPoint(mask, false, dx, dy))
+                continue;
+            break;
+        case kQuery_Across:
+            {
+                // pick one of the corner pairs, with a little jitter
+                const int corner = Rand(4);
+                const int cx = (corner & 1) ? w - 1 : 0, cy = (corner & 2) ? h - 1 : 0;
+                if (!NearestWalkable(mask, cx + Rand(w / 8 + 1) * ((corner & 1) ? -1 : 1),
+                        cy + Rand(h / 8 + 1) * ((corner & 2) ? -1 : 1), sx, sy) ||
+                    !NearestWalkable(mask, w - 1 - cx, h - 1 - cy, dx, dy))
+                    continue;
+            }
+            break;
+        default:
+            continue;
+        }
+        q.SrcX = sx; q.SrcY = sy;
+        q.DestX = dx; q.DestY = dy;
+        queries.push_back(q);
+    }
+}
+
+static RouteOutcome GetOutcome(int movlst, const RouteQuery &q)
+{
+    RouteOutcome out;
+    out.Found = movlst != 0;
+    out.EndX = q.SrcX;
+    out.EndY = q.SrcY;
+    out.Length = 0.0;
+    if (!out.Found)
+        return out;
+    const MoveList &ml = mls[movlst];
+    int lastx = (ml.pos[0] >> 16) & 0xffff, lasty = ml.pos[0] & 0xffff;
+    for (int i = 1; i < ml.numstage; ++i)
+    {
+        const int x = (ml.pos[i] >> 16) & 0xffff, y = ml.pos[i] & 0xffff;
+        out.Length += sqrt((double)((x - lastx) * (x - lastx) + (y - lasty) * (y - lasty)));
+        lastx = x;
+        lasty = y;
+    }
+    out.EndX = lastx;
+    out.EndY = lasty;
+    return out;
+}
+
+static void RunQueries(Bitmap *mask, const std::vector<RouteQuery> &queries)
+{
+    const int movlst = 1;
+    std::vector<RouteOutcome> outcomes(queries.size() * NumFinders);
+    for (int f = 0; f < NumFinders; ++f)
+    {
+        PathFinder &pf = Finders[f];
+        pf.Init();
+        if (f == 0)
+            RouteFinder::set_walkmask(mask);
+        pf.SetMoveSpeed(1, 1);
+        pf.TakeExpandedNodes();
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            const RouteQuery &q = queries[i];
+            const auto start = std::chrono::steady_clock::now();
+            const int res = pf.FindRoute(q.SrcX, q.SrcY, q.DestX, q.DestY, mask, movlst, 0, 0);
+            const double us = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count();
+            const RouteOutcome out = GetOutcome(res, q);
+            outcomes[i * NumFinders + f] = out;
+
+            FinderStats &st = pf.Stats[q.Kind];
+            st.Queries++;
+            st.TotalUs += us;
+            if (us > st.MaxUs)
+                st.MaxUs = us;
+            st.Nodes += pf.TakeExpandedNodes();
+            if (out.Found)
+            {
+                st.Found++;
+                st.Length += out.Length;
+                if ((out.EndX == q.DestX) && (out.EndY == q.DestY))
+                    st.Reached++;
+            }
+        }
+        if (f == 0)
+            RouteFinder::set_walkmask(nullptr);
+        pf.Shutdown();
+    }
+
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        const RouteQuery &q = queries[i];
+        const RouteOutcome &a = outcomes[i * NumFinders];
+        const RouteOutcome &b = outcomes[i * NumFinders + 1];
+        MatchStats &m = Match[q.Kind];
+        m.Queries++;
+        if ((a.Found == b.Found) && (a.EndX == b.EndX) && (a.EndY == b.EndY))
+            m.SameResult++;
+        const bool a_reached = a.Found && (a.EndX == q.DestX) && (a.EndY == q.DestY);
+        const bool b_reached = b.Found && (b.EndX == q.DestX) && (b.EndY == q.DestY);
+        if (a_reached && b_reached && (b.Length > 0.0))
+        {
+            const double ratio = a.Length / b.Length;
+            m.BothReached++;
+            m.LengthRatio += ratio;
+            if (ratio > m.WorstRatio)
+                m.WorstRatio = ratio;
+        }
+    }
+}
+
+static bool LoadRoomMask(const String &filename, RoomStruct &room)
+{
+    room.Free();
+    room.InitDefaults();
+    RoomDataSource src;
+    HRoomFileError err = OpenRoomFile(filename, src);
+    if (err)
+    {
+        err = ReadRoomData(&room, src.InputStream.get(), src.DataVersion);
+        if (err)
+            err = UpdateRoomData(&room, src.DataVersion, false, std::vector<SpriteInfo>());
+    }
+    if (!err)
+    {
+        printf("%s: unable to load room: %s\n", filename.GetCStr(), err->FullMessage().GetCStr());
+        return false;
+    }
+    if (!room.WalkAreaMask || room.WalkAreaMask->GetColorDepth() != 8)
+    {
+        printf("%s: no 8-bit walkable mask\n", filename.GetCStr());
+        return false;
+    }
+    return true;
+}
+
+static void PrintReport()
+{
+    printf("\n%-8s %-8s %8s %8s %8s %10s %10s %12s %10s\n",
+        "finder", "queries", "count", "found", "reached", "avg us", "max us", "avg nodes", "avg len");
+    for (int f = 0; f < NumFinders; ++f)
+    {
+        for (int k = 0; k < kNumQueryKinds; ++k)
+        {
+            const FinderStats &st = Finders[f].Stats[k];
+            if (st.Queries == 0)
+                continue;
+            printf("%-8s %-8s %8d %8d %8d %10.1f %10.1f %12.1f %10.1f\n",
+                Finders[f].Name, QueryKindNames[k], st.Queries, st.Found, st.Reached,
+                st.TotalUs / st.Queries, st.MaxUs, (double)st.Nodes / st.Queries,
+                st.Found > 0 ? st.Length / st.Found : 0.0);
+        }
+    }
+
+    printf("\n%-8s %8s %10s %12s %14s %14s\n",
+        "queries", "count", "match %", "both reach", "avg len ratio", "worst ratio");
+    for (int k = 0; k < kNumQueryKinds; ++k)
+    {
+        const MatchStats &m = Match[k];
+        if (m.Queries == 0)
+            continue;
+        printf("%-8s %8d %10.1f %12d %14.3f %14.3f\n",
+            QueryKindNames[k], m.Queries, 100.0 * m.SameResult / m.Queries, m.BothReached,
+            m.BothReached > 0 ? m.LengthRatio / m.BothReached : 0.0, m.WorstRatio);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_queries = 300;
+    std::vector<String> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+            num_queries = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+            RandState = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else
+            inputs.push_back(argv[i]);
+    }
+    if (inputs.empty())
+    {
+        printf("Usage: %s [-n queries] [-s seed] <room file | game data file>...\n", argv[0]);
+        return 1;
+    }
+
+    install_allegro(SYSTEM_NONE, &errno, atexit);
+    AssetManager::CreateInstance();
+    mls = (MoveList*)calloc(2, sizeof(MoveList));
+
+    RoomStruct room;
+    std::vector<RouteQuery> queries;
+    for (const String &input : inputs)
+    {
+        std::vector<String> rooms;
+        if (AssetManager::IsDataFile(input))
+        {
+            AssetManager::SetDataFile(input);
+            AssetManager::SetSearchPriority(kAssetPriorityLib);
+            for (int i = 0; i < AssetManager::GetAssetCount(); ++i)
+            {
+                String name = AssetManager::GetAssetFileByIndex(i);
+                if ((name.CompareLeftNoCase("room") == 0) && (name.CompareRightNoCase(".crm") == 0))
+                    rooms.push_back(name);
+            }
+        }
+        else
+        {
+            AssetManager::SetSearchPriority(kAssetPriorityDir);
+            rooms.push_back(input);
+        }
+
+        for (const String &name : rooms)
+        {
+            if (!LoadRoomMask(name, room))
+                continue;
+            Bitmap *mask = room.WalkAreaMask.get();
+            MakeQueries(mask, num_queries, queries);
+            printf("%s: %dx%d mask, %d queries\n", name.GetCStr(),
+                mask->GetWidth(), mask->GetHeight(), (int)queries.size());
+            RunQueries(mask, queries);
+        }
+    }
+
+    PrintReport();
+    room.Free();
+    free(mls);
+    AssetManager::DestroyInstance();
+    return 0;
+}
@@ -21,11 +21,14 @@ void Test_DoAllTests()
 {
     Test_Math();
     Test_Memory();
+    Test_SeqLock();
+    Test_SpscQueue();
     Test_Path();
     Test_ScriptSprintf();
     Test_String();
     Test_Version();
     Test_File();
+    Test_Compress();
     Test_IniFile();
 
     Test_Gfx();
@@ -20,11 +20,15 @@ void Test_DoAllTests();
 void Test_Math();
 // File tests
 void Test_File();
+void Test_Compress();
 void Test_IniFile();
 // Graphics tests
 void Test_Gfx();
 // Memory / bit-byte operations
 void Test_Memory();
+// Threading utilities
+void Test_SeqLock();
+void Test_SpscQueue();
 // String tests
 void Test_ScriptSprintf();
 void Test_String();
@@ -0,0 +1,79 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include "core/platform.h"
+#ifdef AGS_RUN_TESTS
+
+#include <string.h>
+#include <vector>
+#include "debug/assert.h"
+#include "util/compress.h"
+#include "util/file.h"
+#include "util/lzw.h"
+#include "util/stream.h"
+#include "test/lzw_pack.h"
+
+using namespace AGS::Common;
+
+void Test_Compress()
+{
+    //-----------------------------------------------------
+    // LZW
+    // literal, then a reference overlapping its own output
+    const uint8_t run_packed[] = { 0x02, 'x', 0x00, 0x20 };
+    uint8_t unpacked[16];
+    memset(unpacked, 0xAA, sizeof(unpacked));
+    assert(lzwexpand(run_packed, sizeof(run_packed), unpacked, sizeof(unpacked)) == 6);
+    assert(memcmp(unpacked, "xxxxxx", 6) == 0);
+    // reference before the start of data reads the zeroed window
+    const uint8_t zero_packed[] = { 0x01, 0xFF, 0x0F, 'a' };
+    assert(lzwexpand(zero_packed, sizeof(zero_packed), unpacked, sizeof(unpacked)) == 4);
+    assert(memcmp(unpacked, "\0\0\0a", 4) == 0);
+    // output is cut at the buffer size
+    assert(lzwexpand(run_packed, sizeof(run_packed), unpacked, 4) == 4);
+    // input is cut short
+    assert(lzwexpand(run_packed, 3, unpacked, sizeof(unpacked)) == 1);
+
+    // round trip, with both the bulk and the checked unpacking
+    std::vector<uint8_t> data(100000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = (uint8_t)((i % 640) / 16 + i / 6400 + ((i % 37 == 0) ? i % 11 : 0));
+    std::vector<uint8_t> packed = PackLzw(data);
+    assert(packed.size() < data.size());
+    std::vector<uint8_t> test(data.size() + 1, 0xAA);
+    assert(lzwexpand(packed.data(), packed.size(), test.data(), data.size()) == data.size());
+    assert(memcmp(test.data(), data.data(), data.size()) == 0);
+    assert(test[data.size()] == 0xAA);
+    assert(lzwexpand(packed.data(), packed.size() / 2, test.data(), data.size()) < data.size());
+
+    //-----------------------------------------------------
+    // RLE
+    std::vector<uint8_t> line(1000);
+    for (size_t i = 0; i < line.size(); ++i)
+        line[i] = (i % 300 < 150) ? 7 : (uint8_t)i;
+    Stream *out = File::OpenFile("test.tmp", kFile_CreateAlways, kFile_Write);
+    cpackbitl(line.data(), (int)line.size(), out);
+    cpackbitl(line.data(), (int)line.size(), out);
+    delete out;
+    Stream *in = File::OpenFile("test.tmp", kFile_Open, kFile_Read);
+    std::vector<uint8_t> test_line(line.size());
+    assert(cunpackbitl(test_line.data(), (int)test_line.size(), in) == 0);
+    assert(test_line == line);
+    // line shorter than the packed data fails
+    assert(cunpackbitl(test_line.data(), (int)test_line.size() - 10, in) == -1);
+    delete in;
+    File::DeleteFile("test.tmp");
+}
+
+#endif // AGS_RUN_TESTS
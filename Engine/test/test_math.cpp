@@ -16,6 +16,7 @@
 #ifdef AGS_RUN_TESTS
 
 #include "debug/assert.h"
+#include "util/geometry.h"
 #include "util/scaling.h"
 
 using namespace AGS::Common;
@@ -34,8 +35,56 @@ void Test_Scaling(int src, int dst)
     assert(x == src);
 }
 
+// Compares ring search against the plain column by column scan of the grid
+void Test_NearestGridPoint(const unsigned char *mask, int w, int h,
+    int x1, int y1, int x2, int y2, int step, int dest_x, int dest_y)
+{
+    auto test = [&](int x, int y) { return mask[y * w + x] != 0; };
+    int nearest = 99999, near_x = 0, near_y = 0;
+    for (int x = x1; x < x2; x += step)
+    {
+        for (int y = y1; y < y2; y += step)
+        {
+            if (!test(x, y)) continue;
+            int dist = (int)sqrt((double)((x - dest_x) * (x - dest_x) + (y - dest_y) * (y - dest_y)));
+            if (dist < nearest) { nearest = dist; near_x = x; near_y = y; }
+        }
+    }
+    int found_x, found_y;
+    bool found = FindNearestGridPoint(x1, y1, x2, y2, step, dest_x, dest_y, test, found_x, found_y);
+    assert(found == (nearest < 99999));
+    if (found)
+    {
+        assert(found_x == near_x);
+        assert(found_y == near_y);
+    }
+}
+
 void Test_Math()
 {
+    {
+        const int w = 97, h = 61;
+        unsigned char mask[w * h] = {};
+        unsigned seed = 1;
+        for (int i = 0; i < 40; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            mask[(seed >> 8) % (w * h)] = 1;
+        }
+        for (int step = 1; step <= 5; ++step)
+        {
+            for (int y = -10; y < h + 10; y += 7)
+            {
+                for (int x = -10; x < w + 10; x += 3)
+                {
+                    Test_NearestGridPoint(mask, w, h, 0, 0, w, h, step, x, y);
+                    Test_NearestGridPoint(mask, w, h, 4, 10, w - 3, h - 1, step, x, y);
+                }
+            }
+        }
+    }
+
+
     {
         Test_Scaling(100, 100);
 
@@ -0,0 +1,73 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include "core/platform.h"
+#ifdef AGS_RUN_TESTS
+
+#include <atomic>
+#include <thread>
+#include "util/seqlock.h"
+#include "debug/assert.h"
+
+using namespace AGS::Engine;
+
+struct TestSnapshot
+{
+    int A;
+    int B;
+    bool C;
+    int64_t D;
+};
+
+void Test_SeqLock()
+{
+    // Default value is zeroed, stored value is read back whole
+    {
+        SeqLockValue<TestSnapshot> value;
+        TestSnapshot snap = value.Load();
+        assert(snap.A == 0 && snap.B == 0 && !snap.C && snap.D == 0);
+        TestSnapshot stored = { 1, -2, true, 1LL << 40 };
+        value.Store(stored);
+        snap = value.Load();
+        assert(snap.A == 1 && snap.B == -2 && snap.C && snap.D == (1LL << 40));
+    }
+
+    // Reader never gets the fields from different writes
+    {
+        const int count = 100000;
+        SeqLockValue<TestSnapshot> value;
+        std::atomic<bool> done(false);
+        std::thread writer([&value, &done]()
+        {
+            for (int i = 1; i <= count; ++i)
+            {
+                TestSnapshot snap = { i, -i, (i % 2) != 0, (int64_t)i * 3 };
+                value.Store(snap);
+            }
+            done = true;
+        });
+        int last = 0;
+        while (!done)
+        {
+            TestSnapshot snap = value.Load();
+            assert(snap.B == -snap.A && snap.C == ((snap.A % 2) != 0) && snap.D == (int64_t)snap.A * 3);
+            assert(snap.A >= last);
+            last = snap.A;
+        }
+        writer.join();
+        assert(value.Load().A == count);
+    }
+}
+
+#endif // AGS_RUN_TESTS
@@ -0,0 +1,96 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include "core/platform.h"
+#ifdef AGS_RUN_TESTS
+
+#include <thread>
+#include "util/spsc_queue.h"
+#include "debug/assert.h"
+
+using namespace AGS::Engine;
+
+void Test_SpscQueue()
+{
+    // Capacity is rounded up
+    {
+        SpscQueue<int> q(5);
+        assert(q.GetCapacity() == 8);
+        assert(q.IsEmpty());
+    }
+
+    // Items are popped in the order they were pushed, across the wrap
+    {
+        SpscQueue<int> q(4);
+        int item = -1;
+        assert(!q.Pop(item));
+        for (int round = 0; round < 3; ++round)
+        {
+            for (int i = 0; i < 3; ++i)
+                assert(q.Push(round * 10 + i));
+            for (int i = 0; i < 3; ++i)
+            {
+                assert(q.Pop(item));
+                assert(item == round * 10 + i);
+            }
+            assert(q.IsEmpty());
+        }
+    }
+
+    // Full queue refuses the items until one is popped
+    {
+        SpscQueue<int> q(4);
+        int item = -1;
+        for (int i = 0; i < 4; ++i)
+            assert(q.Push(i));
+        assert(!q.Push(4));
+        assert(q.Pop(item) && item == 0);
+        assert(q.Push(4));
+        for (int i = 1; i <= 4; ++i)
+            assert(q.Pop(item) && item == i);
+        assert(!q.Pop(item));
+    }
+
+    // Items passed from one thread to another arrive all and in order
+    {
+        const int count = 100000;
+        SpscQueue<int> q(16);
+        std::thread producer([&q]()
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                while (!q.Push(i))
+                    std::this_thread::yield();
+            }
+        });
+        int expect = 0;
+        while (expect < count)
+        {
+            int item;
+            if (q.Pop(item))
+            {
+                assert(item == expect);
+                expect++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        assert(q.IsEmpty());
+    }
+}
+
+#endif // AGS_RUN_TESTS
@@ -0,0 +1,87 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Value which one thread publishes for the others to read without locking:
+// the readers always get the whole value stored by one write, retrying if
+// it was changed while they were reading it. Only one thread may store the
+// value at a time. The value type must be trivially copyable.
+//
+//=============================================================================
+#ifndef __AGS_EE_UTIL__SEQLOCK_H
+#define __AGS_EE_UTIL__SEQLOCK_H
+
+#include <atomic>
+#include <string.h>
+#include "core/types.h"
+
+namespace AGS
+{
+namespace Engine
+{
+
+template <typename T>
+class SeqLockValue
+{
+public:
+    SeqLockValue()
+        : _seq(0)
+    {
+        Store(T());
+    }
+
+    SeqLockValue(const SeqLockValue &) = delete;
+    SeqLockValue &operator=(const SeqLockValue &) = delete;
+
+    void Store(const T &value)
+    {
+        uint32_t words[WordCount] = {};
+        memcpy(words, &value, sizeof(T));
+        // odd sequence number tells that the value is being changed
+        const uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WordCount; ++i)
+            _words[i].store(words[i], std::memory_order_relaxed);
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    T Load() const
+    {
+        uint32_t words[WordCount];
+        uint32_t seq_before, seq_after;
+        do
+        {
+            seq_before = _seq.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WordCount; ++i)
+                words[i] = _words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seq_after = _seq.load(std::memory_order_relaxed);
+        }
+        while ((seq_before & 1) != 0 || seq_before != seq_after);
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static const size_t WordCount = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> _seq;
+    std::atomic<uint32_t> _words[WordCount];
+};
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_UTIL__SEQLOCK_H
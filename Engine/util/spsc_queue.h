@@ -0,0 +1,90 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Lock-free queue of a fixed capacity, for passing items from one thread to
+// another: only one thread may push to it, and only one may pop from it.
+//
+//=============================================================================
+#ifndef __AGS_EE_UTIL__SPSC_QUEUE_H
+#define __AGS_EE_UTIL__SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+
+namespace AGS
+{
+namespace Engine
+{
+
+template <typename T>
+class SpscQueue
+{
+public:
+    // Capacity is rounded up to the power of two
+    explicit SpscQueue(size_t capacity)
+        : _head(0)
+        , _tail(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        _items.resize(size);
+        _mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    size_t GetCapacity() const { return _items.size(); }
+
+    // Called by the producer; returns false if the queue is full
+    bool Push(const T &item)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == _items.size())
+            return false;
+        _items[tail & _mask] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Called by the consumer; returns false if the queue is empty
+    bool Pop(T &item)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire))
+            return false;
+        item = _items[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // May be called by either thread; the result may be outdated at once
+    bool IsEmpty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> _items;
+    size_t _mask;
+    // positions only grow, and wrap around on overflow together
+    std::atomic<size_t> _head; // next item to pop
+    std::atomic<size_t> _tail; // next place to push to
+};
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_UTIL__SPSC_QUEUE_H